@@ -5,6 +5,14 @@
 # Lesser General Public License. See top-level LICENSE file for details.
 # ***********************************************************************
 
+import copy
+import functools
+import inspect
+import itertools
+import os
+import pickle
+import re
+import tempfile
 from importlib import import_module
 
 import sympy as sp
@@ -155,13 +163,265 @@ def _sympify_eqs(eq_strings, state_vars, vars):
     return eqs, sympy_state_vars, sympy_vars
 
 
-def solve_lin_system(eq_strings, vars, constants, function_calls, small_system=False, do_cse=False):
+# version of the memo cache format, bump if solver output changes
+_MEMO_CACHE_VERSION = 1
+
+# solutions memoized by _memoize, shared by all blocks and mod files
+_memo_cache = {}
+
+_identifier = re.compile(r"[A-Za-z_][A-Za-z0-9_]*")
+
+
+def _canonical_eqs(eq_strings):
+    """Return equations with all whitespace removed"""
+    return tuple("".join(eq.split()) for eq in eq_strings)
+
+
+def _used_names(names, eq_strings):
+    """Return sorted names (arrays as "name[N]") whose name appears in any of eq_strings
+
+    Names that do not appear in the equations do not affect the solution,
+    dropping them lets identical equations from different blocks or mod
+    files (with different sets of variables in scope) share a cache entry.
+    """
+    identifiers = set()
+    for eq in eq_strings:
+        identifiers.update(_identifier.findall(eq))
+    return tuple(sorted(n for n in names if n.split("[", 1)[0].strip() in identifiers))
+
+
+def _memoize(make_key):
+    """Memoize solver function using the key returned by make_key
+
+    make_key is called with all arguments of the decorated function by name
+    (including default values) and should return a tuple that canonically
+    represents the inputs. Exceptions are memoized as well so that equations
+    which are too hard to solve are not retried.
+    """
+
+    def decorator(func):
+        signature = inspect.signature(func)
+
+        @functools.wraps(func)
+        def wrapper(*args, **kwargs):
+            arguments = signature.bind(*args, **kwargs)
+            arguments.apply_defaults()
+            key = (func.__name__,) + make_key(**arguments.arguments)
+            if key not in _memo_cache:
+                try:
+                    _memo_cache[key] = (True, func(*args, **kwargs))
+                except Exception as e:
+                    _memo_cache[key] = (False, e)
+            success, result = _memo_cache[key]
+            if not success:
+                raise copy.copy(result)
+            return copy.deepcopy(result)
+
+        return wrapper
+
+    return decorator
+
+
+def clear_memo_cache():
+    """Remove all memoized solutions"""
+    _memo_cache.clear()
+
+
+def load_memo_cache(filename):
+    """Add solutions memoized in filename by save_memo_cache
+
+    Missing, unreadable or corrupted files and files written by a different
+    version of the cache or of SymPy are ignored.
+    """
+    try:
+        with open(filename, "rb") as f:
+            version, sympy_version, cache = pickle.load(f)
+        if version != _MEMO_CACHE_VERSION or sympy_version != sp.__version__:
+            return
+        cache = {key: value for key, value in cache.items() if value[0]}
+    except Exception:
+        return
+    _memo_cache.update(cache)
+
+
+def save_memo_cache(filename):
+    """Write memoized solutions to filename
+
+    Solutions already present in the file are preserved and the file is
+    replaced atomically, so that concurrent nmodl processes can share it.
+    Failures are only memoized for the current process as exceptions can
+    not always be pickled.
+    """
+    load_memo_cache(filename)
+    solutions = {key: value for key, value in _memo_cache.items() if value[0]}
+    directory = os.path.dirname(os.path.abspath(filename))
+    fd, tmp_filename = tempfile.mkstemp(dir=directory)
+    with os.fdopen(fd, "wb") as f:
+        pickle.dump((_MEMO_CACHE_VERSION, sp.__version__, solutions), f)
+    os.replace(tmp_filename, filename)
+
+
+def _static_pivot_order(pattern, n):
+    """Choose pivots for gaussian elimination from the structure of a matrix
+
+    Diagonal pivots are preferred, then pivots with minimal Markowitz cost
+    (row count - 1) * (column count - 1), i.e. minimal fill-in.
+
+    Args:
+        pattern: set of (row, column) of structurally non-zero entries
+        n: size of the matrix
+
+    Returns:
+        list of (row, column) pivots in elimination order
+    """
+    pattern = set(pattern)
+    rows, cols = set(range(n)), set(range(n))
+    pivots = []
+    for _ in range(n):
+        active = [(i, j) for (i, j) in pattern if i in rows and j in cols]
+        if not active:
+            raise ValueError("Linear system is structurally singular")
+        row_count = {i: 0 for i in rows}
+        col_count = {j: 0 for j in cols}
+        for i, j in active:
+            row_count[i] += 1
+            col_count[j] += 1
+        r, c = min(
+            active,
+            key=lambda e: (e[0] != e[1], (row_count[e[0]] - 1) * (col_count[e[1]] - 1), e),
+        )
+        pivots.append((r, c))
+        rows.remove(r)
+        cols.remove(c)
+        # fill-in from eliminating column c with row r
+        for i, _c in active:
+            if _c == c and i != r:
+                for _r, j in active:
+                    if _r == r and j != c:
+                        pattern.add((i, j))
+    return pivots
+
+
+def _unrolled_gaussian_elimination(matJ, vecF, state_vars, names, custom_fcts, do_cse):
+    """Straight-line gaussian elimination code for J X = F with static pivot order
+
+    Every structurally non-zero entry of J and F is copied to a new local
+    variable, then the elimination is done in place on these variables,
+    skipping all operations on entries known to be zero.
+
+    Returns:
+        code: list of strings containing assignment statements
+        vars: list of strings containing new local variables
+    """
+    n = matJ.rows
+    pattern = {(i, j) for i in range(n) for j in range(n) if matJ[i, j] != 0}
+    pivots = _static_pivot_order(pattern, n)
+
+    code = []
+    new_local_vars = []
+    prefix = _make_unique_prefix(names, "elim")
+    counter = itertools.count()
+
+    def new_var():
+        var = f"{prefix}{next(counter)}"
+        new_local_vars.append(var)
+        return var
+
+    # copy of non-zero entries, optionally with common subexpressions
+    entries = sorted(pattern)
+    exprs = [matJ[i, j] for i, j in entries] + [vecF[i] for i in range(n) if vecF[i] != 0]
+    if do_cse:
+        cse_prefix = _make_unique_prefix(names + [prefix])
+        my_symbols = sp.utilities.iterables.numbered_symbols(prefix=cse_prefix)
+        sub_exprs, exprs = sp.cse(
+            exprs, symbols=my_symbols, optimizations="basic", order="canonical"
+        )
+        for var, expr in sub_exprs:
+            new_local_vars.append(sp.ccode(var))
+            code.append(f"{var} = {sp.ccode(expr.evalf(), user_functions=custom_fcts)}")
+    exprs = iter(exprs)
+    a = {}
+    for e in entries:
+        a[e] = new_var()
+        expr = next(exprs).simplify().evalf()
+        code.append(f"{a[e]} = {sp.ccode(expr, user_functions=custom_fcts)}")
+    b = {}
+    for i in range(n):
+        if vecF[i] != 0:
+            b[i] = new_var()
+            expr = next(exprs).simplify().evalf()
+            code.append(f"{b[i]} = {sp.ccode(expr, user_functions=custom_fcts)}")
+
+    # forward elimination: after each step the pivot row holds a row of U
+    # and the eliminated entries of the remaining rows hold the multipliers
+    rows, cols = set(range(n)), set(range(n))
+    for r, c in pivots:
+        rows.remove(r)
+        cols.remove(c)
+        pivot_row = [j for j in sorted(cols) if (r, j) in a]
+        for i in sorted(rows):
+            if (i, c) not in a:
+                continue
+            m = a[(i, c)]
+            code.append(f"{m} = {m}/{a[(r, c)]}")
+            for j in pivot_row:
+                if (i, j) in a:
+                    code.append(f"{a[(i, j)]} = {a[(i, j)]}-{m}*{a[(r, j)]}")
+                else:
+                    a[(i, j)] = new_var()
+                    code.append(f"{a[(i, j)]} = -{m}*{a[(r, j)]}")
+            if r in b:
+                if i in b:
+                    code.append(f"{b[i]} = {b[i]}-{m}*{b[r]}")
+                else:
+                    b[i] = new_var()
+                    code.append(f"{b[i]} = -{m}*{b[r]}")
+
+    # backward substitution directly into state variables
+    solved = []
+    for r, c in reversed(pivots):
+        terms = [f"-{a[(r, j)]}*{sp.ccode(state_vars[j])}" for j in solved if (r, j) in a]
+        rhs = (b[r] if r in b else "0") + "".join(terms)
+        code.append(f"{sp.ccode(state_vars[c])} = ({rhs})/{a[(r, c)]}")
+        solved.append(c)
+    return code, new_local_vars
+
+
+# names of temporaries of unrolled elimination avoid all constants, which are
+# hence part of the key even if not used by the equations
+@_memoize(
+    lambda eq_strings, vars, constants, function_calls, small_system, do_cse, unrolled_elimination: (
+        _canonical_eqs(eq_strings),
+        tuple(vars),
+        tuple(sorted(constants))
+        if unrolled_elimination and not small_system
+        else _used_names(constants, eq_strings),
+        _used_names(function_calls, eq_strings),
+        small_system,
+        do_cse,
+        unrolled_elimination,
+    )
+)
+def solve_lin_system(
+    eq_strings,
+    vars,
+    constants,
+    function_calls,
+    small_system=False,
+    do_cse=False,
+    unrolled_elimination=False,
+):
     """Solve linear system of equations, return solution as C code.
 
     If system is small (small_system=True, typically N<=3):
       - solve analytically by gaussian elimination
       - optionally do Common Subexpression Elimination if do_cse is true
 
+    If system is mid-sized and unrolled_elimination=True (typically N<=10):
+      - return straight-line gaussian elimination code with a pivot order
+        chosen from the structure of the system, skipping known zeros
+      - optionally do Common Subexpression Elimination if do_cse is true
+
     If system is large (default):
       - gaussian elimination may not be numerically stable at runtime
       - instead return a matrix J and vector F, where J X = F
@@ -175,6 +435,8 @@ def solve_lin_system(eq_strings, vars, constants, function_calls, small_system=F
         small_system: if True, solve analytically by gaussian elimination
                       otherwise return matrix system to be solved
         do_cse: if True, do Common Subexpression Elimination
+        unrolled_elimination: if True (and not small_system), return
+                      unrolled gaussian elimination code
 
     Returns:
         code: list of strings containing assignment statements
@@ -187,6 +449,11 @@ def solve_lin_system(eq_strings, vars, constants, function_calls, small_system=F
     code = []
     new_local_vars = []
 
+    if unrolled_elimination and not small_system:
+        matJ, vecF = sp.linear_eq_to_matrix(eqs, state_vars)
+        names = list(vars) + list(constants)
+        return _unrolled_gaussian_elimination(matJ, vecF, state_vars, names, custom_fcts, do_cse)
+
     if small_system:
         # small linear system: solve by gaussian elimination
         solution_vector = sp.linsolve(eqs, state_vars).args[0]
@@ -223,6 +490,14 @@ def solve_lin_system(eq_strings, vars, constants, function_calls, small_system=F
     return code, new_local_vars
 
 
+@_memoize(
+    lambda eq_strings, vars, constants, function_calls: (
+        _canonical_eqs(eq_strings),
+        tuple(vars),
+        _used_names(constants, eq_strings),
+        _used_names(function_calls, eq_strings),
+    )
+)
 def solve_non_lin_system(eq_strings, vars, constants, function_calls):
     """Solve non-linear system of equations, return solution as C code.
 
@@ -261,6 +536,14 @@ def solve_non_lin_system(eq_strings, vars, constants, function_calls):
     return code
 
 
+@_memoize(
+    lambda diff_string, dt_var, vars, use_pade_approx: (
+        _canonical_eqs([diff_string]),
+        dt_var,
+        _used_names(vars, [diff_string]),
+        use_pade_approx,
+    )
+)
 def integrate2c(diff_string, dt_var, vars, use_pade_approx=False):
     """Analytically integrate supplied derivative, return solution as C code.
 
@@ -368,6 +651,14 @@ def integrate2c(diff_string, dt_var, vars, use_pade_approx=False):
     return f"{sp.ccode(x)} = {sp.ccode(solution.evalf())}"
 
 
+@_memoize(
+    lambda diff_string, dt_var, vars, function_calls: (
+        _canonical_eqs([diff_string]),
+        dt_var,
+        _used_names(vars, [diff_string]),
+        _used_names(function_calls, [diff_string]),
+    )
+)
 def forwards_euler2c(diff_string, dt_var, vars, function_calls):
     """Return forwards euler solution of diff_string as C code.
 
@@ -396,6 +687,60 @@ def forwards_euler2c(diff_string, dt_var, vars, function_calls):
     return f"{sp.ccode(x)} = {sp.ccode(solution, user_functions=custom_fcts)}"
 
 
+def solve_ode_batch(
+    diff_strings, method, dt_var, vars, use_pade_approx=False, function_calls=None
+):
+    """Solve independent differential equations of a block, return solutions as C code.
+
+    Batched version of integrate2c (for "cnexp") and forwards_euler2c
+    (for "euler") that solves all equations of a DERIVATIVE block in a
+    single call, so that the caller pays for one interpreter round-trip
+    per block instead of one per equation. Each equation only gets the
+    variables it actually uses, and a failure to solve one equation does
+    not affect the others.
+
+    Args:
+        diff_strings: list of derivatives e.g. ["m' = (minf-m)/mtau", "h' = a*h"]
+        method: solver method, either "cnexp" or "euler"
+        dt_var: name of timestep dt variable in NEURON
+        vars: set of variables used in expressions, e.g. {"minf", "mtau", "a"}
+        use_pade_approx: for "cnexp", return (1,1) Pade approx to solution
+        function_calls: set of function calls used in the ODEs
+
+    Returns:
+        solutions: list of strings with solution of each ODE as C code
+                   (empty string if ODE could not be solved)
+        exception_messages: list of strings with reason of failure for each ODE
+                            (empty string if ODE was solved)
+    """
+    function_calls = function_calls or set()
+    solutions = []
+    exception_messages = []
+    for diff_string in diff_strings:
+        used_vars = _used_names(vars, [diff_string])
+        try:
+            if method == "cnexp":
+                solution = integrate2c(diff_string, dt_var, used_vars, use_pade_approx)
+            elif method == "euler":
+                solution = forwards_euler2c(diff_string, dt_var, used_vars, function_calls)
+            else:
+                raise ValueError(f"Solve method {method} not supported")
+            solutions.append(solution)
+            exception_messages.append("")
+        except Exception as e:
+            solutions.append("")
+            exception_messages.append(str(e))
+    return solutions, exception_messages
+
+
+@_memoize(
+    lambda expression, dependent_var, vars, prev_expressions: (
+        _canonical_eqs([expression]),
+        dependent_var,
+        _used_names(vars, [expression] + list(prev_expressions or [])),
+        _canonical_eqs(prev_expressions or []),
+    )
+)
 def differentiate2c(expression, dependent_var, vars, prev_expressions=None):
     """Analytically differentiate supplied expression, return solution as C code.
 
@@ -21,6 +21,7 @@
 #include "ast/ast_decl.hpp"
 #include "lexer/modtoken.hpp"
 #include "symtab/symbol_table.hpp"
+#include "utils/arena.hpp"
 #include "visitors/visitor.hpp"
 
 namespace nmodl {
@@ -155,6 +156,33 @@ struct Ast: public std::enable_shared_from_this<Ast> {
     /// \}
 
 
+    /// \name Allocation
+    /// \{
+
+    /**
+     * \brief Allocate node from the arena of the current utils::ArenaScope
+     *
+     * Nodes created with `new` (by the parser, clone(), ...) while a scope is
+     * active are placed in its arena, otherwise they are allocated on the heap.
+     * Nodes created with `std::make_shared` always use the heap.
+     */
+    static void* operator new(std::size_t size) {
+        return utils::allocate_object(size);
+    }
+
+    static void* operator new(std::size_t /*size*/, void* ptr) noexcept {
+        return ptr;
+    }
+
+    static void operator delete(void* ptr) noexcept {
+        utils::deallocate_object(ptr);
+    }
+
+    static void operator delete(void* /*ptr*/, void* /*place*/) noexcept {}
+
+    /// \}
+
+
     /// \name Pure Virtual Functions
     /// \{
 
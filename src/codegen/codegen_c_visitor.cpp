@@ -11,6 +11,7 @@
 
 #include "codegen/codegen_c_visitor.hpp"
 #include "codegen/codegen_helper_visitor.hpp"
+#include "codegen/codegen_loop_invariant_visitor.hpp"
 #include "codegen/codegen_naming.hpp"
 #include "config/config.h"
 #include "parser/c11_driver.hpp"
@@ -233,14 +234,14 @@ void CodegenCVisitor::visit_paren_expression(ParenExpression* node) {
 
 
 void CodegenCVisitor::visit_binary_expression(BinaryExpression* node) {
-    if (!codegen) {
+    if (!codegen || print_loop_invariant_name(node)) {
         return;
     }
     auto op = node->get_op().eval();
     auto lhs = node->get_lhs();
     auto rhs = node->get_rhs();
     if (op == "^") {
-        printer->add_text("pow(");
+        printer->add_text("{}("_format(math_function_name("pow")));
         lhs->accept(*this);
         printer->add_text(", ");
         rhs->accept(*this);
@@ -284,7 +285,7 @@ void CodegenCVisitor::visit_statement_block(StatementBlock* node) {
 
 
 void CodegenCVisitor::visit_function_call(FunctionCall* node) {
-    if (!codegen) {
+    if (!codegen || print_loop_invariant_name(node)) {
         return;
     }
     print_function_call(node);
@@ -371,6 +372,14 @@ bool CodegenCVisitor::nrn_cur_required() {
 }
 
 
+bool CodegenCVisitor::nrn_state_cur_required() {
+    if (fused_tile_size == 0 || !nrn_state_required() || !nrn_cur_required()) {
+        return false;
+    }
+    return !net_receive_exist() && ion_write_statements(BlockType::State).empty();
+}
+
+
 bool CodegenCVisitor::net_receive_exist() {
     return info.net_receive_node != nullptr;
 }
@@ -391,7 +400,28 @@ bool CodegenCVisitor::net_receive_required() {
  * have to copy old array to new type (for range variables).
  */
 bool CodegenCVisitor::range_variable_setup_required() {
-    return codegen::naming::DEFAULT_FLOAT_TYPE != float_data_type();
+    for (auto& var: codegen_float_variables) {
+        if (get_range_var_float_type(var) != default_float_data_type()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+int CodegenCVisitor::instance_data_alignment() const {
+    return std::max(16, simd_width * static_cast<int>(sizeof(double)));
+}
+
+
+bool CodegenCVisitor::aligned_range_variables() const {
+    if (simd_width <= 1) {
+        return false;
+    }
+    if (layout == LayoutType::aosoa) {
+        return layout_block_width % simd_width == 0;
+    }
+    return layout == LayoutType::soa;
 }
 
 
@@ -1193,11 +1223,14 @@ bool CodegenCVisitor::optimize_ion_variable_copies() {
 
 void CodegenCVisitor::print_memory_allocation_routine() {
     printer->add_newline(2);
-    auto args = "size_t num, size_t size, size_t alignment = 16";
+    auto args = "size_t num, size_t size, size_t alignment = {}"_format(instance_data_alignment());
     printer->add_line("static inline void* mem_alloc({}) {}"_format(args, "{"));
     printer->add_line("    void* ptr;");
-    printer->add_line("    posix_memalign(&ptr, alignment, num*size);");
-    printer->add_line("    memset(ptr, 0, size);");
+    printer->add_line("    if (posix_memalign(&ptr, alignment, num*size) != 0) {");
+    printer->add_line("        fprintf(stderr, \"mem_alloc : allocation failed\\n\");");
+    printer->add_line("        abort();");
+    printer->add_line("    }");
+    printer->add_line("    memset(ptr, 0, num*size);");
     printer->add_line("    return ptr;");
     printer->add_line("}");
 
@@ -1205,6 +1238,15 @@ void CodegenCVisitor::print_memory_allocation_routine() {
     printer->add_line("static inline void mem_free(void* ptr) {");
     printer->add_line("    free(ptr);");
     printer->add_line("}");
+
+    if (aligned_range_variables()) {
+        printer->add_newline(2);
+        printer->add_line("#if defined(__GNUC__)");
+        printer->add_line("#define nmodl_assume_aligned(ptr, n) __builtin_assume_aligned(ptr, n)");
+        printer->add_line("#else");
+        printer->add_line("#define nmodl_assume_aligned(ptr, n) (ptr)");
+        printer->add_line("#endif");
+    }
 }
 
 
@@ -1221,6 +1263,9 @@ std::string CodegenCVisitor::compute_method_name(BlockType type) {
     if (type == BlockType::Watch) {
         return method_name(naming::NRN_WATCH_CHECK_METHOD);
     }
+    if (type == BlockType::StateEquation) {
+        return method_name(naming::NRN_STATE_CUR_METHOD);
+    }
     throw std::logic_error("compute_method_name not implemented");
 }
 
@@ -1281,6 +1326,8 @@ void CodegenCVisitor::print_function_call(FunctionCall* node) {
     auto function_name = name;
     if (defined_method(name)) {
         function_name = method_name(name);
+    } else {
+        function_name = math_function_name(name);
     }
 
     if (is_net_send(name)) {
@@ -1313,6 +1360,16 @@ void CodegenCVisitor::print_function_call(FunctionCall* node) {
 }
 
 
+std::string CodegenCVisitor::math_function_name(const std::string& name) const {
+    if (vector_math == "off" ||
+        (name != "exp" && name != "expm1" && name != "log" && name != "pow")) {
+        return name;
+    }
+    auto ns = vector_math == "approx" ? "nmodl::fast_math::approx" : "nmodl::fast_math";
+    return "{}::v{}"_format(ns, name);
+}
+
+
 void CodegenCVisitor::print_top_verbatim_blocks() {
     if (info.top_verbatim_blocks.empty()) {
         return;
@@ -1463,11 +1520,17 @@ void CodegenCVisitor::print_table_check_function(ast::Block* node) {
                 "for(i = 0, x = {}; i < {}; x += dx, i++) {}"_format(tmin_name, with + 1, "{"));
             auto function = method_name("f_" + name);
             printer->add_line("    {}({}, x);"_format(function, internal_method_arguments()));
-            for (const auto& variable: table_variables) {
-                auto name = variable->get_node_name();
+            for (size_t k = 0; k < table_variables.size(); k++) {
+                auto name = table_variables[k]->get_node_name();
                 auto instance_name = get_variable_name(name);
-                auto table_name = get_variable_name("t_" + name);
-                printer->add_line("    {}[i] = {};"_format(table_name, instance_name));
+                if (interleaved_tables) {
+                    auto table_name = get_variable_name("t_" + node->get_node_name());
+                    printer->add_line("    {}[i*{}+{}] = {};"_format(
+                        table_name, table_variables.size(), k, instance_name));
+                } else {
+                    auto table_name = get_variable_name("t_" + name);
+                    printer->add_line("    {}[i] = {};"_format(table_name, instance_name));
+                }
             }
             printer->add_line("}");
 
@@ -1504,32 +1567,36 @@ void CodegenCVisitor::print_table_replacement_function(ast::Block* node) {
         printer->add_line("}");
 
         printer->add_line("double xi = {} * (arg_v - {});"_format(mfac_name, tmin_name));
-        printer->add_line("if (isnan(xi)) {");
-        for (const auto& var: table_variables) {
-            auto name = get_variable_name(var->get_node_name());
-            printer->add_line("    {} = xi;"_format(name));
-        }
-        printer->add_line("    return 0;");
-        printer->add_line("}");
+        if (interleaved_tables) {
+            print_interleaved_table_lookup(node, with);
+        } else {
+            printer->add_line("if (isnan(xi)) {");
+            for (const auto& var: table_variables) {
+                auto name = get_variable_name(var->get_node_name());
+                printer->add_line("    {} = xi;"_format(name));
+            }
+            printer->add_line("    return 0;");
+            printer->add_line("}");
 
-        printer->add_line("if (xi <= 0.0 || xi >= {}) {}"_format(with, "{"));
-        printer->add_line("    int index = (xi <= 0.0) ? 0 : {};"_format(with));
-        for (const auto& variable: table_variables) {
-            auto name = variable->get_node_name();
-            auto instance_name = get_variable_name(name);
-            auto table_name = get_variable_name("t_" + name);
-            printer->add_line("    {} = {}[index];"_format(instance_name, table_name));
-        }
-        printer->add_line("    return 0;");
-        printer->add_line("}");
+            printer->add_line("if (xi <= 0.0 || xi >= {}) {}"_format(with, "{"));
+            printer->add_line("    int index = (xi <= 0.0) ? 0 : {};"_format(with));
+            for (const auto& variable: table_variables) {
+                auto name = variable->get_node_name();
+                auto instance_name = get_variable_name(name);
+                auto table_name = get_variable_name("t_" + name);
+                printer->add_line("    {} = {}[index];"_format(instance_name, table_name));
+            }
+            printer->add_line("    return 0;");
+            printer->add_line("}");
 
-        printer->add_line("int i = int(xi);");
-        printer->add_line("double theta = xi - double(i);");
-        for (const auto& var: table_variables) {
-            auto instance_name = get_variable_name(var->get_node_name());
-            auto table_name = get_variable_name("t_" + var->get_node_name());
-            printer->add_line(
-                "{0} = {1}[i] + theta*({1}[i+1]-{1}[i]);"_format(instance_name, table_name));
+            printer->add_line("int i = int(xi);");
+            printer->add_line("double theta = xi - double(i);");
+            for (const auto& var: table_variables) {
+                auto instance_name = get_variable_name(var->get_node_name());
+                auto table_name = get_variable_name("t_" + var->get_node_name());
+                printer->add_line(
+                    "{0} = {1}[i] + theta*({1}[i+1]-{1}[i]);"_format(instance_name, table_name));
+            }
         }
 
         printer->add_line("return 0;");
@@ -1538,6 +1605,44 @@ void CodegenCVisitor::print_table_replacement_function(ast::Block* node) {
 }
 
 
+/**
+ * \details All variables of a table are stored row-wise in one array, so that the
+ * two rows used for interpolation share (typically) one cache line. Index is
+ * clamped with conditional moves only and NaN voltage propagates through a
+ * select, which allows the calling loop to be vectorized with gathers:
+ *
+ * \code{.cpp}
+ *      double xc = xi > 0.0 ? xi : 0.0;
+ *      xc = xc < 200.0 ? xc : 200.0;
+ *      int i = int(xc);
+ *      i = i < 199 ? i : 199;
+ *      double theta = xc - double(i);
+ *      const double* row = t_rates + i*2;
+ *      minf = isnan(xi) ? xi : row[0] + theta*(row[2]-row[0]);
+ *      mtau = isnan(xi) ? xi : row[1] + theta*(row[3]-row[1]);
+ * \endcode
+ */
+void CodegenCVisitor::print_interleaved_table_lookup(ast::Block* node, int with) {
+    auto statement = get_table_statement(node);
+    auto table_variables = statement->get_table_vars();
+    auto num_variables = table_variables.size();
+    auto table_name = get_variable_name("t_" + node->get_node_name());
+    auto float_type = interleaved_table_data_type(node);
+
+    printer->add_line("double xc = xi > 0.0 ? xi : 0.0;");
+    printer->add_line("xc = xc < {0}.0 ? xc : {0}.0;"_format(with));
+    printer->add_line("int i = int(xc);");
+    printer->add_line("i = i < {0} ? i : {0};"_format(with - 1));
+    printer->add_line("double theta = xc - double(i);");
+    printer->add_line("const {}* row = {} + i*{};"_format(float_type, table_name, num_variables));
+    for (size_t k = 0; k < num_variables; k++) {
+        auto instance_name = get_variable_name(table_variables[k]->get_node_name());
+        printer->add_line("{} = isnan(xi) ? xi : row[{}] + theta*(row[{}]-row[{}]);"_format(
+            instance_name, k, k + num_variables, k));
+    }
+}
+
+
 void CodegenCVisitor::print_check_table_thread_function() {
     if (info.table_count == 0) {
         return;
@@ -1631,10 +1736,78 @@ std::string CodegenCVisitor::find_var_unique_name(const std::string& original_na
     return unique_name;
 }
 
-void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBlock* node) {
-    // solution vector to store copy of state vars for Newton solver
-    printer->add_newline();
+/// check if given expression is literal zero
+static bool is_zero(const std::shared_ptr<ast::Expression>& node) {
+    if (node->is_integer()) {
+        return std::dynamic_pointer_cast<ast::Integer>(node)->eval() == 0;
+    }
+    if (node->is_double()) {
+        return std::dynamic_pointer_cast<ast::Double>(node)->eval() == 0.0;
+    }
+    return false;
+}
+
 
+/**
+ * \details Only top level assignments `J[i] = expr` are considered: if some
+ * entry is not assigned exactly this way, the pattern is not known and dense
+ * LU is used. Zero diagonal entries require pivoting and are not supported.
+ */
+std::unique_ptr<SparseLU> CodegenCVisitor::sparse_lu_factorization(ast::StatementBlock* node,
+                                                                   const std::string& J,
+                                                                   int N) {
+    if (!sparse_lu) {
+        return nullptr;
+    }
+    std::vector<bool> assigned(N * N, false);
+    std::vector<bool> non_zero(N * N, false);
+    for (const auto& statement: node->get_statements()) {
+        if (!statement->is_expression_statement()) {
+            continue;
+        }
+        auto expression = std::dynamic_pointer_cast<ast::ExpressionStatement>(statement)
+                              ->get_expression();
+        auto assignment = std::dynamic_pointer_cast<ast::BinaryExpression>(expression);
+        if (assignment == nullptr || assignment->get_op().get_value() != ast::BOP_ASSIGN ||
+            !assignment->get_lhs()->is_var_name()) {
+            continue;
+        }
+        auto name = std::dynamic_pointer_cast<ast::VarName>(assignment->get_lhs())->get_name();
+        if (!name->is_indexed_name() || name->get_node_name() != J) {
+            continue;
+        }
+        auto length = std::dynamic_pointer_cast<ast::IndexedName>(name)->get_length();
+        if (!length->is_integer()) {
+            return nullptr;
+        }
+        int index = std::dynamic_pointer_cast<ast::Integer>(length)->eval();
+        if (index < 0 || index >= N * N) {
+            return nullptr;
+        }
+        assigned[index] = true;
+        non_zero[index] = !is_zero(assignment->get_rhs());
+    }
+    for (int i = 0; i < N; i++) {
+        if (!non_zero[i + N * i]) {
+            return nullptr;
+        }
+    }
+    if (std::find(assigned.begin(), assigned.end(), false) != assigned.end()) {
+        return nullptr;
+    }
+    std::unique_ptr<SparseLU> factorization(new SparseLU(N, non_zero));
+    logger->debug("CodegenCVisitor :: sparse LU of {}x{} Jacobian with {} non-zeros, {} fill-in",
+                  N,
+                  N,
+                  std::count(non_zero.begin(), non_zero.end(), true),
+                  factorization->fill_in());
+    return factorization;
+}
+
+
+void CodegenCVisitor::print_newton_functor(ast::EigenNewtonSolverBlock* node,
+                                           bool default_ctor,
+                                           const SparseLU* sparse_solver) {
     // Check if there is a variable defined in the mod file as X, J, Jm or F and if yes
     // try to use a different string for the matrices created by sympy in the form
     // X_<random_number>, J_<random_number>, Jm_<random_number> and F_<random_number>
@@ -1645,9 +1818,6 @@ void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBloc
 
     auto float_type = default_float_data_type();
     int N = node->get_n_state_vars()->get_value();
-    printer->add_line("Eigen::Matrix<{}, {}, 1> {};"_format(float_type, N, X));
-
-    print_statement_block(node->get_setup_x_block().get(), false, false);
 
     // functor that evaluates F(X) and J(X) for
     // Newton solver
@@ -1668,6 +1838,9 @@ void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBloc
     print_statement_block(node->get_initialize_block().get(), false, false);
     printer->end_block(2);
 
+    if (default_ctor) {
+        printer->add_line("functor() = default;");
+    }
     printer->add_line(
         "functor(NrnThread* nt, {}* inst, int id, int pnodecount, double v, Datum* indexes) : nt(nt), inst(inst), id(id), pnodecount(pnodecount), v(v), indexes(indexes) {}"_format(
             instance_struct(), "{}"));
@@ -1682,6 +1855,46 @@ void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBloc
     print_statement_block(node->get_functor_block().get(), false, false);
     printer->end_block(2);
 
+    // solve J(X) dX = F(X) in place with straight-line sparse LU, factorization
+    // and substitution are separate for solvers reusing the factorization,
+    // factorize returns false if a pivot is zero
+    if (sparse_solver != nullptr) {
+        printer->start_block("bool factorize(Eigen::Matrix<{0}, {1}, {1}>& {2}) const"_format(
+            float_type, N, Jm));
+        printer->add_line("{}* {} = {}.data();"_format(float_type, J, Jm));
+        for (const auto& statement: sparse_solver->factorize_statements(J)) {
+            printer->add_line(statement);
+        }
+        printer->add_line("return {};"_format(sparse_solver->non_zero_pivots(J)));
+        printer->end_block(2);
+
+        printer->start_block(
+            "void substitute(Eigen::Matrix<{0}, {1}, {1}>& {2}, Eigen::Matrix<{0}, {1}, 1>& {3}) const"_format(
+                float_type, N, Jm, F));
+        printer->add_line("{}* {} = {}.data();"_format(float_type, J, Jm));
+        for (const auto& statement: sparse_solver->solve_statements(J, F)) {
+            printer->add_line(statement);
+        }
+        printer->end_block(2);
+
+        // dense LU with partial pivoting if static pivot order fails
+        auto dense_Jm = Jm + "_dense";
+        printer->start_block(
+            "void solve(Eigen::Matrix<{0}, {1}, {1}>& {2}, Eigen::Matrix<{0}, {1}, 1>& {3}) const"_format(
+                float_type, N, Jm, F));
+        printer->add_line("Eigen::Matrix<{0}, {1}, {1}> {2} = {3};"_format(
+            float_type, N, dense_Jm, Jm));
+        printer->start_block("if (factorize({}))"_format(Jm));
+        printer->add_line("substitute({}, {});"_format(Jm, F));
+        printer->end_block(1);
+        printer->start_block("else");
+        printer->add_line(
+            "{0} = Eigen::PartialPivLU<Eigen::Matrix<{1}, {2}, {2}>>({3}).solve({0}).eval();"_format(
+                F, float_type, N, dense_Jm));
+        printer->end_block(1);
+        printer->end_block(2);
+    }
+
     // assign newton solver results in matrix X to state vars
     printer->start_block("void finalize()");
     print_statement_block(node->get_finalize_block().get(), false, false);
@@ -1690,19 +1903,71 @@ void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBloc
     printer->end_block(0);
     printer->add_text(";");
     printer->add_newline();
+}
+
+void CodegenCVisitor::visit_eigen_newton_solver_block(ast::EigenNewtonSolverBlock* node) {
+    // solution vector to store copy of state vars for Newton solver
+    printer->add_newline();
+
+    std::string X = find_var_unique_name("X");
+    auto float_type = default_float_data_type();
+    int N = node->get_n_state_vars()->get_value();
+    printer->add_line("Eigen::Matrix<{}, {}, 1> {};"_format(float_type, N, X));
+
+    print_statement_block(node->get_setup_x_block().get(), false, false);
+
+    auto sparse_solver = sparse_lu_factorization(node->get_functor_block().get(),
+                                                 find_var_unique_name("J"),
+                                                 N);
+    print_newton_functor(node, false, sparse_solver.get());
 
     // call newton solver with functor and X matrix that contains state vars
+    std::string solver = sparse_solver ? "newton_sparse_solver" : "newton_solver";
+    if (newton_method != "newton") {
+        solver = "newton_{}_solver"_format(newton_method);
+        if (sparse_solver) {
+            solver += "<{0}, functor, nmodl::newton::FunctorLU<{0}>>"_format(N);
+        }
+    }
     printer->add_line("// call newton solver");
     printer->add_line("functor newton_functor(nt, inst, id, pnodecount, v, indexes);");
     printer->add_line("newton_functor.initialize();");
-    printer->add_line(
-        "int newton_iterations = nmodl::newton::newton_solver({}, newton_functor);"_format(X));
+    printer->add_line("int newton_iterations = nmodl::newton::{}({}, newton_functor{});"_format(
+        solver, X, newton_tolerance_arguments()));
+    print_newton_stats_record("newton_iterations", X, "newton_functor");
 
     // assign newton solver results in matrix X to state vars
     print_statement_block(node->get_update_states_block().get(), false, false);
     printer->add_line("newton_functor.finalize();");
 }
 
+std::string CodegenCVisitor::newton_tolerance_arguments() const {
+    if (newton_atol == 1e-12 && newton_rtol == 0. && newton_max_iter == 1000) {
+        return "";
+    }
+    return ", {}, {}, {}"_format(newton_atol, newton_max_iter, newton_rtol);
+}
+
+/**
+ * \details The statistics buffer of the calling thread is looked up once per
+ * thread (by mechanism suffix), recording is then a histogram update and one
+ * additional evaluation of the functor to get the residual at the solution.
+ * The buffer reference is named `nmodl_newton_stats_<suffix>` because NMODL
+ * variables are printed without prefix and could be called `newton_stats`.
+ */
+void CodegenCVisitor::print_newton_stats_record(const std::string& iterations,
+                                                const std::string& X,
+                                                const std::string& functor) {
+    if (!newton_stats) {
+        return;
+    }
+    auto stats = "nmodl_newton_stats_{}"_format(info.mod_suffix);
+    printer->add_line(
+        "static thread_local nmodl::newton::NewtonStats& {} = nmodl::newton::thread_newton_stats(\"{}\");"_format(
+            stats, info.mod_suffix));
+    printer->add_line("{}.record({}, {}, {});"_format(stats, iterations, X, functor));
+}
+
 void CodegenCVisitor::visit_eigen_linear_solver_block(ast::EigenLinearSolverBlock* node) {
     printer->add_newline();
 
@@ -1724,9 +1989,30 @@ void CodegenCVisitor::visit_eigen_linear_solver_block(ast::EigenLinearSolverBloc
     print_statement_block(node->get_setup_x_block().get(), false, false);
 
     printer->add_newline();
-    printer->add_line(
-        "{0} = Eigen::PartialPivLU<Eigen::Ref<Eigen::Matrix<{1}, {2}, {2}>>>({3}).solve({4});"_format(
-            X, float_type, N, Jm, F));
+    auto sparse_solver = sparse_lu_factorization(node->get_setup_x_block().get(), J, N);
+    if (sparse_solver) {
+        // dense LU with partial pivoting if static pivot order fails
+        auto dense_Jm = Jm + "_dense";
+        printer->add_line("Eigen::Matrix<{0}, {1}, {1}> {2} = {3};"_format(
+            float_type, N, dense_Jm, Jm));
+        for (const auto& statement: sparse_solver->factorize_statements(J)) {
+            printer->add_line(statement);
+        }
+        printer->start_block("if ({})"_format(sparse_solver->non_zero_pivots(J)));
+        for (const auto& statement: sparse_solver->solve_statements(J, F)) {
+            printer->add_line(statement);
+        }
+        printer->add_line("{} = {};"_format(X, F));
+        printer->end_block(1);
+        printer->start_block("else");
+        printer->add_line("{0} = Eigen::PartialPivLU<Eigen::Matrix<{1}, {2}, {2}>>({3}).solve({4});"_format(
+            X, float_type, N, dense_Jm, F));
+        printer->end_block(1);
+    } else {
+        printer->add_line(
+            "{0} = Eigen::PartialPivLU<Eigen::Ref<Eigen::Matrix<{1}, {2}, {2}>>>({3}).solve({4});"_format(
+                X, float_type, N, Jm, F));
+    }
     print_statement_block(node->get_update_states_block().get(), false, false);
     print_statement_block(node->get_finalize_block().get(), false, false);
 }
@@ -1864,7 +2150,11 @@ std::string CodegenCVisitor::process_verbatim_text(std::string text) {
             name = "&" + name;
         }
         if (token == "_STRIDE") {
-            name = (layout == LayoutType::soa) ? "pnodecount+id" : "1";
+            if (layout == LayoutType::aosoa) {
+                name = std::to_string(layout_block_width);
+            } else {
+                name = (layout == LayoutType::soa) ? "pnodecount+id" : "1";
+            }
         }
         result += name;
     }
@@ -1966,10 +2256,19 @@ void CodegenCVisitor::print_memory_layout_getter() {
     printer->add_line("static inline int get_memory_layout() {");
     if (layout == LayoutType::aos) {
         printer->add_line("    return 1;  //aos");
+    } else if (layout == LayoutType::aosoa) {
+        printer->add_line("    return 2;  //aosoa");
     } else {
         printer->add_line("    return 0;  //soa");
     }
     printer->add_line("}");
+
+    if (layout == LayoutType::aosoa) {
+        printer->add_newline(2);
+        printer->add_line("static inline int get_memory_layout_block_width() {");
+        printer->add_line("    return {};"_format(layout_block_width));
+        printer->add_line("}");
+    }
 }
 
 
@@ -2034,6 +2333,11 @@ void CodegenCVisitor::print_post_channel_iteration_common_code() {
     if (layout == LayoutType::aos) {
         printer->add_line("data = ml->data + id*{};"_format(float_variables_size()));
         printer->add_line("indexes = ml->pdata + id*{};"_format(int_variables_size()));
+    } else if (layout == LayoutType::aosoa) {
+        auto float_offset = aosoa_instance_offset(float_variables_size());
+        auto int_offset = aosoa_instance_offset(int_variables_size());
+        printer->add_line("data = ml->data + {};"_format(float_offset));
+        printer->add_line("indexes = ml->pdata + {};"_format(int_offset));
     }
 }
 
@@ -2110,12 +2414,38 @@ void CodegenCVisitor::print_thread_getters() {
 /****************************************************************************************/
 
 
+std::string CodegenCVisitor::aosoa_instance_offset(int num_vars) const {
+    auto width = layout_block_width;
+    return "id/{0}*{1}+id%{0}"_format(width, width * num_vars);
+}
+
+
+/**
+ * \details In LayoutType::aosoa layout the \c data and \c indexes pointers point to the
+ * first variable of the current instance (see print_post_channel_iteration_common_code),
+ * as for LayoutType::aos, and variables of an instance are block width elements apart.
+ * Arrays of an instance are contiguous within the block, as for LayoutType::soa within
+ * the whole data array.
+ */
 std::string CodegenCVisitor::float_variable_name(SymbolType& symbol, bool use_instance) {
     auto name = symbol->get_name();
     auto dimension = symbol->get_length();
     auto num_float = float_variables_size();
     auto position = position_of_float_var(name);
+    auto width = layout_block_width;
     // clang-format off
+    if (layout == LayoutType::aosoa) {
+        if (symbol->is_array()) {
+            if (use_instance) {
+                return "(inst->{}+id/{}*{}+id%{}*{})"_format(name, width, width * num_float, width, dimension);
+            }
+            return "(data+{}+id%{}*{})"_format(position * width, width, dimension - 1);
+        }
+        if (use_instance) {
+            return "inst->{}[{}]"_format(name, aosoa_instance_offset(num_float));
+        }
+        return "data[{}]"_format(position * width);
+    }
     if (symbol->is_array()) {
         if (use_instance) {
             auto stride = (layout == LayoutType::soa) ? dimension : num_float;
@@ -2141,6 +2471,21 @@ std::string CodegenCVisitor::int_variable_name(IndexVariableInfo& symbol,
     auto num_int = int_variables_size();
     std::string offset;
     // clang-format off
+    if (layout == LayoutType::aosoa && !symbol.is_index) {
+        auto width = layout_block_width;
+        offset = std::to_string(position * width);
+        if (symbol.is_integer) {
+            if (use_instance) {
+                return "inst->{}[{}+{}]"_format(name, aosoa_instance_offset(num_int), offset);
+            }
+            return "indexes[{}]"_format(offset);
+        }
+        if (use_instance) {
+            return "inst->{}[indexes[{}]]"_format(name, offset);
+        }
+        auto data = symbol.is_vdata ? "_vdata" : "_data";
+        return "nt->{}[indexes[{}]]"_format(data, offset);
+    }
     if (symbol.is_index) {
         offset = std::to_string(position);
         if (use_instance) {
@@ -2282,6 +2627,9 @@ void CodegenCVisitor::print_standard_includes() {
     printer->add_line("#include <stdio.h>");
     printer->add_line("#include <stdlib.h>");
     printer->add_line("#include <string.h>");
+    if (vector_math != "off") {
+        printer->add_line("#include <nmodl/fast_math.hpp>");
+    }
 }
 
 
@@ -2300,6 +2648,9 @@ void CodegenCVisitor::print_coreneuron_includes() {
     printer->add_line("#include \"_kinderiv.h\"");
     if (info.eigen_newton_solver_exist) {
         printer->add_line("#include <newton/newton.hpp>");
+        if (newton_stats) {
+            printer->add_line("#include <newton/newton_stats.hpp>");
+        }
     }
     if (info.eigen_linear_solver_exist) {
         printer->add_line("#include <Eigen/LU>");
@@ -2434,10 +2785,20 @@ void CodegenCVisitor::print_mechanism_global_var_structure(bool wrapper) {
             codegen_global_variables.push_back(make_symbol("mfac_" + name));
         }
 
-        for (const auto& variable: info.table_statement_variables) {
-            auto name = "t_" + variable->get_name();
-            printer->add_line("{}* {};"_format(float_type, name));
-            codegen_global_variables.push_back(make_symbol(name));
+        if (interleaved_tables) {
+            for (const auto& block: info.functions_with_table) {
+                auto name = "t_" + block->get_node_name();
+                auto type = interleaved_table_data_type(block);
+                printer->add_line("{}* {};"_format(type, name));
+                codegen_global_variables.push_back(make_symbol(name));
+            }
+        } else {
+            for (const auto& variable: info.table_statement_variables) {
+                auto name = "t_" + variable->get_name();
+                auto type = table_data_type(variable->get_name());
+                printer->add_line("{}* {};"_format(type, name));
+                codegen_global_variables.push_back(make_symbol(name));
+            }
         }
     }
 
@@ -2934,11 +3295,24 @@ void CodegenCVisitor::print_global_variable_setup() {
         auto name = get_variable_name(naming::USE_TABLE_VARIABLE);
         printer->add_line("{} = 1;"_format(name));
 
-        for (auto& variable: info.table_statement_variables) {
-            auto name = get_variable_name("t_" + variable->get_name());
-            int num_values = variable->get_num_values();
-            printer->add_line(
-                "{} = (double*) mem_alloc({}, sizeof(double));"_format(name, num_values));
+        if (interleaved_tables) {
+            for (const auto& block: info.functions_with_table) {
+                auto name = get_variable_name("t_" + block->get_node_name());
+                auto statement = get_table_statement(block);
+                int num_values = statement->get_with()->eval() + 1;
+                int num_variables = statement->get_table_vars().size();
+                auto type = interleaved_table_data_type(block);
+                printer->add_line("{0} = ({1}*) mem_alloc({2}, sizeof({1}));"_format(
+                    name, type, num_values * num_variables));
+            }
+        } else {
+            for (auto& variable: info.table_statement_variables) {
+                auto name = get_variable_name("t_" + variable->get_name());
+                int num_values = variable->get_num_values();
+                auto type = table_data_type(variable->get_name());
+                printer->add_line(
+                    "{0} = ({1}*) mem_alloc({2}, sizeof({1}));"_format(name, type, num_values));
+            }
         }
     }
 
@@ -2992,12 +3366,11 @@ void CodegenCVisitor::print_shadow_vector_setup() {
 
 
 void CodegenCVisitor::print_setup_range_variable() {
-    auto type = float_data_type();
     printer->add_newline(2);
     printer->add_line("/** allocate and setup array for range variable */");
-    printer->start_block(
-        "static inline {}* setup_range_variable(double* variable, int n) "_format(type));
-    printer->add_line("{0}* data = ({0}*) mem_alloc(n, sizeof({0}));"_format(type));
+    printer->add_line("template <typename T>");
+    printer->start_block("static inline T* setup_range_variable(double* variable, int n) ");
+    printer->add_line("T* data = (T*) mem_alloc(n, sizeof(T));");
     printer->add_line("for(size_t i = 0; i < n; i++) {");
     printer->add_line("    data[i] = variable[i];");
     printer->add_line("}");
@@ -3024,9 +3397,111 @@ std::string CodegenCVisitor::get_range_var_float_type(const SymbolType& symbol)
     if (need_default_type) {
         return default_float_data_type();
     }
+    if (reduced_precision_variables.count(symbol->get_name()) != 0) {
+        return naming::REDUCED_FLOAT_TYPE;
+    }
     return float_data_type();
 }
 
+
+bool CodegenCVisitor::reduced_precision_allowed(const SymbolType& symbol) const {
+    // clang-format off
+    auto with   =   NmodlType::state_var
+                    | NmodlType::read_ion_var
+                    | NmodlType::write_ion_var
+                    | NmodlType::pointer_var
+                    | NmodlType::bbcore_pointer_var
+                    | NmodlType::extern_neuron_variable;
+    // clang-format on
+    return !symbol->has_any_property(with) && !symbol->is_array();
+}
+
+
+void CodegenCVisitor::select_reduced_precision_variables() {
+    reduced_precision_variables.clear();
+    if (!mixed_precision) {
+        return;
+    }
+    if (layout != LayoutType::soa) {
+        logger->warn("CodegenCVisitor : mixed precision requires soa layout, ignored");
+        return;
+    }
+
+    std::set<std::string> candidates;
+    if (!requested_reduced_precision_variables.empty()) {
+        /// same list is used for all mod files, hence warn instead of aborting
+        for (const auto& name: requested_reduced_precision_variables) {
+            auto var = std::find_if(codegen_float_variables.begin(),
+                                    codegen_float_variables.end(),
+                                    [&name](const SymbolType& symbol) {
+                                        return symbol->get_name() == name;
+                                    });
+            if (var == codegen_float_variables.end()) {
+                logger->warn(
+                    "CodegenCVisitor : {} is not a range variable of {}, not stored in reduced "
+                    "precision",
+                    name,
+                    info.mod_suffix);
+            } else if (!reduced_precision_allowed(*var)) {
+                logger->warn(
+                    "CodegenCVisitor : {} of {} is a state, ion, pointer or array variable, not "
+                    "stored in reduced precision",
+                    name,
+                    info.mod_suffix);
+            } else {
+                candidates.insert(name);
+            }
+        }
+    } else {
+        std::vector<ast::Block*> blocks(info.procedures.begin(), info.procedures.end());
+        blocks.insert(blocks.end(), info.functions.begin(), info.functions.end());
+        for (const auto& block: blocks) {
+            auto nodes = AstLookupVisitor().lookup(block, AstNodeType::BINARY_EXPRESSION);
+            for (const auto& node: nodes) {
+                auto assignment = std::dynamic_pointer_cast<ast::BinaryExpression>(node);
+                if (assignment->get_op().get_value() == ast::BOP_ASSIGN &&
+                    assignment->get_lhs()->is_var_name()) {
+                    candidates.insert(assignment->get_lhs()->get_node_name());
+                }
+            }
+        }
+        for (const auto& current: info.currents) {
+            candidates.erase(current);
+        }
+    }
+
+    for (auto& var: codegen_float_variables) {
+        auto name = var->get_name();
+        if (candidates.count(name) == 0 || !reduced_precision_allowed(var)) {
+            continue;
+        }
+        bool heuristic = requested_reduced_precision_variables.empty();
+        if (heuristic && !var->has_any_property(NmodlType::assigned_definition)) {
+            continue;
+        }
+        reduced_precision_variables.insert(name);
+        logger->debug("CodegenCVisitor : {} stored in reduced precision", name);
+    }
+}
+
+
+std::string CodegenCVisitor::table_data_type(const std::string& name) {
+    if (reduced_precision_variables.count(name) != 0) {
+        return naming::REDUCED_FLOAT_TYPE;
+    }
+    return default_float_data_type();
+}
+
+
+std::string CodegenCVisitor::interleaved_table_data_type(ast::Block* node) {
+    for (const auto& variable: get_table_statement(node)->get_table_vars()) {
+        if (reduced_precision_variables.count(variable->get_node_name()) == 0) {
+            return default_float_data_type();
+        }
+    }
+    return naming::REDUCED_FLOAT_TYPE;
+}
+
 /**
  * \details For CPU/Host target there is no device pointer. In this case
  * just use the host variable name directly.
@@ -3057,6 +3532,9 @@ void CodegenCVisitor::print_instance_variable_setup() {
     if (layout == LayoutType::soa) {
         printer->add_line("int pnodecount = ml->_nodecount_padded;");
         stride = "*pnodecount";
+    } else if (layout == LayoutType::aosoa) {
+        printer->add_line("int pnodecount = ml->_nodecount_padded;");
+        stride = "*{}"_format(layout_block_width);
     }
 
     printer->add_line("Datum* indexes = ml->pdata;");
@@ -3077,8 +3555,9 @@ void CodegenCVisitor::print_instance_variable_setup() {
             auto device_variable = get_variable_device_pointer(variable, float_type_pointer);
             printer->add_line("inst->{} = {};"_format(name, device_variable));
         } else {
-            printer->add_line("inst->{} = setup_range_variable(ml->data+{}{}, pnodecount);"_format(
-                name, id, stride));
+            auto variable = "ml->data+{}{}"_format(id, stride);
+            printer->add_line("inst->{} = setup_range_variable<{}>({}, pnodecount);"_format(
+                name, range_var_type, variable));
             variables_to_free.push_back(name);
         }
         id += var->get_length();
@@ -3174,7 +3653,7 @@ void CodegenCVisitor::print_global_function_common_code(BlockType type) {
     printer->add_line(
         "{}double* {}voltage = nt->_actual_v;"_format(k_const(), ptr_type_qualifier()));
 
-    if (type == BlockType::Equation) {
+    if (type == BlockType::Equation || type == BlockType::StateEquation) {
         printer->add_line("double* {} vec_rhs = nt->_actual_rhs;"_format(ptr_type_qualifier()));
         printer->add_line("double* {} vec_d = nt->_actual_d;"_format(ptr_type_qualifier()));
         print_rhs_d_shadow_variables();
@@ -3186,13 +3665,43 @@ void CodegenCVisitor::print_global_function_common_code(BlockType type) {
         printer->add_newline();
         printer->add_line("setup_instance(nt, ml);");
     }
-    // clang-format off
-    printer->add_line("{0}* {1}inst = ({0}*) ml->instance;"_format(instance_struct(), ptr_type_qualifier()));
-    // clang-format on
+    if (aligned_range_variables()) {
+        print_aligned_instance_variables();
+    } else {
+        // clang-format off
+        printer->add_line("{0}* {1}inst = ({0}*) ml->instance;"_format(instance_struct(), ptr_type_qualifier()));
+        // clang-format on
+    }
     printer->add_newline(1);
 }
 
 
+/**
+ * \details Range variables point into \c ml->data which is aligned by the simulator, and
+ * the padded node count is a multiple of the SIMD width, so for a SIMD width of 8:
+ *
+ * \code{.cpp}
+ *  hh_Instance inst_aligned = *(hh_Instance*) ml->instance;
+ *  inst_aligned.m = (double*) nmodl_assume_aligned(inst_aligned.m, 64);
+ *  hh_Instance* __restrict__ inst = &inst_aligned;
+ * \endcode
+ */
+void CodegenCVisitor::print_aligned_instance_variables() {
+    auto alignment = instance_data_alignment();
+    auto instance = instance_struct();
+    printer->add_line("{0} inst_aligned = *({0}*) ml->instance;"_format(instance));
+    for (auto& var: codegen_float_variables) {
+        auto name = var->get_name();
+        auto type = get_range_var_float_type(var);
+        auto qualifier = is_constant_variable(name) ? k_const() : "";
+        auto pointer = "inst_aligned.{}"_format(name);
+        printer->add_line("{0} = ({1}{2}*) nmodl_assume_aligned({0}, {3});"_format(
+            pointer, qualifier, type, alignment));
+    }
+    printer->add_line("{0}* {1}inst = &inst_aligned;"_format(instance, ptr_type_qualifier()));
+}
+
+
 void CodegenCVisitor::print_nrn_init(bool skip_init_check) {
     codegen = true;
     printer->add_newline(2);
@@ -3762,7 +4271,9 @@ void CodegenCVisitor::print_derivimplicit_kernel(Block* block) {
     auto list_num = info.derivimplicit_list_num;
     auto block_name = block->get_node_name();
     auto primes_size = info.primes_size;
-    auto stride = (layout == LayoutType::aos) ? "" : "*pnodecount+id";
+    std::string stride = (layout == LayoutType::aos) ? "" : "*pnodecount+id";
+    // newton workspace is never blocked, only data is
+    auto data_stride = (layout == LayoutType::aosoa) ? "*{}"_format(layout_block_width) : stride;
 
     printer->add_newline(2);
 
@@ -3780,7 +4291,7 @@ void CodegenCVisitor::print_derivimplicit_kernel(Block* block) {
     printer->add_line(slist2);
     printer->add_line(dlist2);
     printer->add_line("for (int i=0; i<{}; i++) {}"_format(info.num_primes, "{"));
-    printer->add_line("    savstate{}[i{}] = data[slist{}[i]{}];"_format(list_num, stride, list_num, stride));
+    printer->add_line("    savstate{}[i{}] = data[slist{}[i]{}];"_format(list_num, stride, list_num, data_stride));
     printer->add_line("}");
 
     auto argument = "{}, slist{}, _derivimplicit_{}_{}, dlist{}, {}"_format(primes_size, list_num+1, block_name, suffix, list_num + 1, ext_args);
@@ -3809,10 +4320,10 @@ void CodegenCVisitor::print_derivimplicit_kernel(Block* block) {
     printer->add_line("int counter = -1;");
     printer->add_line("for (int i=0; i<{}; i++) {}"_format(info.num_primes, "{"));
     printer->add_line("    if (*deriv{}_advance(thread)) {}"_format(list_num, "{"));
-    printer->add_line("        dlist{0}[(++counter){1}] = data[dlist{2}[i]{1}]-(data[slist{2}[i]{1}]-savstate{2}[i{1}])/dt;"_format(list_num + 1, stride, list_num));
+    printer->add_line("        dlist{0}[(++counter){1}] = data[dlist{2}[i]{3}]-(data[slist{2}[i]{3}]-savstate{2}[i{1}])/dt;"_format(list_num + 1, stride, list_num, data_stride));
     printer->add_line("    }");
     printer->add_line("    else {");
-    printer->add_line("        dlist{0}[(++counter){1}] = data[slist{2}[i]{1}]-savstate{2}[i{1}];"_format(list_num + 1, stride, list_num));
+    printer->add_line("        dlist{0}[(++counter){1}] = data[slist{2}[i]{3}]-savstate{2}[i{1}];"_format(list_num + 1, stride, list_num, data_stride));
     printer->add_line("    }");
     printer->add_line("}");
     printer->add_line("return 0;");
@@ -3855,59 +4366,289 @@ void CodegenCVisitor::visit_solution_expression(SolutionExpression* node) {
 /****************************************************************************************/
 
 
-void CodegenCVisitor::print_nrn_state() {
-    if (!nrn_state_required()) {
-        return;
+ast::EigenNewtonSolverBlock* CodegenCVisitor::newton_batch_solver_block() {
+    if (newton_batch_size <= 1 || newton_method != "newton" ||
+        info.nrn_state_block == nullptr || ion_variable_struct_required() ||
+        (info.currents.empty() && info.breakpoint_node != nullptr)) {
+        return nullptr;
     }
-    codegen = true;
+    // nrn_state block => solution expression => derivative block => newton solver block
+    const auto& statements = info.nrn_state_block->get_solve_statements();
+    if (statements.size() != 1 || !statements[0]->is_expression_statement()) {
+        return nullptr;
+    }
+    auto expression = std::dynamic_pointer_cast<ast::ExpressionStatement>(statements[0])
+                          ->get_expression();
+    if (!expression->is_solution_expression()) {
+        return nullptr;
+    }
+    auto block = std::dynamic_pointer_cast<ast::SolutionExpression>(expression)
+                     ->get_node_to_solve();
+    if (!block->is_statement_block()) {
+        return nullptr;
+    }
+    const auto& block_statements =
+        std::dynamic_pointer_cast<ast::StatementBlock>(block)->get_statements();
+    if (block_statements.size() != 1 || !block_statements[0]->is_expression_statement()) {
+        return nullptr;
+    }
+    auto solver = std::dynamic_pointer_cast<ast::ExpressionStatement>(block_statements[0])
+                      ->get_expression();
+    if (!solver->is_eigen_newton_solver_block()) {
+        return nullptr;
+    }
+    return dynamic_cast<ast::EigenNewtonSolverBlock*>(solver.get());
+}
 
-    printer->add_newline(2);
-    printer->add_line("/** update state */");
-    print_global_function_common_code(BlockType::State);
-    print_channel_iteration_tiling_block_begin(BlockType::State);
-    print_channel_iteration_block_begin(BlockType::State);
-    print_post_channel_iteration_common_code();
 
+/**
+ * \details Instead of solving each instance with a separate call to the Newton
+ * solver, all instances of a batch are solved together:
+ *
+ * \code{.cpp}
+ *  struct functor { ... };
+ *  for (int batch = start; batch < end; batch += 8) {
+ *      int batch_end = (batch+8) < end ? (batch+8) : end;
+ *      Eigen::Matrix<double, 3, 8, Eigen::RowMajor> X_batch;
+ *      functor newton_functors[8];
+ *      for (int id = batch; id < batch_end; id++) {
+ *          // setup initial guess and functor of lane id-batch
+ *      }
+ *      nmodl::newton::newton_solver_batch(X_batch, newton_functors, ...);
+ *      for (int id = batch; id < batch_end; id++) {
+ *          // update states of lane id-batch
+ *      }
+ *  }
+ * \endcode
+ *
+ * Only the linear solves of the Newton steps run in lock-step over the lanes,
+ * functors are evaluated one lane at a time. With the OpenMP backend, every
+ * task processes exactly one batch (see CodegenOmpVisitor).
+ */
+void CodegenCVisitor::print_nrn_state_newton_batch(ast::EigenNewtonSolverBlock* node) {
+    std::string X = find_var_unique_name("X");
+    auto X_batch = X + "_batch";
+    auto float_type = default_float_data_type();
+    int N = node->get_n_state_vars()->get_value();
+    int W = newton_batch_size;
+
+    print_newton_functor(node, true);
+    printer->add_newline();
+
+    printer->start_block("for (int batch = start; batch < end; batch += {}) "_format(W));
+    printer->add_line("int batch_end = (batch+{0}) < end ? (batch+{0}) : end;"_format(W));
+    printer->add_line(
+        "Eigen::Matrix<{}, {}, {}, Eigen::RowMajor> {};"_format(float_type, N, W, X_batch));
+    printer->add_line("functor newton_functors[{}];"_format(W));
+    printer->add_line("int newton_iterations[{}];"_format(W));
+
+    // setup initial guess and functor for every lane
+    printer->start_block("for (int id = batch; id < batch_end; id++) ");
+    print_post_channel_iteration_common_code();
     printer->add_line("int node_id = node_index[id];");
     printer->add_line("double v = voltage[node_id];");
+    for (auto& statement: ion_read_statements(BlockType::State)) {
+        printer->add_line(statement);
+    }
+    printer->add_line("Eigen::Matrix<{}, {}, 1> {};"_format(float_type, N, X));
+    print_statement_block(node->get_setup_x_block().get(), false, false);
+    printer->add_line("{}.col(id-batch) = {};"_format(X_batch, X));
+    printer->add_line(
+        "newton_functors[id-batch] = functor(nt, inst, id, pnodecount, v, indexes);");
+    printer->add_line("newton_functors[id-batch].initialize();");
+    printer->end_block(1);
 
-    /**
-     * \todo Eigen solver node also emits IonCurVar variable in the functor
-     * but that shouldn't update ions in derivative block
-     */
-    if (ion_variable_struct_required()) {
-        print_ion_variable();
+    // solve all lanes in lock-step
+    printer->add_line("// call batched newton solver");
+    printer->add_line(
+        "nmodl::newton::newton_solver_batch({}, newton_functors, batch_end-batch, newton_iterations{});"_format(
+            X_batch, newton_tolerance_arguments()));
+
+    // assign newton solver results to state vars of every lane
+    printer->start_block("for (int id = batch; id < batch_end; id++) ");
+    print_post_channel_iteration_common_code();
+    printer->add_line("Eigen::Matrix<{0}, {1}, 1> {2} = {3}.col(id-batch);"_format(
+        float_type, N, X, X_batch));
+    print_newton_stats_record("newton_iterations[id-batch]", X, "newton_functors[id-batch]");
+    print_statement_block(node->get_update_states_block().get(), false, false);
+    printer->add_line("newton_functors[id-batch].finalize();");
+    for (auto& statement: ion_write_statements(BlockType::State)) {
+        auto text = process_shadow_update_statement(statement, BlockType::State);
+        printer->add_line(text);
     }
+    printer->end_block(1);
 
-    auto read_statements = ion_read_statements(BlockType::State);
-    for (auto& statement: read_statements) {
-        printer->add_line(statement);
+    printer->end_block(1);
+}
+
+
+/**
+ * \details Expressions depending only on global variables are replaced by variables
+ * declared before the instance loop, e.g. for an inlined rate procedure:
+ *
+ * \code{.cpp}
+ *  const double inv0 = pow(3.0, ((celsius - 6.3) / 10.0));
+ *  for (int id = start; id < end; id++) {
+ *      ...
+ *      inst->mtau[id] = 1.0 / (inv0 * (alpha + beta));
+ *  }
+ * \endcode
+ *
+ * Structurally identical expressions share one variable.
+ */
+void CodegenCVisitor::find_loop_invariants() {
+    loop_invariants.clear();
+    loop_invariant_names.clear();
+    if (!hoist_invariants) {
+        return;
     }
 
-    if (info.nrn_state_block) {
-        info.nrn_state_block->visit_children(*this);
+    // names must not clash with LOCAL variables of nested blocks printed in the loop body
+    auto breakpoint = info.breakpoint_node;
+    std::set<std::string> used_names;
+    for (ast::Ast* block: {static_cast<ast::Ast*>(info.nrn_state_block),
+                           static_cast<ast::Ast*>(breakpoint)}) {
+        if (block != nullptr) {
+            for (const auto& name: AstLookupVisitor().lookup(block, AstNodeType::NAME)) {
+                used_names.insert(name->get_node_name());
+            }
+        }
     }
 
-    if (info.currents.empty() && info.breakpoint_node != nullptr) {
-        auto block = info.breakpoint_node->get_statement_block();
-        print_statement_block(block.get(), false, false);
+    std::map<std::string, std::size_t> index_by_text;
+    int counter = 0;
+    auto add_invariants = [&](ast::Ast* block, bool state) {
+        CodegenLoopInvariantVisitor v;
+        for (const auto& expression: v.find_invariants(block, program_symtab)) {
+            auto text = to_nmodl(expression.get());
+            auto it = index_by_text.find(text);
+            if (it == index_by_text.end()) {
+                std::string name;
+                do {
+                    name = "inv{}"_format(counter++);
+                } while (program_symtab->lookup_in_scope(name) != nullptr ||
+                         used_names.count(name) != 0);
+                LoopInvariant invariant;
+                invariant.name = name;
+                invariant.expression = expression;
+                it = index_by_text.emplace(text, loop_invariants.size()).first;
+                loop_invariants.push_back(invariant);
+                logger->debug("CodegenCVisitor : hoisting {} out of instance loop", text);
+            }
+            auto& invariant = loop_invariants[it->second];
+            if (state) {
+                invariant.in_state = true;
+            } else {
+                invariant.in_breakpoint = true;
+            }
+            loop_invariant_names[expression.get()] = invariant.name;
+        }
+    };
+
+    if (info.nrn_state_block != nullptr && newton_batch_solver_block() == nullptr) {
+        add_invariants(info.nrn_state_block, true);
+    }
+    // breakpoint block is printed inline with conductances or in nrn_state without currents
+    if (breakpoint != nullptr && (!info.conductances.empty() || info.currents.empty())) {
+        add_invariants(breakpoint, false);
     }
+}
 
-    auto write_statements = ion_write_statements(BlockType::State);
-    for (auto& statement: write_statements) {
-        auto text = process_shadow_update_statement(statement, BlockType::State);
-        printer->add_line(text);
+
+void CodegenCVisitor::print_loop_invariants(BlockType type) {
+    declared_loop_invariants.clear();
+    bool state = type == BlockType::State || type == BlockType::StateEquation;
+    bool breakpoint = type == BlockType::Equation || type == BlockType::StateEquation ||
+                      (type == BlockType::State && info.currents.empty());
+    for (const auto& invariant: loop_invariants) {
+        if (!(state && invariant.in_state) && !(breakpoint && invariant.in_breakpoint)) {
+            continue;
+        }
+        printer->add_indent();
+        printer->add_text(
+            "{}{} {} = "_format(k_const(), default_float_data_type(), invariant.name));
+        invariant.expression->accept(*this);
+        printer->add_text(";");
+        printer->add_newline();
+        declared_loop_invariants.insert(invariant.name);
+    }
+}
+
+
+bool CodegenCVisitor::print_loop_invariant_name(ast::Ast* node) {
+    auto it = loop_invariant_names.find(node);
+    if (it == loop_invariant_names.end() || declared_loop_invariants.count(it->second) == 0) {
+        return false;
+    }
+    printer->add_text(it->second);
+    return true;
+}
+
+
+void CodegenCVisitor::print_nrn_state_tile() {
+    if (auto newton_block = newton_batch_solver_block()) {
+        print_nrn_state_newton_batch(newton_block);
+    } else {
+        print_channel_iteration_block_begin(BlockType::State);
+        print_post_channel_iteration_common_code();
+
+        printer->add_line("int node_id = node_index[id];");
+        printer->add_line("double v = voltage[node_id];");
+
+        /**
+         * \todo Eigen solver node also emits IonCurVar variable in the functor
+         * but that shouldn't update ions in derivative block
+         */
+        if (ion_variable_struct_required()) {
+            print_ion_variable();
+        }
+
+        auto read_statements = ion_read_statements(BlockType::State);
+        for (auto& statement: read_statements) {
+            printer->add_line(statement);
+        }
+
+        if (info.nrn_state_block) {
+            info.nrn_state_block->visit_children(*this);
+        }
+
+        if (info.currents.empty() && info.breakpoint_node != nullptr) {
+            auto block = info.breakpoint_node->get_statement_block();
+            print_statement_block(block.get(), false, false);
+        }
+
+        auto write_statements = ion_write_statements(BlockType::State);
+        for (auto& statement: write_statements) {
+            auto text = process_shadow_update_statement(statement, BlockType::State);
+            printer->add_line(text);
+        }
+        print_channel_iteration_block_end();
     }
-    print_channel_iteration_block_end();
     if (!shadow_statements.empty()) {
         print_shadow_reduction_block_begin();
         print_shadow_reduction_statements();
         print_shadow_reduction_block_end();
     }
+}
+
+
+void CodegenCVisitor::print_nrn_state() {
+    if (!nrn_state_required()) {
+        return;
+    }
+    codegen = true;
+
+    printer->add_newline(2);
+    printer->add_line("/** update state */");
+    print_global_function_common_code(BlockType::State);
+    print_loop_invariants(BlockType::State);
+    print_channel_iteration_tiling_block_begin(BlockType::State);
+    print_nrn_state_tile();
     print_channel_iteration_tiling_block_end();
 
     print_kernel_data_present_annotation_block_end();
     printer->end_block(1);
+    declared_loop_invariants.clear();
     codegen = false;
 }
 
@@ -4034,6 +4775,22 @@ void CodegenCVisitor::print_nrn_cur_kernel(BreakpointBlock* node) {
 }
 
 
+void CodegenCVisitor::print_nrn_cur_tile() {
+    print_channel_iteration_block_begin(BlockType::Equation);
+    print_post_channel_iteration_common_code();
+    print_nrn_cur_kernel(info.breakpoint_node);
+    print_nrn_cur_matrix_shadow_update();
+    print_channel_iteration_block_end();
+
+    if (nrn_cur_reduction_loop_required()) {
+        print_shadow_reduction_block_begin();
+        print_nrn_cur_matrix_shadow_reduction();
+        print_shadow_reduction_statements();
+        print_shadow_reduction_block_end();
+    }
+}
+
+
 void CodegenCVisitor::print_nrn_cur() {
     if (!nrn_cur_required()) {
         return;
@@ -4047,23 +4804,83 @@ void CodegenCVisitor::print_nrn_cur() {
     printer->add_newline(2);
     printer->add_line("/** update current */");
     print_global_function_common_code(BlockType::Equation);
+    print_loop_invariants(BlockType::Equation);
     print_channel_iteration_tiling_block_begin(BlockType::Equation);
-    print_channel_iteration_block_begin(BlockType::Equation);
-    print_post_channel_iteration_common_code();
-    print_nrn_cur_kernel(info.breakpoint_node);
-    print_nrn_cur_matrix_shadow_update();
-    print_channel_iteration_block_end();
+    print_nrn_cur_tile();
+    print_channel_iteration_tiling_block_end();
+    print_kernel_data_present_annotation_block_end();
+    printer->end_block(1);
+    declared_loop_invariants.clear();
+    codegen = false;
+}
 
-    if (nrn_cur_reduction_loop_required()) {
-        print_shadow_reduction_block_begin();
-        print_nrn_cur_matrix_shadow_reduction();
-        print_shadow_reduction_statements();
-        print_shadow_reduction_block_end();
+
+/**
+ * \details \c nrn_state and \c nrn_cur stream all instance variables through memory
+ * one after the other. In a time step, \c nrn_state follows the voltage update and the
+ * next \c nrn_cur reads the very same voltage, so both can be evaluated for a tile of
+ * instances before moving to the next tile:
+ *
+ * \code{.cpp}
+ *  void nrn_state_cur_hh(NrnThread* nt, Memb_list* ml, int type) {
+ *      const int TILE = 256;
+ *      for (int tile = 0; tile < nodecount; tile += TILE) {
+ *          int start = tile;
+ *          int end = (tile+TILE) < nodecount ? (tile+TILE) : nodecount;
+ *          for (int id = start; id < end; id++) {
+ *              // update states
+ *          }
+ *          for (int id = start; id < end; id++) {
+ *              // update currents
+ *          }
+ *      }
+ *  }
+ * \endcode
+ *
+ * The simulator has to opt in by calling this function instead of \c nrn_cur, and by
+ * skipping \c nrn_state of the previous time step (see the comment printed below).
+ * \c nrn_cur and \c nrn_state are still generated and registered as usual.
+ */
+void CodegenCVisitor::print_nrn_state_cur() {
+    if (!nrn_state_cur_required()) {
+        return;
     }
+    codegen = true;
+
+    printer->add_newline(2);
+    printer->add_line("/**");
+    printer->add_line(" * update state and current tile by tile");
+    printer->add_line(" *");
+    printer->add_line(" * Calling contract: replaces nrn_state of time step n followed by");
+    printer->add_line(" * nrn_cur of time step n+1, both reading the voltage computed by the");
+    printer->add_line(" * solve of step n. Call it in place of nrn_cur, i.e. after events are");
+    printer->add_line(" * delivered and after rhs and d are initialized, and don't call");
+    printer->add_line(" * nrn_state in step n. After initialization call nrn_cur for the first");
+    printer->add_line(" * step, and call nrn_state once after the last step. States are updated");
+    printer->add_line(" * with the time of the current evaluation, i.e. half a time step later");
+    printer->add_line(" * than by nrn_state.");
+    printer->add_line(" */");
+    print_global_function_common_code(BlockType::StateEquation);
+    print_loop_invariants(BlockType::StateEquation);
+
+    // keep every tile aligned by rounding the tile size to full SIMD width
+    auto tile_size = fused_tile_size;
+    if (aligned_range_variables()) {
+        tile_size = (tile_size + simd_width - 1) / simd_width * simd_width;
+    }
+    printer->add_line("const int TILE = {};"_format(tile_size));
+    printer->start_block("for (int tile = 0; tile < nodecount; tile += TILE) ");
+    printer->add_line("int start = tile;");
+    printer->add_line("int end = (tile+TILE) < nodecount ? (tile+TILE) : nodecount;");
+    print_channel_iteration_task_begin(BlockType::Equation);
+    print_nrn_state_tile();
+    print_nrn_cur_tile();
+    print_channel_iteration_task_end();
+    printer->end_block(1);
 
-    print_channel_iteration_tiling_block_end();
     print_kernel_data_present_annotation_block_end();
     printer->end_block(1);
+    declared_loop_invariants.clear();
     codegen = false;
 }
 
@@ -4132,6 +4949,7 @@ void CodegenCVisitor::print_compute_functions() {
     print_nrn_init();
     print_nrn_cur();
     print_nrn_state();
+    print_nrn_state_cur();
 }
 
 
@@ -4168,6 +4986,68 @@ void CodegenCVisitor::set_codegen_global_variables(std::vector<SymbolType>& glob
 }
 
 
+void CodegenCVisitor::set_newton_batch_size(int size) {
+    newton_batch_size = size;
+}
+
+
+void CodegenCVisitor::set_sparse_lu(bool enable) {
+    sparse_lu = enable;
+}
+
+
+void CodegenCVisitor::set_newton_stats(bool enable) {
+    newton_stats = enable;
+}
+
+
+void CodegenCVisitor::set_vector_math(const std::string& accuracy) {
+    vector_math = accuracy;
+}
+
+
+void CodegenCVisitor::set_interleaved_tables(bool enable) {
+    interleaved_tables = enable;
+}
+
+
+void CodegenCVisitor::set_fused_tile_size(int size) {
+    fused_tile_size = size;
+}
+
+
+void CodegenCVisitor::set_layout_block_width(int width) {
+    layout_block_width = width;
+}
+
+
+void CodegenCVisitor::set_simd_width(int width) {
+    simd_width = width;
+}
+
+
+void CodegenCVisitor::set_mixed_precision(const std::vector<std::string>& variables) {
+    mixed_precision = true;
+    requested_reduced_precision_variables = variables;
+}
+
+
+void CodegenCVisitor::set_hoist_invariants(bool enable) {
+    hoist_invariants = enable;
+}
+
+
+void CodegenCVisitor::set_newton_method(const std::string& method,
+                                        double atol,
+                                        double rtol,
+                                        int max_iter) {
+    newton_method = method;
+    newton_atol = atol;
+    newton_rtol = rtol;
+    newton_max_iter = max_iter;
+}
+
+
 void CodegenCVisitor::setup(Program* node) {
     program_symtab = node->get_symbol_table();
 
@@ -4182,6 +5062,8 @@ void CodegenCVisitor::setup(Program* node) {
     codegen_float_variables = get_float_variables();
     codegen_int_variables = get_int_variables();
     codegen_shadow_variables = get_shadow_variables();
+    select_reduced_precision_variables();
+    find_loop_invariants();
 
     update_index_semantics();
     rename_function_arguments();
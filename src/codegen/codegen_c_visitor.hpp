@@ -18,6 +18,9 @@
 #include <algorithm>
 #include <cmath>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -26,6 +29,7 @@
 
 #include "codegen/codegen_info.hpp"
 #include "codegen/codegen_naming.hpp"
+#include "codegen/codegen_sparse_lu.hpp"
 #include "printer/code_printer.hpp"
 #include "symtab/symbol_table.hpp"
 #include "visitors/ast_visitor.hpp"
@@ -69,7 +73,10 @@ enum class BlockType {
     Watch,
 
     /// net_receive block
-    NetReceive
+    NetReceive,
+
+    /// derivative block followed by breakpoint block (fused kernel)
+    StateEquation
 };
 
 
@@ -138,7 +145,11 @@ enum class LayoutType {
     aos,
 
     /// structure of array
-    soa
+    soa,
+
+    /// array of structure of arrays: blocks of CodegenCVisitor::layout_block_width
+    /// instances, each block laid out as structure of array
+    aosoa
 };
 
 
@@ -157,6 +168,27 @@ struct ShadowUseStatement {
     std::string rhs;
 };
 
+
+/**
+ * \class LoopInvariant
+ * \brief Represents expression evaluated once before the instance loop
+ *
+ * See CodegenLoopInvariantVisitor for expressions that are loop invariant.
+ */
+struct LoopInvariant {
+    /// name of the variable holding the value
+    std::string name;
+
+    /// invariant expression
+    std::shared_ptr<ast::Expression> expression;
+
+    /// if expression appears in the nrn_state block
+    bool in_state = false;
+
+    /// if expression appears in the breakpoint block
+    bool in_breakpoint = false;
+};
+
 /** @} */  // end of codegen_details
 
 
@@ -266,6 +298,107 @@ class CodegenCVisitor: public visitor::AstVisitor {
      */
     LayoutType layout;
 
+    /**
+     * Number of instances per block in LayoutType::aosoa layout
+     */
+    int layout_block_width = 8;
+
+    /**
+     * Number of instances solved in lock-step by batched Newton solver (disabled if <= 1)
+     */
+    int newton_batch_size = 0;
+
+    /**
+     * Solve linear systems of Eigen solver blocks with sparse LU factorization
+     */
+    bool sparse_lu = false;
+
+    /**
+     * Record convergence statistics of every Newton solver call
+     */
+    bool newton_stats = false;
+
+    /**
+     * Newton solver variant: "newton", "chord" or "damped"
+     */
+    std::string newton_method = "newton";
+
+    /**
+     * Absolute tolerance for residual of Newton solver
+     */
+    double newton_atol = 1e-12;
+
+    /**
+     * Relative tolerance for residual of Newton solver (disabled if 0)
+     */
+    double newton_rtol = 0.;
+
+    /**
+     * Maximum number of Newton solver iterations
+     */
+    int newton_max_iter = 1000;
+
+    /**
+     * Accuracy of vectorizable math functions replacing exp, expm1, log and pow:
+     * "off" (use libm), "precise" or "approx" (relative error below 1e-7, see
+     * fast_math.hpp)
+     */
+    std::string vector_math = "off";
+
+    /**
+     * Store all variables of a TABLE in one row-major array (one row per table
+     * point) and look up with branch-free clamped index computation
+     */
+    bool interleaved_tables = false;
+
+    /**
+     * Number of instances per tile of fused \c nrn_state_cur kernel, 0 if the
+     * fused kernel is not generated
+     */
+    int fused_tile_size = 0;
+
+    /**
+     * Number of double precision SIMD lanes that instance arrays are aligned and
+     * padded to, alignment annotations are disabled if <= 1
+     */
+    int simd_width = 0;
+
+    /**
+     * Store selected range variables and their table data in reduced precision
+     */
+    bool mixed_precision = false;
+
+    /**
+     * Variables requested in reduced precision, selected by a heuristic if empty
+     */
+    std::vector<std::string> requested_reduced_precision_variables;
+
+    /**
+     * Names of range variables stored in codegen::naming::REDUCED_FLOAT_TYPE
+     */
+    std::set<std::string> reduced_precision_variables;
+
+    /**
+     * Evaluate loop invariant expressions once before the instance loops of
+     * \c nrn_state and \c nrn_cur
+     */
+    bool hoist_invariants = false;
+
+    /**
+     * Loop invariant expressions of kernels, with unique names
+     */
+    std::vector<LoopInvariant> loop_invariants;
+
+    /**
+     * Name of the loop invariant variable replacing an expression node
+     */
+    std::map<const ast::Ast*, std::string> loop_invariant_names;
+
+    /**
+     * Loop invariant variables declared in the kernel currently being printed
+     */
+    std::set<std::string> declared_loop_invariants;
+
     /**
      * All ast information for code generation
      */
@@ -460,6 +593,17 @@ class CodegenCVisitor: public visitor::AstVisitor {
     bool nrn_cur_required();
 
 
+    /**
+     * Check if fused nrn_state_cur function is required
+     *
+     * The fused kernel is only generated if enabled and if the mechanism has both
+     * kernels, no \c NET_RECEIVE block (events must be delivered before states are
+     * updated) and doesn't write ion concentrations in \c nrn_state (other mechanisms
+     * read them in their \c nrn_cur).
+     */
+    bool nrn_state_cur_required();
+
+
     /**
      * Check if net_receive function is required
      */
@@ -479,6 +623,87 @@ class CodegenCVisitor: public visitor::AstVisitor {
     bool range_variable_setup_required();
 
 
+    /**
+     * Alignment in bytes of instance arrays
+     *
+     * Default alignment of \c mem_alloc, at least 16 and the size of a SIMD
+     * register of CodegenCVisitor::simd_width double precision lanes.
+     */
+    int instance_data_alignment() const;
+
+
+    /**
+     * Check if compute kernels can assume aligned range variables
+     *
+     * With structure of array layout (and with array of structure of arrays layout if
+     * the block width is a multiple of the SIMD width) every range variable starts at
+     * a multiple of the padded node count in the aligned data array.
+     */
+    bool aligned_range_variables() const;
+
+
+    /**
+     * Check if range variable can be stored in reduced precision
+     *
+     * State variables, ion and pointer variables (shared with the simulator or other
+     * mechanisms) and arrays always use the default float type.
+     */
+    bool reduced_precision_allowed(const SymbolType& symbol) const;
+
+
+    /**
+     * Select range variables stored in reduced precision
+     *
+     * Without explicitly requested variables, rate intermediates are selected: ASSIGNED
+     * range variables which are assigned in a PROCEDURE or FUNCTION and are not currents,
+     * e.g. \c minf and \c mtau computed by \c rates in Hodgkin-Huxley type channels.
+     * Requested names that are not range variables of the mechanism, or can't be stored
+     * in reduced precision, are reported with a warning and ignored.
+     */
+    void select_reduced_precision_variables();
+
+
+    /**
+     * Find loop invariant expressions of nrn_state and breakpoint blocks
+     *
+     * Only blocks printed inline in the instance loop are considered, i.e. the breakpoint
+     * block is skipped if it's printed as \c nrn_current function.
+     */
+    void find_loop_invariants();
+
+
+    /**
+     * Print declarations of loop invariant variables used in the given kernel
+     * \param type nrn_state (State), nrn_cur (Equation) or nrn_state_cur (StateEquation)
+     */
+    void print_loop_invariants(BlockType type);
+
+
+    /**
+     * Print name of loop invariant variable if the given expression is replaced by it
+     * \return \c true if the name was printed
+     */
+    bool print_loop_invariant_name(ast::Ast* node);
+
+
+    /**
+     * Data type of table of a TABLE variable
+     *
+     * Reduced precision if the variable is stored in reduced precision.
+     * \param name name of the table variable
+     */
+    std::string table_data_type(const std::string& name);
+
+
+    /**
+     * Data type of interleaved table of function or procedure
+     *
+     * Reduced precision if all variables of the table are stored in reduced precision.
+     * \param node function or procedure with TABLE statement
+     */
+    std::string interleaved_table_data_type(ast::Block* node);
+
+
     /**
      * Check if net_receive node exist
      */
@@ -581,6 +806,19 @@ class CodegenCVisitor: public visitor::AstVisitor {
     virtual std::string float_to_string(float value);
 
 
+    /**
+     * Offset of the first variable of instance \c id in LayoutType::aosoa layout
+     *
+     * Instance \c id is lane \c id%W of block \c id/W, where \c W is the block width.
+     * Every block stores \a num_vars variables of \c W instances in structure of array
+     * layout, i.e. variable \c k of the instance is found \c k*W elements after the offset.
+     *
+     * \param num_vars number of variables per instance
+     * \return         expression for the offset in the data array
+     */
+    std::string aosoa_instance_offset(int num_vars) const;
+
+
     /**
      * Determine the name of a \c float variable given its symbol
      *
@@ -1185,6 +1423,16 @@ class CodegenCVisitor: public visitor::AstVisitor {
     virtual void print_global_method_annotation();
 
 
+    /**
+     * Name of math function in generated code
+     *
+     * Returns the vectorizable implementation from fast_math.hpp for exp, expm1, log and
+     * pow if enabled with CodegenCVisitor::set_vector_math, otherwise \a name.
+     * \param name name of the function in the mod file
+     */
+    std::string math_function_name(const std::string& name) const;
+
+
     /**
      * Print call to internal or external function
      * \param node The AST node representing a function call
@@ -1452,6 +1700,79 @@ class CodegenCVisitor: public visitor::AstVisitor {
     std::string process_shadow_update_statement(ShadowUseStatement& statement, BlockType type);
 
 
+    /**
+     * Find Newton solver block that can be solved for multiple instances in lock-step
+     *
+     * Batching is possible if the state update consists of a single derivative block
+     * which is entirely represented by an ast::EigenNewtonSolverBlock and the full
+     * Newton method is used.
+     *
+     * \return Newton solver block of \c nrn\_state or \c nullptr if not batched
+     */
+    ast::EigenNewtonSolverBlock* newton_batch_solver_block();
+
+
+    /**
+     * Symbolic sparse LU factorization of the Jacobian assigned in given block
+     *
+     * The sparsity pattern is deduced from the assignments to the Jacobian generated by
+     * nmodl::visitor::SympySolverVisitor, which assigns all entries including zero ones.
+     *
+     * \param node the statement block assigning the Jacobian
+     * \param J    name of the (flat) Jacobian array
+     * \param N    number of state variables
+     * \return     factorization or \c nullptr if sparse LU is disabled or not applicable
+     */
+    std::unique_ptr<codegen::SparseLU> sparse_lu_factorization(ast::StatementBlock* node,
+                                                               const std::string& J,
+                                                               int N);
+
+
+    /**
+     * Print definition of functor evaluating \c F(X) and \c J(X) for Newton solver
+     * \param node              the AST node representing the Newton solver block
+     * \param default_ctor      \c true if functor should be default constructible
+     * \param sparse_solver     if not \c nullptr, functor provides \c solve method using
+     *                          this factorization for newton::newton_sparse_solver
+     */
+    void print_newton_functor(ast::EigenNewtonSolverBlock* node,
+                              bool default_ctor,
+                              const codegen::SparseLU* sparse_solver = nullptr);
+
+
+    /**
+     * Print main body of nrn_state function with batched Newton solver
+     *
+     * Instances are processed in batches of CodegenCVisitor::newton_batch_size: the initial
+     * guess and functor of every instance are set up first, then all instances of the batch
+     * are solved in lock-step with newton::newton_solver_batch and the states are updated.
+     *
+     * \param node the AST node representing the Newton solver block
+     */
+    void print_nrn_state_newton_batch(ast::EigenNewtonSolverBlock* node);
+
+
+    /**
+     * Arguments following solution vector and functor of Newton solver call
+     *
+     * Empty if convergence criteria are the defaults of newton::newton_solver.
+     */
+    std::string newton_tolerance_arguments() const;
+
+
+    /**
+     * Print statement recording convergence statistics of a Newton solver call
+     *
+     * Nothing is printed if statistics are disabled (see CodegenCVisitor::newton_stats).
+     * \param iterations expression for iteration count returned by the solver
+     * \param X          name of the solution vector
+     * \param functor    expression for the functor used by the solver
+     */
+    void print_newton_stats_record(const std::string& iterations,
+                                   const std::string& X,
+                                   const std::string& functor);
+
+
     /**
      * Print main body of nrn_cur function
      * \param node the AST node representing the NMODL breakpoint block
@@ -1516,6 +1837,16 @@ class CodegenCVisitor: public visitor::AstVisitor {
     virtual void print_global_function_common_code(BlockType type);
 
 
+    /**
+     * Print local copy of instance structure with alignment assumptions
+     *
+     * Alignment of pointers stored in the shared instance structure is not known to the
+     * compiler. The copy is scalarized by the compiler and its range variable pointers
+     * carry the alignment, so loops are vectorized without peeling.
+     */
+    void print_aligned_instance_variables();
+
+
     /**
      * Print the mechanism registration function
      *
@@ -1706,12 +2037,35 @@ class CodegenCVisitor: public visitor::AstVisitor {
     void print_nrn_state();
 
 
+    /**
+     * Print loops updating the states of instances \c start to \c end
+     */
+    void print_nrn_state_tile();
+
+
     /**
      * Print nrn_cur / current update function definition
      */
     void print_nrn_cur();
 
 
+    /**
+     * Print loops updating the currents of instances \c start to \c end
+     */
+    void print_nrn_cur_tile();
+
+
+    /**
+     * Print fused nrn_state_cur function
+     *
+     * Instances are processed in tiles of CodegenCVisitor::fused_tile_size instances and
+     * the state update of a tile is immediately followed by its current update, so that
+     * variables of the tile are still in cache. See the comment printed with the function
+     * for the calling contract.
+     */
+    void print_nrn_state_cur();
+
+
     /**
      * Print kernel for buffering net_receive events
      *
@@ -1748,6 +2102,14 @@ class CodegenCVisitor: public visitor::AstVisitor {
     void print_table_replacement_function(ast::Block* node);
 
 
+    /**
+     * Print branch-free interpolation in interleaved table
+     * \param node The AST node representing a function or procedure block
+     * \param with Number of table intervals
+     */
+    void print_interleaved_table_lookup(ast::Block* node, int with);
+
+
     /**
      * Print NMODL function in target backend code
      * \param node
@@ -1776,6 +2138,78 @@ class CodegenCVisitor: public visitor::AstVisitor {
      */
     void set_codegen_global_variables(std::vector<SymbolType>& global_vars);
 
+    /**
+     * Set number of instances solved in lock-step by batched Newton solver
+     * \param size batch size, typically SIMD width (batching disabled if <= 1)
+     */
+    void set_newton_batch_size(int size);
+
+    /**
+     * Enable sparse LU factorization for Eigen solver blocks
+     * \param enable \c true if straight-line sparse LU code should replace dense LU
+     */
+    void set_sparse_lu(bool enable);
+
+    /**
+     * Enable convergence statistics of Newton solver calls
+     * \param enable \c true if iteration counts and residuals should be recorded per mechanism
+     */
+    void set_newton_stats(bool enable);
+
+    /**
+     * Set Newton solver variant and convergence criteria
+     * \param method   one of "newton", "chord" (reuse factorization of Jacobian) or "damped"
+     *                 (backtracking line search)
+     * \param atol     absolute tolerance for residual
+     * \param rtol     relative tolerance for residual
+     * \param max_iter maximum number of iterations
+     */
+    void set_newton_method(const std::string& method, double atol, double rtol, int max_iter);
+
+    /**
+     * Route calls to exp, expm1, log and pow through vectorizable implementations
+     * \param accuracy one of "off", "precise" or "approx"
+     */
+    void set_vector_math(const std::string& accuracy);
+
+    /**
+     * Enable interleaved layout of TABLE variables
+     * \param enable \c true if all variables of a table should be stored row-wise in one array
+     */
+    void set_interleaved_tables(bool enable);
+
+    /**
+     * Enable fused nrn_state_cur kernel
+     * \param size number of instances per tile, 0 to disable the fused kernel
+     */
+    void set_fused_tile_size(int size);
+
+    /**
+     * Set number of instances per block in LayoutType::aosoa layout
+     * \param width block width, typically the number of SIMD lanes
+     */
+    void set_layout_block_width(int width);
+
+    /**
+     * Set number of double precision SIMD lanes for alignment of instance arrays
+     * \param width number of lanes, alignment annotations are disabled if <= 1
+     */
+    void set_simd_width(int width);
+
+    /**
+     * Enable mixed precision code generation
+     * \param variables names of range variables to store in reduced precision, rate
+     *                  intermediates are selected if empty
+     */
+    void set_mixed_precision(const std::vector<std::string>& variables);
+
+    /**
+     * Enable hoisting of loop invariant expressions out of instance loops
+     * \param enable \c true if expressions depending only on global variables should be
+     *               evaluated once per kernel call
+     */
+    void set_hoist_invariants(bool enable);
+
     /**
      * Find unique variable name defined in nmodl::utils::SingletonRandomString by the
      * nmodl::visitor::SympySolverVisitor
@@ -0,0 +1,192 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <set>
+#include <string>
+
+#include "codegen/codegen_loop_invariant_visitor.hpp"
+#include "codegen/codegen_naming.hpp"
+#include "visitors/lookup_visitor.hpp"
+
+
+namespace nmodl {
+namespace codegen {
+
+using symtab::syminfo::NmodlType;
+
+/// math functions without side effects that can be evaluated outside of the instance loop
+static const std::set<std::string> INVARIANT_FUNCTIONS = {
+    "exp", "expm1", "log", "log10", "pow", "sqrt", "fabs", "sin", "cos", "tan", "asin",
+    "acos", "atan", "atan2", "sinh", "cosh", "tanh", "floor", "ceil", "fmod", "fmin", "fmax"};
+
+
+bool CodegenLoopInvariantVisitor::is_invariant_variable(const std::string& name) const {
+    auto symbol = current_symtab->lookup_in_scope(name);
+    if (symbol == nullptr) {
+        return false;
+    }
+    if (symbol->has_any_property(NmodlType::extern_neuron_variable)) {
+        return name == naming::CELSIUS_VARIABLE || name == naming::NTHREAD_DT_VARIABLE ||
+               name == naming::NTHREAD_T_VARIABLE;
+    }
+    // clang-format off
+    const auto global_properties = NmodlType::global_var
+                                   | NmodlType::param_assign
+                                   | NmodlType::constant_var;
+    const auto instance_properties = NmodlType::range_var
+                                     | NmodlType::assigned_definition
+                                     | NmodlType::state_var
+                                     | NmodlType::local_var
+                                     | NmodlType::argument
+                                     | NmodlType::read_ion_var
+                                     | NmodlType::write_ion_var
+                                     | NmodlType::pointer_var
+                                     | NmodlType::bbcore_pointer_var
+                                     | NmodlType::extern_var;
+    // clang-format on
+    return symbol->has_any_property(global_properties) &&
+           !symbol->has_any_property(instance_properties) && symbol->get_write_count() == 0;
+}
+
+
+bool CodegenLoopInvariantVisitor::is_invariant(const std::shared_ptr<ast::Expression>& node,
+                                               bool& has_variable) const {
+    if (node->is_integer() || node->is_float() || node->is_double()) {
+        return true;
+    }
+    if (node->is_name()) {
+        has_variable = true;
+        return is_invariant_variable(node->get_node_name());
+    }
+    if (node->is_var_name()) {
+        auto var = std::static_pointer_cast<ast::VarName>(node);
+        if (var->get_at() != nullptr || var->get_index() != nullptr ||
+            !var->get_name()->is_name()) {
+            return false;
+        }
+        has_variable = true;
+        return is_invariant_variable(var->get_node_name());
+    }
+    if (node->is_binary_expression()) {
+        auto expression = std::static_pointer_cast<ast::BinaryExpression>(node);
+        return expression->get_op().get_value() != ast::BOP_ASSIGN &&
+               is_invariant(expression->get_lhs(), has_variable) &&
+               is_invariant(expression->get_rhs(), has_variable);
+    }
+    if (node->is_wrapped_expression()) {
+        auto expression = std::static_pointer_cast<ast::WrappedExpression>(node);
+        return is_invariant(expression->get_expression(), has_variable);
+    }
+    if (node->is_paren_expression()) {
+        auto expression = std::static_pointer_cast<ast::ParenExpression>(node);
+        return is_invariant(expression->get_expression(), has_variable);
+    }
+    if (node->is_unary_expression()) {
+        auto expression = std::static_pointer_cast<ast::UnaryExpression>(node);
+        return is_invariant(expression->get_expression(), has_variable);
+    }
+    if (node->is_function_call()) {
+        auto name = node->get_node_name();
+        auto symbol = program_symtab->lookup(name);
+        if (INVARIANT_FUNCTIONS.find(name) == INVARIANT_FUNCTIONS.end() ||
+            (symbol != nullptr && !symbol->has_any_property(NmodlType::extern_method))) {
+            return false;
+        }
+        for (const auto& argument: std::static_pointer_cast<ast::FunctionCall>(node)
+                                       ->get_arguments()) {
+            if (!is_invariant(argument, has_variable)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+
+void CodegenLoopInvariantVisitor::find_in_expression(const std::shared_ptr<ast::Expression>& node) {
+    if (node->is_binary_expression() || node->is_function_call()) {
+        bool has_variable = false;
+        if (is_invariant(node, has_variable) && has_variable) {
+            invariants.push_back(node);
+            return;
+        }
+    }
+    if (node->is_binary_expression()) {
+        auto expression = std::static_pointer_cast<ast::BinaryExpression>(node);
+        if (expression->get_op().get_value() != ast::BOP_ASSIGN) {
+            find_in_expression(expression->get_lhs());
+        }
+        find_in_expression(expression->get_rhs());
+    } else if (node->is_wrapped_expression()) {
+        find_in_expression(
+            std::static_pointer_cast<ast::WrappedExpression>(node)->get_expression());
+    } else if (node->is_paren_expression()) {
+        find_in_expression(std::static_pointer_cast<ast::ParenExpression>(node)->get_expression());
+    } else if (node->is_unary_expression()) {
+        find_in_expression(std::static_pointer_cast<ast::UnaryExpression>(node)->get_expression());
+    } else if (node->is_function_call()) {
+        for (const auto& argument: std::static_pointer_cast<ast::FunctionCall>(node)
+                                       ->get_arguments()) {
+            find_in_expression(argument);
+        }
+    }
+}
+
+
+void CodegenLoopInvariantVisitor::visit_statement_block(ast::StatementBlock* node) {
+    auto parent_symtab = current_symtab;
+    if (node->get_symbol_table() != nullptr) {
+        current_symtab = node->get_symbol_table();
+    }
+    node->visit_children(*this);
+    current_symtab = parent_symtab;
+}
+
+
+void CodegenLoopInvariantVisitor::visit_expression_statement(ast::ExpressionStatement* node) {
+    find_in_expression(node->get_expression());
+    node->visit_children(*this);
+}
+
+
+void CodegenLoopInvariantVisitor::visit_if_statement(ast::IfStatement* node) {
+    find_in_expression(node->get_condition());
+    node->visit_children(*this);
+}
+
+
+void CodegenLoopInvariantVisitor::visit_else_if_statement(ast::ElseIfStatement* node) {
+    find_in_expression(node->get_condition());
+    node->visit_children(*this);
+}
+
+
+/// solutions are printed inline only if solved block is a statement block
+void CodegenLoopInvariantVisitor::visit_solution_expression(ast::SolutionExpression* node) {
+    auto block = node->get_node_to_solve();
+    if (block->is_statement_block()) {
+        block->accept(*this);
+    }
+}
+
+
+std::vector<std::shared_ptr<ast::Expression>> CodegenLoopInvariantVisitor::find_invariants(
+    ast::Ast* node,
+    symtab::SymbolTable* symtab) {
+    invariants.clear();
+    if (!visitor::AstLookupVisitor().lookup(node, ast::AstNodeType::VERBATIM).empty()) {
+        return invariants;
+    }
+    program_symtab = symtab;
+    current_symtab = symtab;
+    node->visit_children(*this);
+    return invariants;
+}
+
+}  // namespace codegen
+}  // namespace nmodl
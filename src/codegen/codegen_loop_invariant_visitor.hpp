@@ -0,0 +1,103 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::codegen::CodegenLoopInvariantVisitor
+ */
+
+#include <memory>
+#include <vector>
+
+#include "ast/ast.hpp"
+#include "symtab/symbol_table.hpp"
+#include "visitors/ast_visitor.hpp"
+
+namespace nmodl {
+namespace codegen {
+
+/**
+ * @addtogroup codegen_details
+ * @{
+ */
+
+/**
+ * \class CodegenLoopInvariantVisitor
+ * \brief %Visitor to find expressions that are invariant in the instance loop
+ *
+ * Kernels like `nrn_state` and `nrn_cur` evaluate the statements of a block for
+ * every instance. Rate procedures inlined into these blocks often contain
+ * expressions depending only on global variables, e.g.
+ *
+ * \code{.mod}
+ *      q10 = 3^((celsius-6.3)/10)
+ * \endcode
+ *
+ * Such expressions can be evaluated once before the instance loop. An
+ * expression is loop invariant if it only consists of
+ *   - literals,
+ *   - GLOBAL, PARAMETER (non RANGE) and CONSTANT variables which are never
+ *     written (according to the write counts of PerfVisitor),
+ *   - `celsius`, `dt` and `t`,
+ *   - math functions (like `exp` or `pow`) with loop invariant arguments.
+ *
+ * The visitor returns the largest loop invariant expressions, containing at
+ * least one variable and one operation or function call, in the statements that
+ * are printed inline in the instance loop. Blocks with VERBATIM code as well as
+ * solver blocks printed as separate functions (Newton solver functors,
+ * derivimplicit callbacks) are not considered.
+ */
+class CodegenLoopInvariantVisitor: public visitor::AstVisitor {
+  private:
+    /// global symbol table
+    symtab::SymbolTable* program_symtab = nullptr;
+
+    /// symbol table of the innermost statement block
+    symtab::SymbolTable* current_symtab = nullptr;
+
+    /// loop invariant expressions found so far
+    std::vector<std::shared_ptr<ast::Expression>> invariants;
+
+    /// check if variable keeps its value during the instance loop
+    bool is_invariant_variable(const std::string& name) const;
+
+    /// check if expression is loop invariant, sets has_variable if it reads a variable
+    bool is_invariant(const std::shared_ptr<ast::Expression>& node, bool& has_variable) const;
+
+    /// add largest loop invariant subexpressions of given expression
+    void find_in_expression(const std::shared_ptr<ast::Expression>& node);
+
+  public:
+    CodegenLoopInvariantVisitor() = default;
+
+    /// loop invariant expressions of statements in given block
+    std::vector<std::shared_ptr<ast::Expression>> find_invariants(ast::Ast* node,
+                                                                  symtab::SymbolTable* symtab);
+
+    void visit_statement_block(ast::StatementBlock* node) override;
+
+    void visit_expression_statement(ast::ExpressionStatement* node) override;
+
+    void visit_if_statement(ast::IfStatement* node) override;
+
+    void visit_else_if_statement(ast::ElseIfStatement* node) override;
+
+    void visit_solution_expression(ast::SolutionExpression* node) override;
+
+    void visit_eigen_newton_solver_block(ast::EigenNewtonSolverBlock* /*node*/) override {}
+
+    void visit_eigen_linear_solver_block(ast::EigenLinearSolverBlock* /*node*/) override {}
+
+    void visit_derivimplicit_callback(ast::DerivimplicitCallback* /*node*/) override {}
+};
+
+/** @} */  // end of codegen_details
+
+}  // namespace codegen
+}  // namespace nmodl
@@ -89,9 +89,15 @@ const std::string NTHREAD_T_VARIABLE("t");
 /// dt variable in neuron thread structure
 const std::string NTHREAD_DT_VARIABLE("dt");
 
+/// temperature variable of neuron
+const std::string CELSIUS_VARIABLE("celsius");
+
 /// default float variable type
 const std::string DEFAULT_FLOAT_TYPE("double");
 
+/// float type of variables selected for reduced precision
+const std::string REDUCED_FLOAT_TYPE("float");
+
 /// default local variable type
 const std::string DEFAULT_LOCAL_VAR_TYPE("double");
 
@@ -131,6 +137,9 @@ const std::string NRN_STATE_METHOD("nrn_state");
 /// nrn_cur method in generated code
 const std::string NRN_CUR_METHOD("nrn_cur");
 
+/// fused nrn_state and nrn_cur method in generated code
+const std::string NRN_STATE_CUR_METHOD("nrn_state_cur");
+
 /// nrn_watch_check method in generated c file
 const std::string NRN_WATCH_CHECK_METHOD("nrn_watch_check");
 
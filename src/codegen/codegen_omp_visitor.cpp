@@ -42,7 +42,12 @@ void CodegenOmpVisitor::print_channel_iteration_task_end() {
  * Depending on the backend, print loop for tiling channel iterations
  */
 void CodegenOmpVisitor::print_channel_iteration_tiling_block_begin(BlockType type) {
-    printer->add_line("const int TILE = 3;");
+    // batched newton solver needs a full batch of instances in every task
+    int tile = 3;
+    if (type == BlockType::State && newton_batch_solver_block() != nullptr) {
+        tile = newton_batch_size;
+    }
+    printer->add_line("const int TILE = {};"_format(tile));
     printer->start_block("for (int block = 0; block < nodecount;) ");
     printer->add_line("int start = block;");
     printer->add_line("block = (block+TILE) < nodecount ? (block+TILE) : nodecount;");
@@ -0,0 +1,106 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <utility>
+
+#include "codegen/codegen_sparse_lu.hpp"
+#include "fmt/format.h"
+
+using namespace fmt::literals;
+
+namespace nmodl {
+namespace codegen {
+
+/**
+ * \details Symbolic factorization: eliminating column `k` updates entry `(i, j)`
+ * for every `i, j > k` with non-zero `(i, k)` and `(k, j)`, which may introduce
+ * new non-zero entries (fill-in).
+ */
+SparseLU::SparseLU(int size, std::vector<bool> non_zero)
+    : size(size)
+    , pattern(std::move(non_zero)) {
+    for (int k = 0; k < size; k++) {
+        for (int i = k + 1; i < size; i++) {
+            if (!pattern[index(i, k)]) {
+                continue;
+            }
+            for (int j = k + 1; j < size; j++) {
+                if (pattern[index(k, j)] && !pattern[index(i, j)]) {
+                    pattern[index(i, j)] = true;
+                    n_fill_in++;
+                }
+            }
+        }
+    }
+}
+
+
+std::vector<std::string> SparseLU::factorize_statements(const std::string& matrix) const {
+    std::vector<std::string> statements;
+    for (int k = 0; k < size; k++) {
+        auto pivot = "{}[{}]"_format(matrix, index(k, k));
+        for (int i = k + 1; i < size; i++) {
+            if (!pattern[index(i, k)]) {
+                continue;
+            }
+            auto multiplier = "{}[{}]"_format(matrix, index(i, k));
+            statements.push_back("{0} = {0}/{1};"_format(multiplier, pivot));
+            for (int j = k + 1; j < size; j++) {
+                if (pattern[index(k, j)]) {
+                    statements.push_back("{0}[{1}] = {0}[{1}]-{2}*{0}[{3}];"_format(
+                        matrix, index(i, j), multiplier, index(k, j)));
+                }
+            }
+        }
+    }
+    return statements;
+}
+
+
+std::vector<std::string> SparseLU::solve_statements(const std::string& matrix,
+                                                    const std::string& vector) const {
+    std::vector<std::string> statements;
+    // forward substitution with unit lower triangular factor
+    for (int i = 1; i < size; i++) {
+        for (int k = 0; k < i; k++) {
+            if (pattern[index(i, k)]) {
+                statements.push_back("{0}[{1}] = {0}[{1}]-{2}[{3}]*{0}[{4}];"_format(
+                    vector, i, matrix, index(i, k), k));
+            }
+        }
+    }
+    // backward substitution with upper triangular factor
+    for (int i = size - 1; i >= 0; i--) {
+        for (int j = i + 1; j < size; j++) {
+            if (pattern[index(i, j)]) {
+                statements.push_back("{0}[{1}] = {0}[{1}]-{2}[{3}]*{0}[{4}];"_format(
+                    vector, i, matrix, index(i, j), j));
+            }
+        }
+        statements.push_back("{0}[{1}] = {0}[{1}]/{2}[{3}];"_format(vector, i, matrix, index(i, i)));
+    }
+    return statements;
+}
+
+
+/**
+ * \details The diagonal entry `(k, k)` is not updated after it was used as pivot
+ * for column `k`, so a zero pivot is still zero in the factorized matrix.
+ */
+std::string SparseLU::non_zero_pivots(const std::string& matrix) const {
+    std::string condition;
+    for (int k = 0; k < size; k++) {
+        if (k > 0) {
+            condition += " && ";
+        }
+        condition += "{}[{}] != 0"_format(matrix, index(k, k));
+    }
+    return condition;
+}
+
+}  // namespace codegen
+}  // namespace nmodl
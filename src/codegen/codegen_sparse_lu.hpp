@@ -0,0 +1,99 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::codegen::SparseLU
+ */
+
+#include <string>
+#include <vector>
+
+namespace nmodl {
+namespace codegen {
+
+/**
+ * @addtogroup codegen_details
+ * @{
+ */
+
+/**
+ * \class SparseLU
+ * \brief Symbolic LU factorization of a sparse matrix with static pivot order
+ *
+ * Given the sparsity pattern of a `N x N` matrix known at translation time
+ * (e.g. Jacobian of a kinetic scheme produced by SymPy), this class computes
+ * the pattern of the LU factors including fill-in and generates straight-line
+ * code for the numeric factorization and the triangular solves, touching only
+ * (structurally) non-zero entries.
+ *
+ * Diagonal entries are used as pivots in natural order, i.e. there is no
+ * pivoting at runtime. This is suitable for the diagonally dominant systems
+ * arising from implicit time stepping of kinetic schemes. Other systems (e.g.
+ * with CONSERVE equations or Jacobians of non-linear ODEs) can still hit a zero
+ * pivot at runtime: generated code checks SparseLU::non_zero_pivots after the
+ * factorization and falls back to dense LU with partial pivoting.
+ *
+ * Matrices are stored in column-major order (as `Eigen::Matrix`), so the
+ * entry `(i, j)` is stored at index `i + N * j`.
+ */
+class SparseLU {
+  public:
+    /**
+     * \param size     number of rows / columns of the matrix
+     * \param non_zero sparsity pattern in column-major order (size * size entries)
+     */
+    SparseLU(int size, std::vector<bool> non_zero);
+
+    /// number of entries which are zero in the matrix but non-zero in its LU factors
+    int fill_in() const {
+        return n_fill_in;
+    }
+
+    /**
+     * Statements factorizing matrix in place into unit lower and upper triangular factors
+     * \param matrix name of the (flat) array holding the matrix
+     */
+    std::vector<std::string> factorize_statements(const std::string& matrix) const;
+
+    /**
+     * Statements solving linear system using factorized matrix
+     * \param matrix name of the (flat) array holding the factorized matrix
+     * \param vector name of the vector holding right hand side, overwritten by solution
+     */
+    std::vector<std::string> solve_statements(const std::string& matrix,
+                                              const std::string& vector) const;
+
+    /**
+     * Condition that all pivots of the factorized matrix are non-zero, i.e. that
+     * the factorization succeeded and solve statements can be used
+     * \param matrix name of the (flat) array holding the factorized matrix
+     */
+    std::string non_zero_pivots(const std::string& matrix) const;
+
+  private:
+    /// number of rows / columns
+    int size;
+
+    /// pattern of LU factors in column-major order
+    std::vector<bool> pattern;
+
+    /// number of fill-in entries
+    int n_fill_in = 0;
+
+    /// index of entry (row, col) in flat array
+    int index(int row, int col) const {
+        return row + size * col;
+    }
+};
+
+/** @} */  // end of codegen_details
+
+}  // namespace codegen
+}  // namespace nmodl
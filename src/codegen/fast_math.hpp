@@ -0,0 +1,457 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *
+ * Note that the fast exponentials and logarithms are based on VDT
+ * implementation of D. Piparo et al. See https://github.com/dpiparo/vdt
+ * for additional license information.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief Implementation of vectorizable math functions for C/C++ backends
+ *
+ * C++ counterpart of `fast_math.ispc`: branch-free, inline implementations
+ * of `exp`, `expm1`, `log` and `pow` that compilers can vectorize in loops
+ * annotated with `#pragma omp simd` (which is usually not the case for the
+ * calls into libm). Functions in `nmodl::fast_math` have (close to) full
+ * precision, those in `nmodl::fast_math::approx` use single precision
+ * polynomials in double precision arithmetic and have a relative error
+ * below `1e-7`.
+ *
+ * Special values are handled as follows: `vexp` saturates to `inf` / `0` for
+ * large arguments (slightly before the limits of libm), `vlog` returns `-inf` for zero and `NaN` for negative
+ * arguments. `NaN` arguments propagate. Denormal arguments are not supported.
+ *
+ * As for the functions of `<cmath>`, integer arguments (e.g. `exp(2)` in a MOD
+ * file) and `pow` with mixed argument types are computed in double precision.
+ *
+ * Note that GCC only vectorizes the selects of these functions for instruction
+ * sets with masking (e.g. AVX-512) unless `-fno-trapping-math` is used.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace nmodl {
+namespace fast_math {
+
+/// reinterpret bits of unsigned integer as double
+inline double uint642dp(uint64_t ll) {
+    double x;
+    std::memcpy(&x, &ll, sizeof(x));
+    return x;
+}
+
+/// reinterpret bits of double as unsigned integer
+inline uint64_t dp2uint64(double x) {
+    uint64_t ll;
+    std::memcpy(&ll, &x, sizeof(x));
+    return ll;
+}
+
+/// reinterpret bits of unsigned integer as float
+inline float uint322sp(uint32_t x) {
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+/// reinterpret bits of float as unsigned integer
+inline uint32_t sp2uint32(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    return x;
+}
+
+/// 2^n for integer n in the normal range of double (inf for n = 1024, zero for n = -1023)
+inline double dp_pow2(int32_t n) {
+    return uint642dp(static_cast<uint64_t>(n + 1023) << 52);
+}
+
+/// 2^n for integer n in the normal range of float (inf for n = 128, zero for n = -127)
+inline float sp_pow2(int32_t n) {
+    return uint322sp(static_cast<uint32_t>(n + 0x7f) << 23);
+}
+
+/**
+ * \brief Round to nearest integer
+ *
+ * Adds and subtracts 1.5 * 2^52 (double) or 1.5 * 2^23 (float), which is valid for
+ * magnitudes below 2^51 / 2^22. Unlike std::floor or conversions to integer, this is
+ * vectorized by all compilers and instruction sets.
+ */
+template <typename T>
+inline T round_nearest(T x) {
+    const T magic = T(1.5) / std::numeric_limits<T>::epsilon();
+    return (x + magic) - magic;
+}
+
+/**
+ * Split x into mantissa in `[sqrt(1/2), sqrt(2))` minus one and exponent
+ * \param x  positive, normal number
+ * \param fe exponent such that `x = (m+1) * 2^fe`
+ * \return `m`
+ */
+inline double dp_mantissa_exponent(double x, double& fe) {
+    const double SQRTH = 0.70710678118654752440;
+    uint64_t n = dp2uint64(x);
+    // mantissa in [0.5, 1)
+    fe = static_cast<double>(static_cast<int32_t>(n >> 52) - 1022);
+    n &= 0x800FFFFFFFFFFFFFULL;
+    n |= 0x3FE0000000000000ULL;
+    double m = uint642dp(n);
+    const bool small = m < SQRTH;
+    fe = small ? fe - 1.0 : fe;
+    m = small ? m + m : m;
+    return m - 1.0;
+}
+
+/// single precision version of fast_math::dp_mantissa_exponent
+inline float sp_mantissa_exponent(float x, float& fe) {
+    const float SQRTHF = 0.707106781186547524f;
+    uint32_t n = sp2uint32(x);
+    fe = static_cast<float>(static_cast<int32_t>(n >> 23) - 126);
+    n &= 0x807FFFFFU;
+    n |= 0x3F000000U;
+    float m = uint322sp(n);
+    const bool small = m < SQRTHF;
+    fe = small ? fe - 1.0f : fe;
+    m = small ? m + m : m;
+    return m - 1.0f;
+}
+
+
+/// arguments of exp are clamped to this range, giving inf and zero at the limits
+constexpr double EXP_MIN = -709.0;
+constexpr double EXP_MAX = 710.0;
+constexpr float EXP_MINF = -88.0f;
+constexpr float EXP_MAXF = 88.8f;
+constexpr double LOG2E = 1.4426950408889634073599;
+constexpr float LOG2EF = 1.44269504088896341f;
+
+/// ln(2) split into exactly representable high part and remainder
+constexpr double LN2_HI = 6.93145751953125e-1;
+constexpr double LN2_LO = 1.42860682030941723212e-6;
+constexpr float LN2_HIF = 0.693359375f;
+constexpr float LN2_LOF = -2.12194440e-4f;
+
+/// single precision exp(x)-1 polynomial on reduced argument `|x| <= ln(2)/2`
+template <typename T>
+inline T expm1_poly_sp(T x) {
+    const T x2 = x * x;
+    T z = x * T(1.9875691500E-4);
+    z += T(1.3981999507E-3);
+    z *= x;
+    z += T(8.3334519073E-3);
+    z *= x;
+    z += T(4.1665795894E-2);
+    z *= x;
+    z += T(1.6666665459E-1);
+    z *= x;
+    z += T(5.0000001201E-1);
+    z *= x2;
+    return z + x;
+}
+
+/// single precision exp polynomial on reduced argument `|x| <= ln(2)/2`
+template <typename T>
+inline T exp_poly_sp(T x) {
+    return expm1_poly_sp(x) + T(1.0);
+}
+
+/// single precision log polynomial: log(1+x) for `x` from fast_math::dp_mantissa_exponent
+template <typename T>
+inline T log_poly_sp(T x, T fe) {
+    const T x2 = x * x;
+    T y = T(7.0376836292E-2);
+    y = y * x - T(1.1514610310E-1);
+    y = y * x + T(1.1676998740E-1);
+    y = y * x - T(1.2420140846E-1);
+    y = y * x + T(1.4249322787E-1);
+    y = y * x - T(1.6668057665E-1);
+    y = y * x + T(2.0000714765E-1);
+    y = y * x - T(2.4999993993E-1);
+    y = y * x + T(3.3333331174E-1);
+    y *= x * x2;
+    y += T(LN2_LOF) * fe;
+    y -= T(0.5) * x2;
+    return x + y + T(LN2_HIF) * fe;
+}
+
+/// special values of log: -inf for zero, NaN for negative and NaN arguments, inf for inf
+template <typename T>
+inline T log_special(T initial_x, T res) {
+    res = initial_x == T(0) ? -std::numeric_limits<T>::infinity() : res;
+    res = initial_x < T(0) ? std::numeric_limits<T>::quiet_NaN() : res;
+    res = initial_x == std::numeric_limits<T>::infinity() ? initial_x : res;
+    res = initial_x != initial_x ? initial_x : res;
+    return res;
+}
+
+/// result type of integer arguments, as for the overloads of std::exp
+template <typename T>
+using enable_if_integral_t = typename std::enable_if<std::is_integral<T>::value, double>::type;
+
+/**
+ * \brief result type of pow with integer or mixed arguments, as for std::pow
+ *
+ * Arguments of the same floating point type are handled by the non-template
+ * overloads, all other combinations are computed in double precision.
+ */
+template <typename T, typename U>
+using enable_if_mixed_t = typename std::enable_if<
+    std::is_arithmetic<T>::value && std::is_arithmetic<U>::value &&
+        !(std::is_same<T, U>::value && std::is_floating_point<T>::value),
+    double>::type;
+
+
+/// double precision exp function
+inline double vexp(double initial_x) {
+    double x = std::min(std::max(initial_x, EXP_MIN), EXP_MAX);
+    double px = round_nearest(LOG2E * x);
+    const int32_t n = static_cast<int32_t>(px);
+
+    x -= px * LN2_HI;
+    x -= px * LN2_LO;
+
+    const double xx = x * x;
+
+    px = 1.26177193074810590878e-4;
+    px *= xx;
+    px += 3.02994407707441961300e-2;
+    px *= xx;
+    px += 9.99999999999999999910e-1;
+    px *= x;
+
+    double qx = 3.00198505138664455042e-6;
+    qx *= xx;
+    qx += 2.52448340349684104192e-3;
+    qx *= xx;
+    qx += 2.27265548208155028766e-1;
+    qx *= xx;
+    qx += 2.00000000000000000009;
+
+    x = px / (qx - px);
+    x = 1.0 + 2.0 * x;
+    return x * dp_pow2(n);
+}
+
+/// single precision exp function
+inline float vexp(float initial_x) {
+    float x = std::min(std::max(initial_x, EXP_MINF), EXP_MAXF);
+    float z = round_nearest(LOG2EF * x);
+    const int32_t n = static_cast<int32_t>(z);
+
+    x -= z * LN2_HIF;
+    x -= z * LN2_LOF;
+    return exp_poly_sp(x) * sp_pow2(n);
+}
+
+
+/// double precision natural logarithm
+inline double vlog(double initial_x) {
+    double fe;
+    const double x = dp_mantissa_exponent(initial_x, fe);
+    const double x2 = x * x;
+
+    double px = 1.01875663804580931796e-4;
+    px = px * x + 4.97494994976747001425e-1;
+    px = px * x + 4.70579119878881725854e0;
+    px = px * x + 1.44989225341610930846e1;
+    px = px * x + 1.79368678507819816313e1;
+    px = px * x + 7.70838733755885391666e0;
+
+    double qx = x + 1.12873587189167450590e1;
+    qx = qx * x + 4.52279145837532221105e1;
+    qx = qx * x + 8.29875266912776603211e1;
+    qx = qx * x + 7.11544750618563894466e1;
+    qx = qx * x + 2.31251620126765340583e1;
+
+    double res = x * x2 * px / qx;
+    res -= fe * 2.121944400546905827679e-4;
+    res -= 0.5 * x2;
+    res = x + res;
+    res += fe * 0.693359375;
+    return log_special(initial_x, res);
+}
+
+/// single precision natural logarithm
+inline float vlog(float initial_x) {
+    float fe;
+    const float x = sp_mantissa_exponent(initial_x, fe);
+    return log_special(initial_x, log_poly_sp(x, fe));
+}
+
+
+/**
+ * \brief double precision exp(x)-1, accurate for small arguments
+ *
+ * Uses `exp(x)-1 = 2*tanh(x/2)/(1-tanh(x/2))` with the rational function of
+ * fast_math::vexp for small `|x|`, avoiding cancellation.
+ */
+inline double vexpm1(double x) {
+    const double xx = x * x;
+    double px = 1.26177193074810590878e-4;
+    px *= xx;
+    px += 3.02994407707441961300e-2;
+    px *= xx;
+    px += 9.99999999999999999910e-1;
+    px *= x;
+
+    double qx = 3.00198505138664455042e-6;
+    qx *= xx;
+    qx += 2.52448340349684104192e-3;
+    qx *= xx;
+    qx += 2.27265548208155028766e-1;
+    qx *= xx;
+    qx += 2.00000000000000000009;
+
+    const double small = 2.0 * px / (qx - px);
+    const double large = vexp(x) - 1.0;
+    return std::abs(x) < 0.5 * LN2_HI ? small : large;
+}
+
+/// single precision exp(x)-1, accurate for small arguments
+inline float vexpm1(float x) {
+    const float small = expm1_poly_sp(x);
+    const float large = vexp(x) - 1.0f;
+    return std::abs(x) < 0.5f * LN2_HIF ? small : large;
+}
+
+
+/**
+ * \brief sign of pow(x, y) given `r = |x|^y`, following std::pow
+ *
+ * Negative base gives the signed result for integer exponents and NaN
+ * otherwise, zero exponent gives one for any base.
+ */
+template <typename T>
+inline T pow_sign(T x, T y, T r) {
+    // exponents of larger magnitude than valid for round_nearest are even integers
+    const T limit = T(0.5) / std::numeric_limits<T>::epsilon();
+    const T yc = std::abs(y) < limit ? y : limit;
+    const T yh = T(0.5) * yc;
+    const T sign = yh != round_nearest(yh) ? T(-1) : T(1);
+    const T signed_r = sign * r;
+    T res = yc == round_nearest(yc) ? signed_r : std::numeric_limits<T>::quiet_NaN();
+    res = x < T(0) ? res : r;
+    return y == T(0) ? T(1) : res;
+}
+
+/// double precision power function
+inline double vpow(double x, double y) {
+    return pow_sign(x, y, vexp(y * vlog(std::abs(x))));
+}
+
+/// single precision power function
+inline float vpow(float x, float y) {
+    return pow_sign(x, y, vexp(y * vlog(std::abs(x))));
+}
+
+/// exp of integer argument (e.g. literal in MOD file) in double precision
+template <typename T>
+inline enable_if_integral_t<T> vexp(T x) {
+    return vexp(static_cast<double>(x));
+}
+
+/// log of integer argument in double precision
+template <typename T>
+inline enable_if_integral_t<T> vlog(T x) {
+    return vlog(static_cast<double>(x));
+}
+
+/// exp(x)-1 of integer argument in double precision
+template <typename T>
+inline enable_if_integral_t<T> vexpm1(T x) {
+    return vexpm1(static_cast<double>(x));
+}
+
+/// power function with integer or mixed precision arguments in double precision
+template <typename T, typename U>
+inline enable_if_mixed_t<T, U> vpow(T x, U y) {
+    return vpow(static_cast<double>(x), static_cast<double>(y));
+}
+
+
+/// vectorizable math functions with reduced accuracy (relative error below 1e-7)
+namespace approx {
+
+/// exp with single precision polynomial
+inline double vexp(double initial_x) {
+    double x = std::min(std::max(initial_x, EXP_MIN), EXP_MAX);
+    double px = round_nearest(LOG2E * x);
+    const int32_t n = static_cast<int32_t>(px);
+
+    x -= px * LN2_HI;
+    x -= px * LN2_LO;
+    return exp_poly_sp(x) * dp_pow2(n);
+}
+
+/// log with single precision polynomial
+inline double vlog(double initial_x) {
+    double fe;
+    const double x = dp_mantissa_exponent(initial_x, fe);
+    return log_special(initial_x, log_poly_sp(x, fe));
+}
+
+/// exp(x)-1 with single precision polynomial
+inline double vexpm1(double x) {
+    const double small = expm1_poly_sp(x);
+    const double large = vexp(x) - 1.0;
+    return std::abs(x) < 0.5 * LN2_HI ? small : large;
+}
+
+/// power function
+inline double vpow(double x, double y) {
+    return pow_sign(x, y, vexp(y * vlog(std::abs(x))));
+}
+
+inline float vexp(float x) {
+    return fast_math::vexp(x);
+}
+
+inline float vlog(float x) {
+    return fast_math::vlog(x);
+}
+
+inline float vexpm1(float x) {
+    return fast_math::vexpm1(x);
+}
+
+inline float vpow(float x, float y) {
+    return fast_math::vpow(x, y);
+}
+
+template <typename T>
+inline enable_if_integral_t<T> vexp(T x) {
+    return vexp(static_cast<double>(x));
+}
+
+template <typename T>
+inline enable_if_integral_t<T> vlog(T x) {
+    return vlog(static_cast<double>(x));
+}
+
+template <typename T>
+inline enable_if_integral_t<T> vexpm1(T x) {
+    return vexpm1(static_cast<double>(x));
+}
+
+template <typename T, typename U>
+inline enable_if_mixed_t<T, U> vpow(T x, U y) {
+    return vpow(static_cast<double>(x), static_cast<double>(y));
+}
+
+}  // namespace approx
+
+}  // namespace fast_math
+}  // namespace nmodl
@@ -5,6 +5,8 @@
  * Lesser General Public License. See top-level LICENSE file for details.
  *************************************************************************/
 
+#include <fstream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -23,12 +25,19 @@
 #include "config/config.h"
 #include "parser/nmodl_driver.hpp"
 #include "parser/unit_driver.hpp"
+#include "utils/arena.hpp"
 #include "utils/common_utils.hpp"
+#include "utils/file_cache.hpp"
 #include "utils/logger.hpp"
+#include "utils/worker_pool.hpp"
 #include "visitors/ast_visitor.hpp"
+#include "visitors/auto_table_visitor.hpp"
+#include "visitors/compact_storage_visitor.hpp"
 #include "visitors/constant_folder_visitor.hpp"
+#include "visitors/cse_visitor.hpp"
 #include "visitors/inline_visitor.hpp"
 #include "visitors/json_visitor.hpp"
+#include "visitors/linear_cnexp_solve_visitor.hpp"
 #include "visitors/kinetic_block_visitor.hpp"
 #include "visitors/local_var_rename_visitor.hpp"
 #include "visitors/localize_visitor.hpp"
@@ -44,6 +53,7 @@
 #include "visitors/units_visitor.hpp"
 #include "visitors/verbatim_var_rename_visitor.hpp"
 #include "visitors/verbatim_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
 
 /**
  * \dir
@@ -56,6 +66,28 @@ using namespace codegen;
 using namespace visitor;
 using nmodl::parser::NmodlDriver;
 
+/**
+ * Newton solver variant for a mod file
+ *
+ * \param methods entries `method` for all mod files or `mod=method` for the mod file with
+ *                given base name, later entries take precedence
+ * \param modfile base name of mod file
+ * \return        newton solver variant (newton, chord or damped)
+ */
+static std::string newton_method_for(const std::vector<std::string>& methods,
+                                     const std::string& modfile) {
+    std::string method = "newton";
+    for (const auto& entry: methods) {
+        auto pos = entry.find('=');
+        if (pos == std::string::npos) {
+            method = entry;
+        } else if (entry.substr(0, pos) == modfile) {
+            method = entry.substr(pos + 1);
+        }
+    }
+    return method;
+}
+
 int main(int argc, const char* argv[]) {
     CLI::App app{
         "NMODL : Source-to-Source Code Generation Framework [{}]"_format(Version::to_string())};
@@ -66,6 +98,9 @@ int main(int argc, const char* argv[]) {
     /// true if debug logger statements should be shown
     bool verbose(false);
 
+    /// number of mod files to process concurrently
+    int num_jobs(1);
+
     /// true if serial c code to be generated
     bool c_backend(true);
 
@@ -93,6 +128,12 @@ int main(int argc, const char* argv[]) {
     /// true if conductance keyword can be added to breakpoint
     bool sympy_conductance(false);
 
+    /// max number of states of linear systems solved by unrolled gaussian elimination
+    int sympy_unroll_linear(0);
+
+    /// file where SymPy solutions are memoized across runs (disabled if empty)
+    std::string sympy_memo_file;
+
     /// true if inlining at nmodl level to be done
     bool nmodl_inline(false);
 
@@ -111,6 +152,27 @@ int main(int argc, const char* argv[]) {
     /// true if local variables to be renamed
     bool local_rename(false);
 
+    /// true if storage of ASSIGNED variables without carried values to be removed
+    bool compact_storage(false);
+
+    /// true if common subexpressions to be eliminated at nmodl level
+    bool nmodl_cse(false);
+
+    /// true if TABLE statements to be added to expensive rate procedures
+    bool auto_table(false);
+
+    /// minimum estimated cost of procedure for automatic TABLE
+    double auto_table_cost(50.);
+
+    /// maximum relative interpolation error of automatic TABLE
+    double auto_table_error(1e-4);
+
+    /// lower bound of voltage range of automatic TABLE
+    double auto_table_from(-100.);
+
+    /// upper bound of voltage range of automatic TABLE
+    double auto_table_to(100.);
+
     /// true if inline even if verbatim block exist
     bool verbatim_inline(false);
 
@@ -127,6 +189,9 @@ int main(int argc, const char* argv[]) {
     /// directory where intermediate file will be generated
     std::string scratch_dir("tmp");
 
+    /// directory where generated code is cached (disabled if empty)
+    std::string cache_dir;
+
     /// directory where units lib file is located
     std::string units_dir(NrnUnitsLib::get_path());
 
@@ -142,12 +207,60 @@ int main(int argc, const char* argv[]) {
     /// true if symbol table should be printed
     bool show_symtab(false);
 
+    /// true if symbol tables updated by passes to be verified by full rebuild
+    bool verify_symtab(false);
+
     /// memory layout for code generation
     std::string layout("soa");
 
+    /// number of instances per block of aosoa memory layout
+    int layout_block_width(8);
+
     /// floating point data type
     std::string data_type("double");
 
+    /// number of instances solved in lock-step by batched newton solver
+    int newton_batch_size(0);
+
+    /// true if sparse LU factorization to be used for eigen solvers
+    bool sparse_lu(false);
+
+    /// true if convergence statistics of newton solver to be recorded
+    bool newton_stats(false);
+
+    /// newton solver variant (newton, chord or damped) for all mod files or as mod=method
+    std::vector<std::string> newton_methods{"newton"};
+
+    /// absolute tolerance for residual of newton solver
+    double newton_atol(1e-12);
+
+    /// relative tolerance for residual of newton solver
+    double newton_rtol(0.);
+
+    /// maximum number of newton solver iterations
+    int newton_max_iter(1000);
+
+    /// accuracy of vectorizable math functions (off, precise or approx)
+    std::string vector_math("off");
+
+    /// memory layout of TABLE variables (separate or interleaved)
+    std::string table_layout("separate");
+
+    /// number of instances per tile of fused nrn_state_cur kernel (0 to disable)
+    int fused_tile_size(0);
+
+    /// number of double precision SIMD lanes for alignment of instance data (0 to disable)
+    int simd_width(0);
+
+    /// true if rate intermediates and table data to be stored in float
+    bool mixed_precision(false);
+
+    /// file with names of variables to be stored in float
+    std::string float_variables_file;
+
+    /// true if expressions of global variables to be evaluated once before instance loops
+    bool hoist_invariants(false);
+
     app.get_formatter()->column_width(40);
     app.set_help_all_flag("-H,--help-all", "Print this help message including all sub-commands");
 
@@ -158,11 +271,16 @@ int main(int argc, const char* argv[]) {
         ->required()
         ->check(CLI::ExistingFile);
 
+    app.add_option("-j,--jobs", num_jobs, "Number of MOD files to process concurrently", true)
+        ->ignore_case()
+        ->check(CLI::Range(1, 1024));
     app.add_option("-o,--output", output_dir, "Directory for backend code output", true)
         ->ignore_case();
     app.add_option("--scratch", scratch_dir, "Directory for intermediate code output", true)
         ->ignore_case();
     app.add_option("--units", units_dir, "Directory of units lib file", true)->ignore_case();
+    app.add_option("--cache", cache_dir, "Directory for caching generated code", true)
+        ->ignore_case();
 
     auto host_opt = app.add_subcommand("host", "HOST/CPU code backends")->ignore_case();
     host_opt->add_flag("--c", c_backend, "C/C++ backend ({})"_format(c_backend))->ignore_case();
@@ -192,6 +310,13 @@ int main(int argc, const char* argv[]) {
     sympy_opt->add_flag("--conductance",
         sympy_conductance,
         "Add CONDUCTANCE keyword in BREAKPOINT ({})"_format(sympy_conductance))->ignore_case();
+    sympy_opt->add_option("--unroll-linear",
+        sympy_unroll_linear,
+        "Max number of states of linear systems solved by unrolled Gaussian elimination",
+        true)->ignore_case()->check(CLI::Range(0, 16));
+    sympy_opt->add_option("--memo",
+        sympy_memo_file,
+        "File to reuse SymPy solutions across runs")->ignore_case();
 
     auto passes_opt = app.add_subcommand("passes", "Analyse/Optimization passes")->ignore_case();
     passes_opt->add_flag("--inline",
@@ -212,6 +337,31 @@ int main(int argc, const char* argv[]) {
     passes_opt->add_flag("--local-rename",
         local_rename,
         "Rename LOCAL variable if variable of same name exist in global scope ({})"_format(local_rename))->ignore_case();
+    passes_opt->add_flag("--compact-storage",
+        compact_storage,
+        "Convert ASSIGNED variables not carried between blocks to LOCAL and drop their storage ({})"_format(compact_storage))->ignore_case();
+    passes_opt->add_flag("--cse",
+        nmodl_cse,
+        "Eliminate common subexpressions at NMODL level ({})"_format(nmodl_cse))->ignore_case();
+    passes_opt->add_flag("--auto-table",
+        auto_table,
+        "Add TABLE to expensive procedures depending only on voltage ({})"_format(auto_table))->ignore_case();
+    passes_opt->add_option("--auto-table-cost",
+        auto_table_cost,
+        "Minimum estimated cost of procedure for automatic TABLE",
+        true)->ignore_case()->check(CLI::Range(0., 1e6));
+    passes_opt->add_option("--auto-table-error",
+        auto_table_error,
+        "Maximum relative interpolation error of automatic TABLE",
+        true)->ignore_case()->check(CLI::Range(1e-12, 1.));
+    passes_opt->add_option("--auto-table-from",
+        auto_table_from,
+        "Lower bound of voltage range of automatic TABLE",
+        true)->ignore_case();
+    passes_opt->add_option("--auto-table-to",
+        auto_table_to,
+        "Upper bound of voltage range of automatic TABLE",
+        true)->ignore_case();
     passes_opt->add_flag("--verbatim-inline",
         verbatim_inline,
         "Inline even if verbatim block exist ({})"_format(verbatim_inline))->ignore_case();
@@ -230,16 +380,84 @@ int main(int argc, const char* argv[]) {
     passes_opt->add_flag("--show-symtab",
         show_symtab,
         "Write symbol table to stdout ({})"_format(show_symtab))->ignore_case();
+    passes_opt->add_flag("--verify-symtab",
+        verify_symtab,
+        "Rebuild symbol table after passes updating it to check for missing updates ({})"_format(verify_symtab))->ignore_case();
 
     auto codegen_opt = app.add_subcommand("codegen", "Code generation options")->ignore_case();
     codegen_opt->add_option("--layout",
         layout,
         "Memory layout for code generation",
-        true)->ignore_case()->check(CLI::IsMember({"aos", "soa"}));
+        true)->ignore_case()->check(CLI::IsMember({"aos", "soa", "aosoa"}));
+    codegen_opt->add_option("--layout-block-width",
+        layout_block_width,
+        "Number of instances per block of aosoa layout",
+        true)->ignore_case()->check(CLI::Range(1, 1024));
     codegen_opt->add_option("--datatype",
-        layout,
+        data_type,
         "Data type for floating point variables",
         true)->ignore_case()->check(CLI::IsMember({"float", "double"}));
+    codegen_opt->add_option("--newton-batch",
+        newton_batch_size,
+        "Number of instances solved in lock-step by Newton solver (C/OpenMP backends)",
+        true)->ignore_case()->check(CLI::Range(0, 64));
+    codegen_opt->add_flag("--sparse-lu",
+        sparse_lu,
+        "Sparse LU factorization for linear systems of KINETIC/DERIVATIVE blocks ({})"_format(sparse_lu))->ignore_case();
+    codegen_opt->add_flag("--newton-stats",
+        newton_stats,
+        "Record Newton solver iteration histograms, see NMODL_NEWTON_STATS (C/OpenMP backends) ({})"_format(newton_stats))->ignore_case();
+    codegen_opt->add_option("--newton-method",
+        newton_methods,
+        "Newton solver variant {newton,chord,damped} for all mod files or per mod file as mod=method",
+        true)->ignore_case()->check([](const std::string& value) {
+            auto method = value.substr(value.find('=') + 1);
+            if (method == "newton" || method == "chord" || method == "damped") {
+                return std::string();
+            }
+            return "Value " + value + " is not a Newton solver variant";
+        });
+    codegen_opt->add_option("--newton-atol",
+        newton_atol,
+        "Absolute tolerance for residual of Newton solver (all mod files)",
+        true)->ignore_case()->check(CLI::Range(0., 1.));
+    codegen_opt->add_option("--newton-rtol",
+        newton_rtol,
+        "Relative tolerance for residual of Newton solver (all mod files)",
+        true)->ignore_case()->check(CLI::Range(0., 1.));
+    codegen_opt->add_option("--newton-max-iter",
+        newton_max_iter,
+        "Maximum number of Newton solver iterations (all mod files)",
+        true)->ignore_case()->check(CLI::Range(1, 1000000));
+    codegen_opt->add_option("--vector-math",
+        vector_math,
+        "Vectorizable exp/expm1/log/pow, approx has relative error below 1e-7 (C/OpenMP backends)",
+        true)->ignore_case()->check(CLI::IsMember({"off", "precise", "approx"}));
+    codegen_opt->add_option("--table-layout",
+        table_layout,
+        "Memory layout of TABLE variables, interleaved uses branch-free lookup (C/OpenMP backends)",
+        true)->ignore_case()->check(CLI::IsMember({"separate", "interleaved"}));
+    codegen_opt->add_option("--fused-tile",
+        fused_tile_size,
+        "Instances per tile of fused nrn_state_cur kernel, 0 disables it (C/OpenMP backends)",
+        true)->ignore_case()->check(CLI::Range(0, 1048576));
+    codegen_opt->add_option("--simd-width",
+        simd_width,
+        "Double precision SIMD lanes (power of two) that instance data is aligned and padded to, 0 disables alignment annotations (C/OpenMP backends)",
+        true)->ignore_case()->check(CLI::Range(0, 64))->check([](const std::string& value) {
+            // alignment of posix_memalign must be a power of two
+            auto width = std::stoi(value);
+            return (width & (width - 1)) == 0 ? "" : "Value " + value + " is not a power of two";
+        });
+    codegen_opt->add_flag("--mixed-precision",
+        mixed_precision,
+        "Store rate intermediates and table data in float (C/OpenMP backends) ({})"_format(mixed_precision))->ignore_case();
+    codegen_opt->add_option("--float-variables",
+        float_variables_file,
+        "File with names of variables to store in float, implies --mixed-precision")->ignore_case()->check(CLI::ExistingFile);
+    codegen_opt->add_flag("--hoist-invariants",
+        hoist_invariants,
+        "Evaluate expressions of global variables once before instance loops (C/OpenMP backends) ({})"_format(hoist_invariants))->ignore_case();
     codegen_opt->add_flag("--force",
         force_codegen,
         "Force code generation even if there is any incompatibility");
@@ -248,6 +466,25 @@ int main(int argc, const char* argv[]) {
 
     CLI11_PARSE(app, argc, argv);
 
+    if (auto_table_from >= auto_table_to) {
+        logger->error("--auto-table-from must be less than --auto-table-to");
+        return 1;
+    }
+
+    for (const auto& entry: newton_methods) {
+        auto pos = entry.find('=');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        auto mod = entry.substr(0, pos);
+        auto matches = [&](const std::string& file) {
+            return utils::remove_extension(utils::base_name(file)) == mod;
+        };
+        if (std::none_of(mod_files.begin(), mod_files.end(), matches)) {
+            logger->warn("--newton-method {} does not match any mod file", entry);
+        }
+    }
+
     // if any of the other backends is used we force the C backend to be off.
     if (omp_backend || ispc_backend) {
         c_backend = false;
@@ -256,8 +493,78 @@ int main(int argc, const char* argv[]) {
     utils::make_path(output_dir);
     utils::make_path(scratch_dir);
 
-    if (sympy_opt) {
+    /// variables selected for float storage, whitespace separated and '#' comments
+    std::vector<std::string> float_variables;
+    if (!float_variables_file.empty()) {
+        mixed_precision = true;
+        std::ifstream float_variables_stream(float_variables_file);
+        std::string name;
+        while (float_variables_stream >> name) {
+            if (name[0] == '#') {
+                std::getline(float_variables_stream, name);
+                continue;
+            }
+            float_variables.push_back(name);
+        }
+    }
+
+    /// intermediate outputs are only produced by a full run, so caching is
+    /// disabled whenever they are requested
+    bool use_cache = !cache_dir.empty() &&
+                     !(json_ast || nmodl_ast || json_perfstat || show_symtab || verify_symtab);
+    if (use_cache) {
+        utils::make_path(cache_dir);
+    }
+    utils::FileCache codegen_cache(cache_dir);
+
+    /// all options that affect generated code, part of the cache key
+    std::stringstream options_stream;
+    options_stream << Version::to_string() << " units=" << units_dir << ","
+                   << utils::FileCache::hash_file(units_dir) << " backend=" << c_backend
+                   << omp_backend << ispc_backend << oacc_backend << cuda_backend
+                   << " sympy=" << sympy_analytic << sympy_pade << sympy_cse << sympy_conductance
+                   << " unroll_linear=" << sympy_unroll_linear
+                   << " passes=" << nmodl_inline << nmodl_unroll << nmodl_const_folding
+                   << nmodl_localize << localize_verbatim << local_rename << verbatim_inline
+                   << verbatim_rename << compact_storage << nmodl_cse
+                   << " auto_table=" << auto_table
+                   << ",{},{},{},{}"_format(auto_table_cost,
+                                                auto_table_error,
+                                                auto_table_from,
+                                                auto_table_to) << " layout=" << layout
+                   << "," << layout_block_width
+                   << " datatype=" << data_type
+                   << " newton_batch=" << newton_batch_size << " sparse_lu=" << sparse_lu
+                   << " newton_stats=" << newton_stats
+                   << " newton_method=" << "{}"_format(fmt::join(newton_methods, ","))
+                   << ",{},{},{}"_format(newton_atol, newton_rtol, newton_max_iter)
+                   << " vector_math=" << vector_math << " table_layout=" << table_layout
+                   << " fused_tile=" << fused_tile_size << " simd_width=" << simd_width
+                   << " mixed_precision=" << mixed_precision << ":"
+                   << "{}"_format(fmt::join(float_variables, ","))
+                   << " hoist_invariants=" << hoist_invariants
+                   << " force=" << force_codegen;
+    const auto cache_options = options_stream.str();
+
+    /// true if mod files are processed by worker threads
+    const bool use_workers = utils::use_worker_threads(num_jobs, mod_files.size());
+
+    /// the python interpreter has to be started and finalized by the main thread: with
+    /// worker threads it is started up front, otherwise only once a SymPy pass needs it
+    bool python_started = false;
+    auto start_python = [&]() {
+        if (python_started) {
+            return;
+        }
         pybind11::initialize_interpreter();
+        if (!sympy_memo_file.empty()) {
+            pybind11::module::import("nmodl.ode").attr("load_memo_cache")(sympy_memo_file);
+        }
+        python_started = true;
+    };
+
+    if ((sympy_analytic || sympy_conductance) && use_workers) {
+        start_python();
     }
 
     if (verbose) {
@@ -272,27 +579,63 @@ int main(int argc, const char* argv[]) {
         }
     };
 
-    for (const auto& file: mod_files) {
+    /// run all passes and code generation for a single mod file, returns
+    /// false if code generation is aborted due to incompatible constructs
+    auto process_mod_file = [&](const std::string& file) -> bool {
+        auto modfile = utils::remove_extension(utils::base_name(file));
+
+        /// in worker threads, prefix messages of this thread with mod file name (the
+        /// thread local logger of the calling thread is never replaced)
+        if (use_workers) {
+            logger = make_logger("NMODL:" + modfile);
+        }
+
         logger->info("Processing {}", file);
 
-        auto modfile = utils::remove_extension(utils::base_name(file));
+        /// reuse previously generated code if neither mod file nor options changed
+        std::string cache_key;
+        if (use_cache) {
+            std::ifstream mod_stream(file);
+            std::stringstream mod_text;
+            mod_text << mod_stream.rdbuf();
+            cache_key = utils::FileCache::make_key(modfile, mod_text.str(), cache_options);
+            if (codegen_cache.restore(cache_key, output_dir)) {
+                logger->info("Using cached code generated for {}", file);
+                return true;
+            }
+        }
 
         /// create file path for nmodl file
-        auto filepath = [scratch_dir, modfile](std::string suffix) {
-            static int count = 0;
+        int count = 0;
+        auto filepath = [scratch_dir, modfile, &count](std::string suffix) {
             return "{}/{}.{}.{}.mod"_format(scratch_dir, modfile, std::to_string(count++), suffix);
         };
 
         /// driver object creates lexer and parser, just call parser method
         NmodlDriver driver;
+        driver.set_arena_allocation(true);
 
         /// parse mod file and construct ast
         auto ast = driver.parse_file(file);
 
+        /// nodes created by passes are allocated from same arena as parsed ast
+        utils::ArenaScope arena_scope(driver.get_arena());
+
         /// whether to update existing symbol table or create new
         /// one whenever we run symtab visitor.
         bool update_symtab = false;
 
+        /// passes adding, renaming or removing variables update symbol tables
+        /// themselves, full rebuild is only used to verify these updates
+        const auto check_symtab = [&](const std::string& pass) {
+            if (!verify_symtab) {
+                return;
+            }
+            for (const auto& name: visitor::verify_symbol_table(ast.get())) {
+                logger->warn("{} did not update symbol table with {}", pass, name);
+            }
+        };
+
         /// just visit the ast
         AstVisitor().visit_program(ast.get());
 
@@ -310,7 +653,7 @@ int main(int argc, const char* argv[]) {
             // If there is an incompatible construct and code generation is not forced exit NMODL
             if (CodegenCompatibilityVisitor().find_unhandled_ast_nodes(ast.get()) &&
                 !force_codegen) {
-                return 1;
+                return false;
             }
         }
 
@@ -378,16 +721,28 @@ int main(int argc, const char* argv[]) {
         /// that old symbols (e.g. prime variables) are not lost
         update_symtab = true;
 
+        /// tables have to be added before inlining as procedures
+        /// with TABLE statement are not inlined
+        if (auto_table) {
+            logger->info("Running auto table visitor");
+            AutoTableVisitor(auto_table_cost, auto_table_error, auto_table_from, auto_table_to)
+                .visit_program(ast.get());
+            check_symtab("AutoTableVisitor");
+            ast_to_nmodl(ast.get(), filepath("auto_table"));
+        }
+
         if (nmodl_inline) {
             logger->info("Running nmodl inline visitor");
             InlineVisitor().visit_program(ast.get());
+            /// inlined blocks are new blocks without symbol table
+            SymtabVisitor(update_symtab).visit_program(ast.get());
             ast_to_nmodl(ast.get(), filepath("inline"));
         }
 
         if (local_rename) {
             logger->info("Running local variable rename visitor");
             LocalVarRenameVisitor().visit_program(ast.get());
-            SymtabVisitor(update_symtab).visit_program(ast.get());
+            check_symtab("LocalVarRenameVisitor");
             ast_to_nmodl(ast.get(), filepath("local_rename"));
         }
 
@@ -396,20 +751,43 @@ int main(int argc, const char* argv[]) {
             logger->info("Running localize visitor");
             LocalizeVisitor(localize_verbatim).visit_program(ast.get());
             LocalVarRenameVisitor().visit_program(ast.get());
-            SymtabVisitor(update_symtab).visit_program(ast.get());
+            check_symtab("LocalizeVisitor");
             ast_to_nmodl(ast.get(), filepath("localize"));
         }
 
+        if (compact_storage) {
+            logger->info("Running compact storage visitor");
+            CompactStorageVisitor().visit_program(ast.get());
+            check_symtab("CompactStorageVisitor");
+            ast_to_nmodl(ast.get(), filepath("compact_storage"));
+        }
+
         if (sympy_conductance) {
+            start_python();
+            pybind11::gil_scoped_acquire acquire_gil;
             logger->info("Running sympy conductance visitor");
             SympyConductanceVisitor().visit_program(ast.get());
-            SymtabVisitor(update_symtab).visit_program(ast.get());
+            check_symtab("SympyConductanceVisitor");
             ast_to_nmodl(ast.get(), filepath("sympy_conductance"));
         }
 
-        if (sympy_analytic) {
+        if (sympy_analytic && !sympy_pade) {
+            logger->info("Running linear cnexp solve visitor");
+            LinearCnexpSolveVisitor().visit_program(ast.get());
+            ast_to_nmodl(ast.get(), filepath("linear_cnexp"));
+        }
+
+        /// SymPy is only needed for equations not solved by LinearCnexpSolveVisitor
+        if (sympy_analytic && LinearCnexpSolveVisitor::has_unsolved_equations(ast.get())) {
+            start_python();
+            pybind11::gil_scoped_acquire acquire_gil;
             logger->info("Running sympy solve visitor");
-            SympySolverVisitor(sympy_pade, sympy_cse).visit_program(ast.get());
+            const int small_linear_system_max_states = 3;
+            SympySolverVisitor(sympy_pade,
+                               sympy_cse,
+                               small_linear_system_max_states,
+                               sympy_unroll_linear)
+                .visit_program(ast.get());
             SymtabVisitor(update_symtab).visit_program(ast.get());
             ast_to_nmodl(ast.get(), filepath("sympy_solve"));
         }
@@ -426,6 +804,14 @@ int main(int argc, const char* argv[]) {
             ast_to_nmodl(ast.get(), filepath("solveblock"));
         }
 
+        if (nmodl_cse) {
+            // after solve blocks are replaced so that solutions are covered as well
+            logger->info("Running common subexpression elimination visitor");
+            CseVisitor().visit_program(ast.get());
+            check_symtab("CseVisitor");
+            ast_to_nmodl(ast.get(), filepath("cse"));
+        }
+
         if (json_perfstat) {
             auto file = scratch_dir + "/" + modfile + ".perf.json";
             logger->info("Writing performance statistics to {}", file);
@@ -438,43 +824,117 @@ int main(int argc, const char* argv[]) {
             PerfVisitor().visit_program(ast.get());
         }
 
+        /// files written by code generators (used to populate cache)
+        std::vector<std::string> generated_files;
+
         {
-            auto mem_layout = layout == "aos" ? codegen::LayoutType::aos : codegen::LayoutType::soa;
+            auto mem_layout = codegen::LayoutType::soa;
+            if (layout == "aos") {
+                mem_layout = codegen::LayoutType::aos;
+            } else if (layout == "aosoa") {
+                mem_layout = codegen::LayoutType::aosoa;
+            }
+            auto output_file = output_dir + "/" + modfile;
+            auto newton_method = newton_method_for(newton_methods, modfile);
 
 
             if (ispc_backend) {
                 logger->info("Running ISPC backend code generator");
                 CodegenIspcVisitor visitor(modfile, output_dir, mem_layout, data_type);
+                visitor.set_layout_block_width(layout_block_width);
+                visitor.set_sparse_lu(sparse_lu);
+                visitor.set_newton_method(newton_method, newton_atol, newton_rtol, newton_max_iter);
                 visitor.visit_program(ast.get());
+                generated_files.push_back(output_file + ".ispc");
+                generated_files.push_back(output_file + ".cpp");
             }
 
             else if (oacc_backend) {
                 logger->info("Running OpenACC backend code generator");
                 CodegenAccVisitor visitor(modfile, output_dir, mem_layout, data_type);
+                visitor.set_layout_block_width(layout_block_width);
+                visitor.set_sparse_lu(sparse_lu);
+                visitor.set_newton_method(newton_method, newton_atol, newton_rtol, newton_max_iter);
                 visitor.visit_program(ast.get());
+                generated_files.push_back(output_file + ".cpp");
             }
 
             else if (omp_backend) {
                 logger->info("Running OpenMP backend code generator");
                 CodegenOmpVisitor visitor(modfile, output_dir, mem_layout, data_type);
+                visitor.set_layout_block_width(layout_block_width);
+                visitor.set_sparse_lu(sparse_lu);
+                visitor.set_newton_method(newton_method, newton_atol, newton_rtol, newton_max_iter);
+                visitor.set_newton_batch_size(newton_batch_size);
+                visitor.set_newton_stats(newton_stats);
+                visitor.set_vector_math(vector_math);
+                visitor.set_interleaved_tables(table_layout == "interleaved");
+                visitor.set_fused_tile_size(fused_tile_size);
+                visitor.set_simd_width(simd_width);
+                if (mixed_precision) {
+                    visitor.set_mixed_precision(float_variables);
+                }
+                visitor.set_hoist_invariants(hoist_invariants);
                 visitor.visit_program(ast.get());
+                generated_files.push_back(output_file + ".cpp");
             }
 
             else if (c_backend) {
                 logger->info("Running C backend code generator");
                 CodegenCVisitor visitor(modfile, output_dir, mem_layout, data_type);
+                visitor.set_layout_block_width(layout_block_width);
+                visitor.set_sparse_lu(sparse_lu);
+                visitor.set_newton_method(newton_method, newton_atol, newton_rtol, newton_max_iter);
+                visitor.set_newton_batch_size(newton_batch_size);
+                visitor.set_newton_stats(newton_stats);
+                visitor.set_vector_math(vector_math);
+                visitor.set_interleaved_tables(table_layout == "interleaved");
+                visitor.set_fused_tile_size(fused_tile_size);
+                visitor.set_simd_width(simd_width);
+                if (mixed_precision) {
+                    visitor.set_mixed_precision(float_variables);
+                }
+                visitor.set_hoist_invariants(hoist_invariants);
                 visitor.visit_program(ast.get());
+                generated_files.push_back(output_file + ".cpp");
             }
 
             if (cuda_backend) {
                 logger->info("Running CUDA backend code generator");
                 CodegenCudaVisitor visitor(modfile, output_dir, mem_layout, data_type);
+                visitor.set_layout_block_width(layout_block_width);
+                visitor.set_sparse_lu(sparse_lu);
+                visitor.set_newton_method(newton_method, newton_atol, newton_rtol, newton_max_iter);
                 visitor.visit_program(ast.get());
+                generated_files.push_back(output_file + ".cu");
             }
         }
+
+        /// code printers are flushed once visitors go out of scope
+        if (use_cache && codegen_cache.store(cache_key, generated_files)) {
+            logger->info("Stored generated code for {} in cache", file);
+        }
+        return true;
+    };
+
+    bool success = true;
+    {
+        /// python interpreter is shared between all jobs: release the GIL held
+        /// by main thread so that SymPy passes can acquire it one at a time
+        std::unique_ptr<pybind11::gil_scoped_release> release_gil;
+        if (python_started) {
+            release_gil.reset(new pybind11::gil_scoped_release);
+        }
+        success = utils::process_in_parallel(mod_files, num_jobs, process_mod_file);
     }
 
-    if (sympy_opt) {
+    if (python_started) {
+        if (!sympy_memo_file.empty()) {
+            logger->info("Writing SymPy solutions to {}", sympy_memo_file);
+            pybind11::module::import("nmodl.ode").attr("save_memo_cache")(sympy_memo_file);
+        }
         pybind11::finalize_interpreter();
     }
+
+    return success ? 0 : 1;
 }
@@ -21,6 +21,11 @@ NmodlDriver::NmodlDriver(bool strace, bool ptrace)
 
 /// parse nmodl file provided as istream
 std::shared_ptr<ast::Program> NmodlDriver::parse_stream(std::istream& in) {
+    if (arena_allocation) {
+        arena = utils::Arena::create();
+    }
+    utils::ArenaScope scope(arena_allocation ? arena.get() : utils::ArenaScope::current());
+
     NmodlLexer scanner(*this, &in);
     NmodlParser parser(scanner, *this);
 
@@ -16,6 +16,7 @@
 #include <string>
 
 #include "ast/ast.hpp"
+#include "utils/arena.hpp"
 
 
 /// encapsulates everything related to NMODL code generation framework
@@ -55,6 +56,10 @@ class NmodlParser;
  * Parsing actions generate ast and it's pointer is stored in driver
  * class.
  *
+ * With arena allocation enabled, every parse creates a new utils::Arena for
+ * the nodes of the ast. Passes transforming the ast can allocate new nodes
+ * from the same arena using utils::ArenaScope with get_arena().
+ *
  * \todo Lexer, parser and ast member variables are used inside lexer/
  * parser instances. The local instaces are created inside parse_stream
  * and hence the pointers are no longer valid except ast. Need better
@@ -87,6 +92,12 @@ class NmodlDriver {
     /// root of the ast
     std::shared_ptr<ast::Program> astRoot = nullptr;
 
+    /// allocate nodes of parsed ast from an arena
+    bool arena_allocation = false;
+
+    /// arena of the last parsed ast, memory is freed with its last node
+    utils::Arena::Handle arena;
+
   public:
     /// file or input stream name (used by scanner for position), see todo
     std::string stream_name;
@@ -113,6 +124,16 @@ class NmodlDriver {
         return verbose;
     }
 
+    /// allocate nodes of every parsed ast from a new arena
+    void set_arena_allocation(bool b) {
+        arena_allocation = b;
+    }
+
+    /// arena of the last parsed ast, nullptr if not allocated from an arena
+    utils::Arena* get_arena() const {
+        return arena.get();
+    }
+
     /// return previously parsed AST otherwise nullptr
     std::shared_ptr<ast::Program> get_ast() const {
         return astRoot;
@@ -15,6 +15,9 @@
  * \brief Implementation of Newton method for solving system of non-linear equations
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include <Eigen/LU>
 
 namespace nmodl {
@@ -28,6 +31,12 @@ namespace newton {
  * Implementation of Newton method for solving system of non-linear equations using Eigen
  *   - newton::newton_solver is the preferred option: requires user to provide Jacobian
  *   - newton::newton_numerical_diff_solver is the fallback option: Jacobian not required
+ *   - newton::newton_chord_solver and newton::newton_damped_solver are variants for stiff
+ *     systems, reusing the factorization of the Jacobian or damping the Newton step
+ *
+ * Solvers with user-provided Jacobian have converged when
+ * \f$|F(X)| < eps + rtol |X|\f$, i.e. `eps` is an absolute and `rtol` a relative
+ * tolerance for the residual.
  *
  * @{
  */
@@ -35,6 +44,15 @@ namespace newton {
 constexpr int MAX_ITER = 1e3;
 constexpr double EPS = 1e-12;
 
+/// convergence test for residual norm `error` at `X` with absolute and relative tolerance
+template <int N>
+EIGEN_DEVICE_FUNC bool is_converged(double error,
+                                    const Eigen::Matrix<double, N, 1>& X,
+                                    double eps,
+                                    double rtol) {
+    return error < eps + (rtol > 0. ? rtol * X.norm() : 0.);
+}
+
 /**
  * \brief Newton method with user-provided Jacobian
  *
@@ -53,7 +71,8 @@ template <int N, typename FUNC>
 EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, N, 1>& X,
                                     FUNC functor,
                                     double eps = EPS,
-                                    int max_iter = MAX_ITER) {
+                                    int max_iter = MAX_ITER,
+                                    double rtol = 0.) {
     // Vector to store result of function F(X):
     Eigen::Matrix<double, N, 1> F;
     // Matrix to store jacobian of F(X):
@@ -65,7 +84,7 @@ EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, N, 1>& X,
         functor(X, F, J);
         // get error norm: here we use sqrt(|F|^2)
         double error = F.norm();
-        if (error < eps) {
+        if (is_converged(error, X, eps, rtol)) {
             // we have converged: return iteration count
             return iter;
         }
@@ -77,6 +96,219 @@ EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, N, 1>& X,
     return -1;
 }
 
+/**
+ * \brief Newton method with user-provided Jacobian and linear solver
+ *
+ * Same as newton::newton_solver, but instead of a dense LU decomposition of
+ * `J(X)`, the linear system of every iteration is solved by the functor:
+ * `functor.solve(J, F)` has to overwrite `F` with \f$J^{-1} F\f$ (and may
+ * overwrite `J`). This allows to use e.g. sparse factorization generated
+ * for a known sparsity pattern of the Jacobian.
+ *
+ * @return number of iterations (-1 if failed to converge)
+ */
+template <int N, typename FUNC>
+EIGEN_DEVICE_FUNC int newton_sparse_solver(Eigen::Matrix<double, N, 1>& X,
+                                           FUNC functor,
+                                           double eps = EPS,
+                                           int max_iter = MAX_ITER,
+                                           double rtol = 0.) {
+    // Vector to store result of function F(X):
+    Eigen::Matrix<double, N, 1> F;
+    // Matrix to store jacobian of F(X):
+    Eigen::Matrix<double, N, N> J;
+    // Solver iteration count:
+    int iter = -1;
+    while (++iter < max_iter) {
+        // calculate F, J from X using user-supplied functor
+        functor(X, F, J);
+        // get error norm: here we use sqrt(|F|^2)
+        double error = F.norm();
+        if (is_converged(error, X, eps, rtol)) {
+            // we have converged: return iteration count
+            return iter;
+        }
+        // update X using user-supplied linear solver
+        functor.solve(J, F);
+        X -= F;
+    }
+    // If we fail to converge after max_iter iterations, return -1
+    return -1;
+}
+
+/**
+ * \brief Linear solver policy: dense LU decomposition with partial pivoting
+ *
+ * Linear solver policies used by newton::newton_chord_solver and
+ * newton::newton_damped_solver: `factorize(functor, J)` factorizes the
+ * Jacobian and keeps the factorization, `solve(functor, F)` overwrites `F`
+ * with \f$J^{-1} F\f$ for the last factorized `J`.
+ */
+template <int N>
+class DenseLU {
+  public:
+    template <typename FUNC>
+    EIGEN_DEVICE_FUNC void factorize(const FUNC& /* functor */,
+                                     const Eigen::Matrix<double, N, N>& J) {
+        lu.compute(J);
+    }
+
+    template <typename FUNC>
+    EIGEN_DEVICE_FUNC void solve(const FUNC& /* functor */, Eigen::Matrix<double, N, 1>& F) const {
+        F = lu.solve(F).eval();
+    }
+
+  private:
+    Eigen::PartialPivLU<Eigen::Matrix<double, N, N>> lu;
+};
+
+/**
+ * \brief Linear solver policy: factorization provided by the functor
+ *
+ * Same as newton::DenseLU, but `functor.factorize(J)` factorizes `J` in place
+ * and `functor.substitute(J, F)` overwrites `F` with \f$J^{-1} F\f$ (e.g. with
+ * straight-line sparse LU code generated for a known sparsity pattern). If
+ * `functor.factorize(J)` returns false (e.g. zero pivot of a factorization
+ * without pivoting), dense LU with partial pivoting is used instead.
+ */
+template <int N>
+class FunctorLU {
+  public:
+    template <typename FUNC>
+    EIGEN_DEVICE_FUNC void factorize(const FUNC& functor, const Eigen::Matrix<double, N, N>& J) {
+        lu = J;
+        use_dense = !functor.factorize(lu);
+        if (use_dense) {
+            dense.compute(J);
+        }
+    }
+
+    template <typename FUNC>
+    EIGEN_DEVICE_FUNC void solve(const FUNC& functor, Eigen::Matrix<double, N, 1>& F) {
+        if (use_dense) {
+            F = dense.solve(F).eval();
+        } else {
+            functor.substitute(lu, F);
+        }
+    }
+
+  private:
+    Eigen::Matrix<double, N, N> lu;
+    bool use_dense = false;
+    Eigen::PartialPivLU<Eigen::Matrix<double, N, N>> dense;
+};
+
+/// refresh Jacobian of chord method if residual decreases by less than this factor
+constexpr double CHORD_REFRESH_RATIO = 0.5;
+
+/**
+ * \brief Chord (simplified Newton) method with user-provided Jacobian
+ *
+ * Same as newton::newton_solver, but the factorization of the Jacobian is
+ * reused for subsequent iterations:
+ *
+ *  \f[
+ *     X_{n+1} = X_n - J(X_k)^{-1} F(X_n)
+ *  \f]
+ *
+ * where \f$X_k\f$ is the iterate of the last refresh. The Jacobian is
+ * factorized again only when the residual decreases by less than
+ * newton::CHORD_REFRESH_RATIO, so systems whose Jacobian varies slowly
+ * need far fewer factorizations than with the full Newton method.
+ *
+ * @tparam LU linear solver policy, newton::DenseLU or newton::FunctorLU
+ * @return number of iterations (-1 if failed to converge)
+ */
+template <int N, typename FUNC, typename LU = DenseLU<N>>
+EIGEN_DEVICE_FUNC int newton_chord_solver(Eigen::Matrix<double, N, 1>& X,
+                                          FUNC functor,
+                                          double eps = EPS,
+                                          int max_iter = MAX_ITER,
+                                          double rtol = 0.) {
+    Eigen::Matrix<double, N, 1> F;
+    Eigen::Matrix<double, N, N> J;
+    LU lu;
+    double previous_error = 0.;
+    int iter = -1;
+    while (++iter < max_iter) {
+        functor(X, F, J);
+        double error = F.norm();
+        if (is_converged(error, X, eps, rtol)) {
+            return iter;
+        }
+        // factorize at first iteration or if convergence is too slow
+        if (iter == 0 || error > CHORD_REFRESH_RATIO * previous_error) {
+            lu.factorize(functor, J);
+        }
+        previous_error = error;
+        lu.solve(functor, F);
+        X -= F;
+    }
+    return -1;
+}
+
+/// sufficient decrease parameter of newton::newton_damped_solver line search
+constexpr double DAMPING_SUFFICIENT_DECREASE = 1e-4;
+
+/// smallest step length of newton::newton_damped_solver line search
+constexpr double DAMPING_MIN_STEP = 1. / 1024;
+
+/**
+ * \brief Damped Newton method with user-provided Jacobian
+ *
+ * Same as newton::newton_solver, but with a backtracking line search: the
+ * Newton step \f$\Delta X = J(X_n)^{-1} F(X_n)\f$ is halved until
+ *
+ *  \f[
+ *     |F(X_n - \lambda \Delta X)| \leq (1 - \alpha \lambda) |F(X_n)|
+ *  \f]
+ *
+ * with \f$\alpha\f$ = newton::DAMPING_SUFFICIENT_DECREASE (or the step length
+ * \f$\lambda\f$ reaches newton::DAMPING_MIN_STEP). This makes convergence
+ * more robust for stiff systems with poor initial values. Full steps need
+ * the same number of functor evaluations as newton::newton_solver.
+ *
+ * @tparam LU linear solver policy, newton::DenseLU or newton::FunctorLU
+ * @return number of iterations (-1 if failed to converge)
+ */
+template <int N, typename FUNC, typename LU = DenseLU<N>>
+EIGEN_DEVICE_FUNC int newton_damped_solver(Eigen::Matrix<double, N, 1>& X,
+                                           FUNC functor,
+                                           double eps = EPS,
+                                           int max_iter = MAX_ITER,
+                                           double rtol = 0.) {
+    Eigen::Matrix<double, N, 1> F, F_trial, dX;
+    Eigen::Matrix<double, N, N> J, J_trial;
+    Eigen::Matrix<double, N, 1> X_trial;
+    LU lu;
+    functor(X, F, J);
+    int iter = -1;
+    while (++iter < max_iter) {
+        double error = F.norm();
+        if (is_converged(error, X, eps, rtol)) {
+            return iter;
+        }
+        lu.factorize(functor, J);
+        dX = F;
+        lu.solve(functor, dX);
+        // backtracking line search, F and J of accepted step are reused
+        double step = 1.;
+        while (true) {
+            X_trial = X - step * dX;
+            functor(X_trial, F_trial, J_trial);
+            if (F_trial.norm() <= (1. - DAMPING_SUFFICIENT_DECREASE * step) * error ||
+                step <= DAMPING_MIN_STEP) {
+                break;
+            }
+            step *= 0.5;
+        }
+        X = X_trial;
+        F = F_trial;
+        J = J_trial;
+    }
+    return -1;
+}
+
 constexpr double SQUARE_ROOT_ULP = 1e-7;
 constexpr double CUBIC_ROOT_ULP = 1e-5;
 
@@ -161,14 +393,15 @@ template <typename FUNC, int N>
 EIGEN_DEVICE_FUNC int newton_solver_small_N(Eigen::Matrix<double, N, 1>& X,
                                             FUNC functor,
                                             double eps,
-                                            int max_iter) {
+                                            int max_iter,
+                                            double rtol) {
     Eigen::Matrix<double, N, 1> F;
     Eigen::Matrix<double, N, N> J;
     int iter = -1;
     while (++iter < max_iter) {
         functor(X, F, J);
         double error = F.norm();
-        if (error < eps) {
+        if (is_converged(error, X, eps, rtol)) {
             return iter;
         }
         X -= J.inverse() * F;
@@ -180,32 +413,165 @@ template <typename FUNC>
 EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, 1, 1>& X,
                                     FUNC functor,
                                     double eps = EPS,
-                                    int max_iter = MAX_ITER) {
-    return newton_solver_small_N<FUNC, 1>(X, functor, eps, max_iter);
+                                    int max_iter = MAX_ITER,
+                                    double rtol = 0.) {
+    return newton_solver_small_N<FUNC, 1>(X, functor, eps, max_iter, rtol);
 }
 
 template <typename FUNC>
 EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, 2, 1>& X,
                                     FUNC functor,
                                     double eps = EPS,
-                                    int max_iter = MAX_ITER) {
-    return newton_solver_small_N<FUNC, 2>(X, functor, eps, max_iter);
+                                    int max_iter = MAX_ITER,
+                                    double rtol = 0.) {
+    return newton_solver_small_N<FUNC, 2>(X, functor, eps, max_iter, rtol);
 }
 
 template <typename FUNC>
 EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, 3, 1>& X,
                                     FUNC functor,
                                     double eps = EPS,
-                                    int max_iter = MAX_ITER) {
-    return newton_solver_small_N<FUNC, 3>(X, functor, eps, max_iter);
+                                    int max_iter = MAX_ITER,
+                                    double rtol = 0.) {
+    return newton_solver_small_N<FUNC, 3>(X, functor, eps, max_iter, rtol);
 }
 
 template <typename FUNC>
 EIGEN_DEVICE_FUNC int newton_solver(Eigen::Matrix<double, 4, 1>& X,
                                     FUNC functor,
                                     double eps = EPS,
-                                    int max_iter = MAX_ITER) {
-    return newton_solver_small_N<FUNC, 4>(X, functor, eps, max_iter);
+                                    int max_iter = MAX_ITER,
+                                    double rtol = 0.) {
+    return newton_solver_small_N<FUNC, 4>(X, functor, eps, max_iter, rtol);
+}
+
+/**
+ * \brief Newton method for a batch of independent systems solved in lock-step
+ *
+ * Solves \f$F_l(X_l) = 0\f$ for `lanes` independent systems of size `N`
+ * (typically one per mechanism instance), where column `l` of `X` holds the
+ * initial value of lane `l` and `functors[l]` calculates `F(X)` and `J(X)`
+ * for this lane with the same signature as for newton::newton_solver.
+ *
+ * All lanes are advanced together: the linear systems of one Newton step
+ * are solved by Gaussian elimination with partial pivoting where the
+ * innermost loops run over lanes, so that they can be vectorized with `W`
+ * being the SIMD width. `X` is row-major so that the values of one unknown
+ * are contiguous across lanes. Lanes that have converged (as well as unused
+ * lanes `lanes <= l < W`) are masked: their functor is not called anymore
+ * and their column of `X` is not updated.
+ *
+ * \note Only the linear solve runs in lock-step : functors are still called
+ * one lane at a time with scalar code.
+ *
+ * @param X          initial values / solutions, one lane per column
+ * @param functors   array of at least `lanes` functors
+ * @param lanes      number of active lanes (`<= W`)
+ * @param iterations number of iterations of every lane (-1 if failed to converge)
+ * @return maximum number of iterations over all lanes (-1 if any lane failed to converge)
+ */
+template <int N, int W, typename FUNC>
+int newton_solver_batch(Eigen::Matrix<double, N, W, Eigen::RowMajor>& X,
+                        FUNC* functors,
+                        int lanes,
+                        int* iterations,
+                        double eps = EPS,
+                        int max_iter = MAX_ITER,
+                        double rtol = 0.) {
+    // Vector and Jacobian of one lane as expected by functor
+    Eigen::Matrix<double, N, 1> X_lane;
+    Eigen::Matrix<double, N, 1> F_lane;
+    Eigen::Matrix<double, N, N> J_lane;
+    // F and J of all lanes with lane index innermost
+    double F[N][W];
+    double J[N][N][W];
+    // per lane convergence mask
+    bool active[W];
+    for (int l = 0; l < W; ++l) {
+        active[l] = l < lanes;
+        if (l < lanes) {
+            iterations[l] = -1;
+        }
+    }
+    int iter = -1;
+    while (++iter < max_iter) {
+        // calculate F, J of unconverged lanes, converged lanes solve identity system
+        int n_active = 0;
+        for (int l = 0; l < W; ++l) {
+            if (active[l]) {
+                X_lane = X.col(l);
+                functors[l](X_lane, F_lane, J_lane);
+                if (is_converged(F_lane.norm(), X_lane, eps, rtol)) {
+                    iterations[l] = iter;
+                    active[l] = false;
+                }
+            }
+            for (int i = 0; i < N; ++i) {
+                F[i][l] = active[l] ? F_lane[i] : 0.0;
+                for (int j = 0; j < N; ++j) {
+                    J[i][j][l] = active[l] ? J_lane(i, j) : (i == j ? 1.0 : 0.0);
+                }
+            }
+            n_active += active[l];
+        }
+        if (n_active == 0) {
+            int max_iterations = 0;
+            for (int l = 0; l < lanes; ++l) {
+                max_iterations = std::max(max_iterations, iterations[l]);
+            }
+            return max_iterations;
+        }
+        // forward elimination with per lane partial pivoting
+        for (int k = 0; k < N; ++k) {
+            int pivot[W];
+            double pivot_value[W];
+            for (int l = 0; l < W; ++l) {
+                pivot[l] = k;
+                pivot_value[l] = std::abs(J[k][k][l]);
+            }
+            for (int i = k + 1; i < N; ++i) {
+                for (int l = 0; l < W; ++l) {
+                    bool larger = std::abs(J[i][k][l]) > pivot_value[l];
+                    pivot[l] = larger ? i : pivot[l];
+                    pivot_value[l] = larger ? std::abs(J[i][k][l]) : pivot_value[l];
+                }
+            }
+            for (int j = k; j < N; ++j) {
+                for (int l = 0; l < W; ++l) {
+                    double tmp = J[k][j][l];
+                    J[k][j][l] = J[pivot[l]][j][l];
+                    J[pivot[l]][j][l] = tmp;
+                }
+            }
+            for (int l = 0; l < W; ++l) {
+                double tmp = F[k][l];
+                F[k][l] = F[pivot[l]][l];
+                F[pivot[l]][l] = tmp;
+            }
+            for (int i = k + 1; i < N; ++i) {
+                for (int l = 0; l < W; ++l) {
+                    double factor = J[i][k][l] / J[k][k][l];
+                    for (int j = k + 1; j < N; ++j) {
+                        J[i][j][l] -= factor * J[k][j][l];
+                    }
+                    F[i][l] -= factor * F[k][l];
+                }
+            }
+        }
+        // back substitution, update X in place (masked lanes have zero update)
+        for (int i = N - 1; i >= 0; --i) {
+            for (int l = 0; l < W; ++l) {
+                double sum = F[i][l];
+                for (int j = i + 1; j < N; ++j) {
+                    sum -= J[i][j][l] * F[j][l];
+                }
+                F[i][l] = sum / J[i][i][l];
+                X(i, l) -= F[i][l];
+            }
+        }
+    }
+    // If we fail to converge after max_iter iterations, return -1
+    return -1;
 }
 
 /** @} */  // end of solver
@@ -0,0 +1,217 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief Convergence statistics of Newton solver in generated code
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace nmodl {
+namespace newton {
+
+/**
+ * @addtogroup solver
+ * @{
+ */
+
+/**
+ * \brief Convergence statistics of Newton solver calls of a mechanism
+ *
+ * Iteration counts are collected in a histogram with one bin per count,
+ * the last bin also holds all larger counts. Residual norms \f$|F(X)|\f$
+ * are those of the final iterate of every call.
+ */
+struct NewtonStats {
+    /// number of histogram bins, last bin collects all calls with more iterations
+    static constexpr int NUM_BINS = 32;
+
+    /// number of calls per iteration count of converged calls
+    std::array<long, NUM_BINS> iterations{};
+
+    /// number of solver calls
+    long calls = 0;
+
+    /// number of calls that failed to converge
+    long failures = 0;
+
+    /// total number of iterations of converged calls
+    long total_iterations = 0;
+
+    /// sum of final residual norms
+    double sum_residual = 0.;
+
+    /// maximum of final residual norms
+    double max_residual = 0.;
+
+    /// record result of one solver call (iteration count -1 for failure)
+    void record(int iteration_count, double residual) {
+        calls++;
+        if (iteration_count < 0) {
+            failures++;
+        } else {
+            iterations[std::min(iteration_count, NUM_BINS - 1)]++;
+            total_iterations += iteration_count;
+        }
+        sum_residual += residual;
+        max_residual = std::max(max_residual, residual);
+    }
+
+    /// record result of one solver call and compute residual norm at solution X
+    template <int N, typename FUNC>
+    void record(int iteration_count, const Eigen::Matrix<double, N, 1>& X, const FUNC& functor) {
+        Eigen::Matrix<double, N, 1> F;
+        Eigen::Matrix<double, N, N> J;
+        functor(X, F, J);
+        record(iteration_count, F.norm());
+    }
+
+    /// accumulate statistics of another buffer (e.g. from other thread)
+    void merge(const NewtonStats& other) {
+        for (int i = 0; i < NUM_BINS; i++) {
+            iterations[i] += other.iterations[i];
+        }
+        calls += other.calls;
+        failures += other.failures;
+        total_iterations += other.total_iterations;
+        sum_residual += other.sum_residual;
+        max_residual = std::max(max_residual, other.max_residual);
+    }
+
+    /// print statistics as JSON object
+    void to_json(std::ostream& stream) const {
+        // trailing empty bins are omitted
+        int num_bins = NUM_BINS;
+        while (num_bins > 0 && iterations[num_bins - 1] == 0) {
+            num_bins--;
+        }
+        stream << "{\"calls\": " << calls << ", \"failures\": " << failures
+               << ", \"total_iterations\": " << total_iterations << ", \"iterations\": [";
+        for (int i = 0; i < num_bins; i++) {
+            stream << (i ? ", " : "") << iterations[i];
+        }
+        stream << "], \"mean_residual\": " << (calls ? sum_residual / calls : 0.)
+               << ", \"max_residual\": " << max_residual << "}";
+    }
+};
+
+
+/// statistics per mechanism name
+using NewtonStatsMap = std::map<std::string, NewtonStats>;
+
+
+/**
+ * \brief Registry of the thread-local statistics buffers of all threads
+ *
+ * Buffers are shared with the registry so that statistics of finished
+ * threads are still available. If the environment variable
+ * `NMODL_NEWTON_STATS` is set, statistics of all threads are written as
+ * JSON to the file it names at program exit.
+ */
+class NewtonStatsRegistry {
+  public:
+    static NewtonStatsRegistry& instance() {
+        static NewtonStatsRegistry registry;
+        return registry;
+    }
+
+    /// create new buffer for calling thread
+    std::shared_ptr<NewtonStatsMap> new_buffer() {
+        auto buffer = std::make_shared<NewtonStatsMap>();
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(buffer);
+        return buffer;
+    }
+
+    /// statistics of all threads, should not be called while solvers are running
+    NewtonStatsMap merged() {
+        NewtonStatsMap result;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& buffer: buffers) {
+            for (const auto& stats: *buffer) {
+                result[stats.first].merge(stats.second);
+            }
+        }
+        return result;
+    }
+
+    /// print statistics of all threads as JSON object with mechanism names as keys
+    void to_json(std::ostream& stream) {
+        stream << "{";
+        bool first = true;
+        for (const auto& stats: merged()) {
+            stream << (first ? "" : ",") << "\n  \"" << stats.first << "\": ";
+            stats.second.to_json(stream);
+            first = false;
+        }
+        stream << "\n}\n";
+    }
+
+    /// reset statistics of all threads
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& buffer: buffers) {
+            buffer->clear();
+        }
+    }
+
+    ~NewtonStatsRegistry() {
+        const char* filename = std::getenv("NMODL_NEWTON_STATS");
+        if (filename != nullptr && *filename != '\0') {
+            std::ofstream stream(filename);
+            to_json(stream);
+        }
+    }
+
+  private:
+    NewtonStatsRegistry() = default;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<NewtonStatsMap>> buffers;
+};
+
+
+/**
+ * \brief Statistics buffer of calling thread for given mechanism
+ *
+ * Lookup involves a map search, generated code calls this once per thread
+ * and keeps the reference.
+ */
+inline NewtonStats& thread_newton_stats(const std::string& mechanism) {
+    static thread_local std::shared_ptr<NewtonStatsMap> buffer =
+        NewtonStatsRegistry::instance().new_buffer();
+    return (*buffer)[mechanism];
+}
+
+/// write statistics of all threads as JSON
+inline void write_newton_stats_json(std::ostream& stream) {
+    NewtonStatsRegistry::instance().to_json(stream);
+}
+
+/// reset statistics of all threads
+inline void clear_newton_stats() {
+    NewtonStatsRegistry::instance().clear();
+}
+
+/** @} */  // end of solver
+
+}  // namespace newton
+}  // namespace nmodl
@@ -5,6 +5,7 @@
  * Lesser General Public License. See top-level LICENSE file for details.
  *************************************************************************/
 
+#include <algorithm>
 #include <utility>
 
 #include "ast/ast.hpp"
@@ -20,7 +21,7 @@ using syminfo::NmodlType;
 using syminfo::Status;
 
 
-int SymbolTable::Table::counter = 0;
+std::atomic<int> SymbolTable::Table::counter(0);
 
 /**
  *  Insert symbol into current symbol table. There are certain
@@ -28,7 +29,7 @@ int SymbolTable::Table::counter = 0;
  */
 void SymbolTable::Table::insert(const std::shared_ptr<Symbol>& symbol) {
     std::string name = symbol->get_name();
-    if (lookup(name) != nullptr) {
+    if (!index.emplace(name, symbol).second) {
         throw std::runtime_error("Trying to re-insert symbol " + name);
     }
     symbol->set_id(counter++);
@@ -37,12 +38,41 @@ void SymbolTable::Table::insert(const std::shared_ptr<Symbol>& symbol) {
 
 
 std::shared_ptr<Symbol> SymbolTable::Table::lookup(const std::string& name) const {
-    for (const auto& symbol: symbols) {
-        if (symbol->get_name() == name) {
-            return symbol;
-        }
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+
+/// removal keeps the order of remaining symbols and hence is linear
+bool SymbolTable::Table::remove(const std::string& name) {
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return false;
     }
-    return nullptr;
+    auto symbol = it->second;
+    index.erase(it);
+    symbols.erase(std::find(symbols.begin(), symbols.end(), symbol));
+    return true;
+}
+
+
+std::shared_ptr<Symbol> SymbolTable::Table::rename(const std::string& name,
+                                                   const std::string& new_name) {
+    if (lookup(new_name) != nullptr) {
+        throw std::runtime_error("Trying to rename " + name + " to existing symbol " + new_name);
+    }
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    auto symbol = it->second;
+    index.erase(it);
+    symbol->set_name(new_name);
+    index.emplace(new_name, symbol);
+    return symbol;
 }
 
 
@@ -163,6 +193,16 @@ bool SymbolTable::under_global_scope() {
 }
 
 
+void SymbolTable::get_qualified_names(std::set<std::string>& names) const {
+    for (const auto& symbol: table.symbols) {
+        names.insert(symtab_name + "::" + symbol->get_name());
+    }
+    for (const auto& item: children) {
+        item.second->get_qualified_names(names);
+    }
+}
+
+
 /// lookup for symbol in current scope as well as all parents
 std::shared_ptr<Symbol> SymbolTable::lookup_in_scope(const std::string& name) const {
     auto symbol = table.lookup(name);
@@ -346,7 +386,7 @@ std::shared_ptr<Symbol> ModelSymbolTable::insert(const std::shared_ptr<Symbol>&
  *  \todo We should add position information to make name unique
  */
 std::string ModelSymbolTable::get_unique_name(const std::string& name, Ast* node, bool is_global) {
-    static int block_counter = 0;
+    static std::atomic<int> block_counter(0);
     std::string new_name(name);
     if (is_global) {
         new_name = GLOBAL_SYMTAB_NAME;
@@ -15,8 +15,11 @@
  * \brief Implement classes for representing symbol table at block and file scope
  */
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "symtab/symbol.hpp"
@@ -61,16 +64,24 @@ class SymbolTable {
      *
      * Table is used to store information about every block construct
      * encountered in the nmodl file. Each symbol has name but for fast lookup,
-     * we create map with the associated name.
+     * we create map with the associated name. Symbols are also kept in the
+     * order of insertion which is used for iteration (e.g. printing, code
+     * generation).
+     *
+     * \note Symbols in the table must be renamed with rename() and not with
+     * Symbol::set_name() to keep the map consistent.
      *
      * \todo Re-implement pretty printing
      */
     class Table {
-        /// number of tables
-        static int counter;
+        /// number of symbols (atomic as mod files can be processed concurrently)
+        static std::atomic<int> counter;
 
-      public:
         /// map of symbol name and associated symbol for faster lookup
+        std::unordered_map<std::string, std::shared_ptr<Symbol>> index;
+
+      public:
+        /// symbols in the order of insertion (modified only by insert, remove and rename)
         std::vector<std::shared_ptr<Symbol>> symbols;
 
         /// insert new symbol into table
@@ -79,6 +90,12 @@ class SymbolTable {
         /// check if symbol with given name exist
         std::shared_ptr<Symbol> lookup(const std::string& name) const;
 
+        /// remove symbol with given name, return true if it existed
+        bool remove(const std::string& name);
+
+        /// rename symbol with given name, return renamed symbol if it existed
+        std::shared_ptr<Symbol> rename(const std::string& name, const std::string& new_name);
+
         /// pretty print
         void print(std::stringstream& stream, std::string title, int indent);
     };
@@ -162,6 +179,16 @@ class SymbolTable {
         table.insert(symbol);
     }
 
+    /// remove symbol with given name from the current table (but not from parents)
+    bool remove(const std::string& name) {
+        return table.remove(name);
+    }
+
+    /// rename symbol with given name in the current table (but not in parents)
+    std::shared_ptr<Symbol> rename(const std::string& name, const std::string& new_name) {
+        return table.rename(name, new_name);
+    }
+
     void set_parent_table(SymbolTable* block) {
         parent = block;
     }
@@ -194,6 +221,9 @@ class SymbolTable {
 
     void print(std::stringstream& ss, int level);
 
+    /// add names of symbols in current and all children tables as "table::symbol"
+    void get_qualified_names(std::set<std::string>& names) const;
+
     std::string title() const;
 
     std::string position() const;
@@ -0,0 +1,189 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief Arena allocator for many small objects released together
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace nmodl {
+namespace utils {
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/**
+ * \class Arena
+ * \brief Bump allocator for objects that are released together
+ *
+ * Objects are placed one after another in large chunks of memory. This avoids
+ * a call to the system allocator for every object and keeps objects allocated
+ * together (e.g. nodes of an AST) close in memory. Memory of individual objects
+ * is not reused : deallocation only drops a reference and all chunks are freed
+ * at once when the owner has released the arena and the last object allocated
+ * from it is deallocated.
+ *
+ * Allocation is not thread safe, deallocation is.
+ */
+class Arena {
+  public:
+    /// releases the arena of owner, see Arena::create
+    struct Releaser {
+        void operator()(Arena* arena) const {
+            arena->unreference();
+        }
+    };
+
+    /// owner of an arena
+    using Handle = std::unique_ptr<Arena, Releaser>;
+
+  private:
+    /// allocated chunks of memory
+    std::vector<char*> chunks;
+
+    /// size of new chunks
+    std::size_t chunk_size;
+
+    /// next free byte in current chunk
+    char* next = nullptr;
+
+    /// end of current chunk
+    char* end = nullptr;
+
+    /// number of live objects plus one for the owner
+    std::atomic<std::size_t> references{1};
+
+    explicit Arena(std::size_t chunk_size)
+        : chunk_size(chunk_size) {}
+
+    ~Arena() {
+        for (auto chunk: chunks) {
+            std::free(chunk);
+        }
+    }
+
+    void unreference() {
+        if (--references == 0) {
+            delete this;
+        }
+    }
+
+  public:
+    /// alignment of all allocations
+    static std::size_t alignment() {
+        return alignof(std::max_align_t);
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// create new arena, memory is freed after owner and all objects are gone
+    static Handle create(std::size_t chunk_size = 1 << 20) {
+        return Handle(new Arena(chunk_size));
+    }
+
+    /// allocate memory for an object
+    void* allocate(std::size_t size) {
+        size = (size + alignment() - 1) / alignment() * alignment();
+        if (size > static_cast<std::size_t>(end - next)) {
+            auto new_chunk_size = std::max(chunk_size, size);
+            auto chunk = static_cast<char*>(std::malloc(new_chunk_size));
+            if (chunk == nullptr) {
+                throw std::bad_alloc();
+            }
+            chunks.push_back(chunk);
+            next = chunk;
+            end = chunk + new_chunk_size;
+        }
+        auto memory = next;
+        next += size;
+        ++references;
+        return memory;
+    }
+
+    /// deallocate memory of an object
+    void deallocate() {
+        unreference();
+    }
+};
+
+
+/**
+ * \class ArenaScope
+ * \brief Allocate objects from given arena while in scope
+ *
+ * Classes supporting arena allocation (i.e. using allocate_object and
+ * deallocate_object in their operator new and delete) allocate new objects
+ * from the arena of the innermost scope of the current thread, or from the
+ * heap if there is no scope or its arena is nullptr.
+ */
+class ArenaScope {
+  private:
+    /// arena of the enclosing scope
+    Arena* previous;
+
+  public:
+    explicit ArenaScope(Arena* arena)
+        : previous(current()) {
+        current() = arena;
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() {
+        current() = previous;
+    }
+
+    /// arena used for allocations by the current thread
+    static Arena*& current() {
+        static thread_local Arena* arena = nullptr;
+        return arena;
+    }
+};
+
+
+/// allocate object from arena of current scope (or heap) remembering its origin
+inline void* allocate_object(std::size_t size) {
+    auto header = Arena::alignment();
+    auto arena = ArenaScope::current();
+    void* memory = arena ? arena->allocate(size + header) : ::operator new(size + header);
+    *static_cast<Arena**>(memory) = arena;
+    return static_cast<char*>(memory) + header;
+}
+
+
+/// deallocate object allocated with allocate_object
+inline void deallocate_object(void* object) noexcept {
+    if (object == nullptr) {
+        return;
+    }
+    auto memory = static_cast<char*>(object) - Arena::alignment();
+    auto arena = *reinterpret_cast<Arena**>(memory);
+    if (arena) {
+        arena->deallocate();
+    } else {
+        ::operator delete(memory);
+    }
+}
+
+/** @} */  // end of utils
+
+}  // namespace utils
+}  // namespace nmodl
@@ -64,7 +64,7 @@ std::string generate_random_string(const int len) {
         "abcdefghijklmnopqrstuvwxyz";
     std::random_device dev;
     std::mt19937 rng(dev());
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, (sizeof(alphanum) - 1));
+    std::uniform_int_distribution<std::mt19937::result_type> dist(0, (sizeof(alphanum) - 2));
     for (int i = 0; i < len; ++i) {
         s[i] = alphanum[dist(rng)];
     }
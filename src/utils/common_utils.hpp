@@ -9,6 +9,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 
 /**
  *
@@ -87,6 +88,7 @@ class SingletonRandomString {
      * @return true if it exists, false if not
      */
     bool random_string_exists(const std::string& var_name) const {
+        std::lock_guard<std::mutex> lock(random_strings_mutex);
         return (random_strings.find(var_name) != random_strings.end());
     }
 
@@ -96,6 +98,7 @@ class SingletonRandomString {
      * @return Random string assigned to var_name
      */
     std::string get_random_string(const std::string& var_name) const {
+        std::lock_guard<std::mutex> lock(random_strings_mutex);
         return random_strings.at(var_name);
     }
 
@@ -106,12 +109,8 @@ class SingletonRandomString {
      * @return Random string assigned to var_name
      */
     std::string reset_random_string(const std::string& var_name) {
-        if (random_string_exists(var_name)) {
-            random_strings.erase(var_name);
-            random_strings.insert({var_name, generate_random_string(SIZE)});
-        } else {
-            random_strings.insert({var_name, generate_random_string(SIZE)});
-        }
+        std::lock_guard<std::mutex> lock(random_strings_mutex);
+        random_strings[var_name] = generate_random_string(SIZE);
         return random_strings[var_name];
     }
 
@@ -126,6 +125,9 @@ class SingletonRandomString {
 
     /// std::map that keeps the random strings assigned to variables as suffix
     std::map<std::string, std::string> random_strings;
+
+    /// mutex guarding random_strings as mod files can be processed concurrently
+    mutable std::mutex random_strings_mutex;
 };
 
 /** @} */  // end of utils
@@ -0,0 +1,146 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+#include <utility>
+
+#include "utils/common_utils.hpp"
+#include "utils/file_cache.hpp"
+
+namespace nmodl {
+namespace utils {
+
+/// name of the file listing all files of a cache entry
+static const std::string MANIFEST_FILE = "MANIFEST";
+
+
+/// 64-bit FNV-1a hash, stable across platforms and runs
+static uint64_t fnv1a_hash(const std::string& text, uint64_t hash = 14695981039346656037ULL) {
+    for (const auto ch: text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+static bool copy_file(const std::string& source, const std::string& destination) {
+    std::ifstream in(source, std::ios::binary);
+    if (!in.good()) {
+        return false;
+    }
+    std::ofstream out(destination, std::ios::binary);
+    out << in.rdbuf();
+    return out.good();
+}
+
+
+FileCache::FileCache(std::string cache_dir)
+    : cache_dir(std::move(cache_dir)) {}
+
+
+/// hash as fixed width hexadecimal string
+static std::string to_hex(uint64_t hash) {
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+
+/**
+ * \details Windows line endings and trailing whitespace are dropped, the
+ * name, text and options are hashed separately so that they can't alias.
+ */
+std::string FileCache::make_key(const std::string& mod_name,
+                                const std::string& mod_text,
+                                const std::string& options) {
+    std::string normalized;
+    normalized.reserve(mod_text.size());
+    std::istringstream stream(mod_text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        auto end = line.find_last_not_of(" \t\r");
+        normalized += line.substr(0, end == std::string::npos ? 0 : end + 1);
+        normalized += '\n';
+    }
+    auto hash = fnv1a_hash(options, fnv1a_hash(normalized, fnv1a_hash(mod_name)));
+    return to_hex(hash);
+}
+
+
+std::string FileCache::hash_file(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::ostringstream content;
+    if (in.good()) {
+        content << in.rdbuf();
+    }
+    return to_hex(fnv1a_hash(content.str()));
+}
+
+
+bool FileCache::restore(const std::string& key, const std::string& output_dir) const {
+    auto entry_dir = cache_dir + "/" + key;
+    std::ifstream manifest(entry_dir + "/" + MANIFEST_FILE);
+    if (!manifest.good()) {
+        return false;
+    }
+    std::string name;
+    while (std::getline(manifest, name)) {
+        if (!copy_file(entry_dir + "/" + name, output_dir + "/" + name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * \details Files are written into a uniquely named temporary directory which
+ * is then renamed to the final entry name. If another job has stored the same
+ * entry in the meantime, rename fails and temporary directory is removed.
+ */
+bool FileCache::store(const std::string& key, const std::vector<std::string>& files) const {
+    auto entry_dir = cache_dir + "/" + key;
+    auto tmp_dir = entry_dir + ".tmp." + generate_random_string(8);
+    if (!make_path(tmp_dir)) {
+        return false;
+    }
+
+    std::vector<std::string> names;
+    bool success = true;
+    for (const auto& file: files) {
+        auto name = base_name(file);
+        success = success && copy_file(file, tmp_dir + "/" + name);
+        names.push_back(name);
+    }
+    if (success) {
+        std::ofstream manifest(tmp_dir + "/" + MANIFEST_FILE);
+        for (const auto& name: names) {
+            manifest << name << "\n";
+        }
+        success = manifest.good();
+    }
+    if (success && std::rename(tmp_dir.c_str(), entry_dir.c_str()) == 0) {
+        return true;
+    }
+
+    // cleanup partially written or duplicate entry
+    names.push_back(MANIFEST_FILE);
+    for (const auto& name: names) {
+        unlink((tmp_dir + "/" + name).c_str());
+    }
+    rmdir(tmp_dir.c_str());
+    return false;
+}
+
+}  // namespace utils
+}  // namespace nmodl
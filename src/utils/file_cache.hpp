@@ -0,0 +1,101 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief Implement content-addressed cache for generated files
+ */
+
+#include <string>
+#include <vector>
+
+
+namespace nmodl {
+namespace utils {
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/**
+ * \class FileCache
+ * \brief On-disk cache of generated files addressed by content hash
+ *
+ * Code generation output only depends on the mod file name and content,
+ * the command line options (including the units file) and the version of
+ * NMODL. The caller computes
+ * a key from these inputs using FileCache::make_key and, on a cache hit,
+ * can copy previously generated files into the output directory instead
+ * of running all passes again.
+ *
+ * Every entry is a directory `<cache_dir>/<key>` holding copies of the
+ * generated files and a `MANIFEST` file listing them. Entries are first
+ * written into a temporary directory and then renamed so that concurrent
+ * jobs or processes never observe partially written entries.
+ */
+class FileCache {
+  public:
+    /// cache with entries stored under given directory
+    explicit FileCache(std::string cache_dir);
+
+    /**
+     * Compute cache key for given mod file text and options
+     *
+     * Mod file text is normalized (line endings and trailing whitespace)
+     * so that insignificant edits don't invalidate the cache entry. The
+     * name of the mod file is part of the key as generated files are named
+     * after it.
+     *
+     * \param mod_name name of mod file without directory and extension
+     * \param mod_text content of mod file
+     * \param options  string representing all options affecting the output
+     * \return         hexadecimal hash string
+     */
+    static std::string make_key(const std::string& mod_name,
+                                const std::string& mod_text,
+                                const std::string& options);
+
+    /**
+     * Compute hash of the content of given file, e.g. to add input files
+     * other than the mod file to the options of make_key
+     *
+     * \param filename file to hash
+     * \return         hexadecimal hash string (hash of empty content if
+     *                  file can't be read)
+     */
+    static std::string hash_file(const std::string& filename);
+
+    /**
+     * Copy files of the entry with given key into output directory
+     *
+     * \param key        cache key from FileCache::make_key
+     * \param output_dir directory where files should be restored
+     * \return           true if entry exist and all files were restored
+     */
+    bool restore(const std::string& key, const std::string& output_dir) const;
+
+    /**
+     * Store copy of given files as entry with given key
+     *
+     * \param key   cache key from FileCache::make_key
+     * \param files paths of files to store
+     * \return      true if the entry was stored
+     */
+    bool store(const std::string& key, const std::vector<std::string>& files) const;
+
+  private:
+    /// directory where cache entries are stored
+    std::string cache_dir;
+};
+
+/** @} */  // end of utils
+
+}  // namespace utils
+}  // namespace nmodl
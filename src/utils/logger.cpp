@@ -30,6 +30,13 @@ struct Logger {
 };
 
 Logger nmodl_logger("NMODL", "[%n] [%^%l%$] :: %v");
-logger_type logger = nmodl_logger.logger;
+thread_local logger_type logger = nmodl_logger.logger;
+
+logger_type make_logger(const std::string& name) {
+    const auto& sinks = nmodl_logger.logger->sinks();
+    auto new_logger = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+    new_logger->set_level(nmodl_logger.logger->level());
+    return new_logger;
+}
 
 }  // namespace nmodl
\ No newline at end of file
@@ -21,6 +21,11 @@
 namespace nmodl {
 
 using logger_type = std::shared_ptr<spdlog::logger>;
-extern logger_type logger;
+
+/// logger used by current thread, defaults to the global nmodl logger
+extern thread_local logger_type logger;
+
+/// create logger with given name that writes into the sinks of global nmodl logger
+logger_type make_logger(const std::string& name);
 
 }  // namespace nmodl
@@ -0,0 +1,92 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief Process independent work items using a pool of worker threads
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nmodl {
+namespace utils {
+
+/**
+ * Check if work items are processed by worker threads
+ *
+ * With a single job or a single item, items are processed in the calling thread.
+ */
+inline bool use_worker_threads(int num_jobs, std::size_t num_items) {
+    return num_jobs > 1 && num_items > 1;
+}
+
+/**
+ * Process work items using a pool of worker threads
+ *
+ * Workers pick the next unprocessed item from a shared counter so that one
+ * expensive item doesn't hold back the others. Once processing of any item
+ * fails, no new item is started. An exception thrown while processing an item
+ * is re-thrown in the calling thread after all workers have finished.
+ *
+ * \param items    list of work items (e.g. mod files) to process
+ * \param num_jobs number of worker threads (see \ref use_worker_threads)
+ * \param process  callback processing one item, returns false on failure
+ * \return         true if all items were processed successfully
+ */
+template <typename Func>
+bool process_in_parallel(const std::vector<std::string>& items, int num_jobs, Func process) {
+    std::atomic<std::size_t> next_item(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr exception;
+    std::mutex exception_mutex;
+
+    auto worker = [&]() {
+        std::size_t index;
+        while (!failed && (index = next_item++) < items.size()) {
+            try {
+                if (!process(items[index])) {
+                    failed = true;
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    if (!use_worker_threads(num_jobs, items.size())) {
+        worker();
+    } else {
+        std::vector<std::thread> workers;
+        auto num_workers = std::min<std::size_t>(num_jobs, items.size());
+        for (std::size_t i = 0; i < num_workers; i++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& thread: workers) {
+            thread.join();
+        }
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+    return !failed;
+}
+
+}  // namespace utils
+}  // namespace nmodl
@@ -0,0 +1,581 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "utils/logger.hpp"
+#include "visitors/auto_table_visitor.hpp"
+#include "visitors/defuse_analyze_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/perf_visitor.hpp"
+#include "visitors/var_usage_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+
+namespace nmodl {
+namespace visitor {
+
+using namespace fmt::literals;
+using symtab::SymbolTable;
+using symtab::syminfo::NmodlType;
+
+/// cost of division relative to basic arithmetic operation
+static const double DIVISION_COST = 4.;
+
+/// cost of exp, log and pow relative to basic arithmetic operation
+static const double TRANSCENDENTAL_COST = 20.;
+
+/// number of sample intervals for estimating interpolation error
+static const int NUM_SAMPLES = 2000;
+
+/// minimum number of table intervals
+static const int MIN_TABLE_INTERVALS = 20;
+
+/// maximum number of table intervals, procedure is not tabulated if more are needed
+static const int MAX_TABLE_INTERVALS = 20000;
+
+/// maximum nesting depth of function calls during evaluation
+static const int MAX_CALL_DEPTH = 16;
+
+/// temperature used for evaluation if `celsius` is not declared as PARAMETER
+static const double DEFAULT_CELSIUS = 6.3;
+
+
+/**
+ * \brief Evaluates procedure at translation time
+ *
+ * Supports the subset of NMODL used in typical rate procedures: assignments,
+ * if-else statements, arithmetic, math functions and calls to FUNCTIONs.
+ * Throws std::runtime_error for any other construct as well as for reads of
+ * variables without value known at translation time.
+ */
+class TableEvaluator {
+  private:
+    using Scope = std::map<std::string, double>;
+
+    /// functions by name
+    const std::map<std::string, ast::FunctionBlock*>& functions;
+
+    /// current function call depth
+    int depth = 0;
+
+    double value_of(const std::string& name, const Scope& scope, SymbolTable* symtab);
+
+    void assign(const std::string& name,
+                double value,
+                Scope& scope,
+                SymbolTable* symtab,
+                const std::string& function_name);
+
+    double call(ast::FunctionCall* node, Scope& scope, SymbolTable* symtab);
+
+    double evaluate(ast::Expression* node, Scope& scope, SymbolTable* symtab);
+
+    void execute(ast::StatementBlock* node,
+                 Scope& scope,
+                 SymbolTable* symtab,
+                 const std::string& function_name);
+
+  public:
+    explicit TableEvaluator(const std::map<std::string, ast::FunctionBlock*>& functions)
+        : functions(functions) {}
+
+    /// global variables read (other than constants)
+    std::set<std::string> depend_variables;
+
+    /// global variables written with their values, in order of first definition
+    std::vector<std::pair<std::string, double>> outputs;
+
+    /// evaluate procedure for given argument
+    void run(ast::ProcedureBlock* node, double argument);
+};
+
+
+double TableEvaluator::value_of(const std::string& name, const Scope& scope, SymbolTable* symtab) {
+    auto it = scope.find(name);
+    if (it != scope.end()) {
+        return it->second;
+    }
+    auto symbol = symtab->lookup_in_scope(name);
+    if (symbol == nullptr) {
+        throw std::runtime_error("unknown variable {}"_format(name));
+    }
+    if (symbol->has_any_property(NmodlType::local_var | NmodlType::argument)) {
+        throw std::runtime_error("{} used before definition"_format(name));
+    }
+    if (symbol->is_array()) {
+        throw std::runtime_error("{} is an array"_format(name));
+    }
+    auto value = symbol->get_value();
+    if (symbol->has_any_property(NmodlType::constant_var | NmodlType::factor_def) &&
+        value != nullptr) {
+        return *value;
+    }
+    if (symbol->has_any_property(NmodlType::param_assign) &&
+        !symbol->has_any_property(NmodlType::range_var)) {
+        depend_variables.insert(name);
+        return value != nullptr ? *value : 0.;
+    }
+    if (name == "celsius") {
+        depend_variables.insert(name);
+        return DEFAULT_CELSIUS;
+    }
+    throw std::runtime_error("{} is not a global PARAMETER or CONSTANT"_format(name));
+}
+
+
+/**
+ * Local variables, arguments and the return variable of functions are kept in the
+ * scope. Procedure may additionally define (non-state, non-ion) ASSIGNED variables.
+ */
+void TableEvaluator::assign(const std::string& name,
+                            double value,
+                            Scope& scope,
+                            SymbolTable* symtab,
+                            const std::string& function_name) {
+    auto symbol = symtab->lookup_in_scope(name);
+    if (symbol == nullptr) {
+        throw std::runtime_error("unknown variable {}"_format(name));
+    }
+    if (symbol->has_any_property(NmodlType::local_var | NmodlType::argument) ||
+        name == function_name) {
+        scope[name] = value;
+        return;
+    }
+    // clang-format off
+    const NmodlType excluded_properties = NmodlType::state_var
+                                        | NmodlType::param_assign
+                                        | NmodlType::read_ion_var
+                                        | NmodlType::write_ion_var
+                                        | NmodlType::nonspecific_cur_var
+                                        | NmodlType::electrode_cur_var
+                                        | NmodlType::pointer_var
+                                        | NmodlType::bbcore_pointer_var
+                                        | NmodlType::extern_var
+                                        | NmodlType::extern_neuron_variable;
+    // clang-format on
+    if (!function_name.empty() || !symbol->has_any_property(NmodlType::assigned_definition) ||
+        symbol->has_any_property(excluded_properties) || symbol->is_array()) {
+        throw std::runtime_error("assignment to {} not supported"_format(name));
+    }
+    scope[name] = value;
+    auto it = std::find_if(outputs.begin(),
+                           outputs.end(),
+                           [&name](const std::pair<std::string, double>& output) {
+                               return output.first == name;
+                           });
+    if (it == outputs.end()) {
+        outputs.emplace_back(name, value);
+    } else {
+        it->second = value;
+    }
+}
+
+
+double TableEvaluator::call(ast::FunctionCall* node, Scope& scope, SymbolTable* symtab) {
+    auto name = node->get_node_name();
+    std::vector<double> arguments;
+    for (const auto& argument: node->get_arguments()) {
+        arguments.push_back(evaluate(argument.get(), scope, symtab));
+    }
+
+    // clang-format off
+    static const std::map<std::string, double (*)(double)> unary_functions = {
+        {"exp", std::exp}, {"log", std::log}, {"log10", std::log10}, {"sqrt", std::sqrt},
+        {"fabs", std::fabs}, {"sin", std::sin}, {"cos", std::cos}, {"tan", std::tan},
+        {"sinh", std::sinh}, {"cosh", std::cosh}, {"tanh", std::tanh}, {"asin", std::asin},
+        {"acos", std::acos}, {"atan", std::atan}, {"floor", std::floor}, {"ceil", std::ceil}};
+    static const std::map<std::string, double (*)(double, double)> binary_functions = {
+        {"pow", std::pow}, {"atan2", std::atan2}, {"fmod", std::fmod}};
+    // clang-format on
+
+    auto unary = unary_functions.find(name);
+    if (unary != unary_functions.end() && arguments.size() == 1) {
+        return unary->second(arguments[0]);
+    }
+    auto binary = binary_functions.find(name);
+    if (binary != binary_functions.end() && arguments.size() == 2) {
+        return binary->second(arguments[0], arguments[1]);
+    }
+
+    auto function = functions.find(name);
+    if (function == functions.end()) {
+        throw std::runtime_error("call to {} not supported"_format(name));
+    }
+    auto block = function->second;
+    auto parameters = block->get_parameters();
+    if (parameters.size() != arguments.size() || depth >= MAX_CALL_DEPTH) {
+        throw std::runtime_error("call to {} not supported"_format(name));
+    }
+    Scope function_scope;
+    for (size_t i = 0; i < parameters.size(); i++) {
+        function_scope[parameters[i]->get_node_name()] = arguments[i];
+    }
+    depth++;
+    auto statement_block = block->get_statement_block().get();
+    execute(statement_block, function_scope, statement_block->get_symbol_table(), name);
+    depth--;
+    auto result = function_scope.find(name);
+    if (result == function_scope.end()) {
+        throw std::runtime_error("function {} does not return value"_format(name));
+    }
+    return result->second;
+}
+
+
+double TableEvaluator::evaluate(ast::Expression* node, Scope& scope, SymbolTable* symtab) {
+    if (node->is_integer()) {
+        return dynamic_cast<ast::Integer*>(node)->eval();
+    }
+    if (node->is_double()) {
+        return dynamic_cast<ast::Double*>(node)->eval();
+    }
+    if (node->is_float()) {
+        return dynamic_cast<ast::Float*>(node)->eval();
+    }
+    if (node->is_name()) {
+        return value_of(node->get_node_name(), scope, symtab);
+    }
+    if (node->is_var_name()) {
+        auto var_name = dynamic_cast<ast::VarName*>(node);
+        if (!var_name->get_name()->is_name() || var_name->get_at() || var_name->get_index()) {
+            throw std::runtime_error("indexed variable {} not supported"_format(to_nmodl(node)));
+        }
+        return value_of(var_name->get_node_name(), scope, symtab);
+    }
+    if (node->is_paren_expression()) {
+        auto expression = dynamic_cast<ast::ParenExpression*>(node)->get_expression();
+        return evaluate(expression.get(), scope, symtab);
+    }
+    if (node->is_wrapped_expression()) {
+        auto expression = dynamic_cast<ast::WrappedExpression*>(node)->get_expression();
+        return evaluate(expression.get(), scope, symtab);
+    }
+    if (node->is_unary_expression()) {
+        auto expression = dynamic_cast<ast::UnaryExpression*>(node);
+        auto value = evaluate(expression->get_expression().get(), scope, symtab);
+        if (expression->get_op().get_value() == ast::UOP_NEGATION) {
+            return -value;
+        }
+        return value == 0. ? 1. : 0.;
+    }
+    if (node->is_function_call()) {
+        return call(dynamic_cast<ast::FunctionCall*>(node), scope, symtab);
+    }
+    if (!node->is_binary_expression()) {
+        throw std::runtime_error("expression {} not supported"_format(to_nmodl(node)));
+    }
+
+    auto expression = dynamic_cast<ast::BinaryExpression*>(node);
+    auto op = expression->get_op().get_value();
+    auto lhs = evaluate(expression->get_lhs().get(), scope, symtab);
+    if (op == ast::BOP_AND && lhs == 0.) {
+        return 0.;
+    }
+    if (op == ast::BOP_OR && lhs != 0.) {
+        return 1.;
+    }
+    auto rhs = evaluate(expression->get_rhs().get(), scope, symtab);
+    switch (op) {
+    case ast::BOP_ADDITION:
+        return lhs + rhs;
+    case ast::BOP_SUBTRACTION:
+        return lhs - rhs;
+    case ast::BOP_MULTIPLICATION:
+        return lhs * rhs;
+    case ast::BOP_DIVISION:
+        return lhs / rhs;
+    case ast::BOP_POWER:
+        return std::pow(lhs, rhs);
+    case ast::BOP_AND:
+    case ast::BOP_OR:
+        return rhs != 0. ? 1. : 0.;
+    case ast::BOP_GREATER:
+        return lhs > rhs ? 1. : 0.;
+    case ast::BOP_LESS:
+        return lhs < rhs ? 1. : 0.;
+    case ast::BOP_GREATER_EQUAL:
+        return lhs >= rhs ? 1. : 0.;
+    case ast::BOP_LESS_EQUAL:
+        return lhs <= rhs ? 1. : 0.;
+    case ast::BOP_NOT_EQUAL:
+        return lhs != rhs ? 1. : 0.;
+    case ast::BOP_EXACT_EQUAL:
+        return lhs == rhs ? 1. : 0.;
+    default:
+        throw std::runtime_error("expression {} not supported"_format(to_nmodl(node)));
+    }
+}
+
+
+void TableEvaluator::execute(ast::StatementBlock* node,
+                             Scope& scope,
+                             SymbolTable* symtab,
+                             const std::string& function_name) {
+    if (node->get_symbol_table() != nullptr) {
+        symtab = node->get_symbol_table();
+    }
+    for (const auto& statement: node->get_statements()) {
+        if (statement->is_local_list_statement() || statement->is_table_statement()) {
+            continue;
+        }
+        if (statement->is_if_statement()) {
+            auto if_statement = std::dynamic_pointer_cast<ast::IfStatement>(statement);
+            if (evaluate(if_statement->get_condition().get(), scope, symtab) != 0.) {
+                execute(if_statement->get_statement_block().get(), scope, symtab, function_name);
+                continue;
+            }
+            bool done = false;
+            for (const auto& else_if: if_statement->get_elseifs()) {
+                if (evaluate(else_if->get_condition().get(), scope, symtab) != 0.) {
+                    execute(else_if->get_statement_block().get(), scope, symtab, function_name);
+                    done = true;
+                    break;
+                }
+            }
+            auto else_statement = if_statement->get_elses();
+            if (!done && else_statement) {
+                execute(else_statement->get_statement_block().get(), scope, symtab, function_name);
+            }
+            continue;
+        }
+        if (statement->is_expression_statement()) {
+            auto expression =
+                std::dynamic_pointer_cast<ast::ExpressionStatement>(statement)->get_expression();
+            if (expression->is_binary_expression()) {
+                auto assignment = std::dynamic_pointer_cast<ast::BinaryExpression>(expression);
+                auto lhs = assignment->get_lhs();
+                if (assignment->get_op().get_value() == ast::BOP_ASSIGN && lhs->is_var_name() &&
+                    std::dynamic_pointer_cast<ast::VarName>(lhs)->get_name()->is_name()) {
+                    auto value = evaluate(assignment->get_rhs().get(), scope, symtab);
+                    assign(lhs->get_node_name(), value, scope, symtab, function_name);
+                    continue;
+                }
+            }
+        }
+        throw std::runtime_error("statement {} not supported"_format(to_nmodl(statement.get())));
+    }
+}
+
+
+void TableEvaluator::run(ast::ProcedureBlock* node, double argument) {
+    Scope scope;
+    scope[node->get_parameters()[0]->get_node_name()] = argument;
+    outputs.clear();
+    auto statement_block = node->get_statement_block().get();
+    execute(statement_block, scope, statement_block->get_symbol_table(), "");
+}
+
+
+/**
+ * Basic arithmetic operations and comparisons count as one, see DIVISION_COST and
+ * TRANSCENDENTAL_COST for other operations. Calls to FUNCTIONs add the cost of
+ * the called function.
+ */
+double AutoTableVisitor::block_cost(ast::Block* node) {
+    PerfVisitor v;
+    node->accept(v);
+    auto perf = v.get_total_perfstat();
+    double cost = perf.n_add + perf.n_sub + perf.n_mul + perf.n_neg + perf.n_not + perf.n_and +
+                  perf.n_or + perf.n_gt + perf.n_lt + perf.n_ge + perf.n_le + perf.n_ne +
+                  perf.n_ee + perf.n_if + perf.n_elif;
+    cost += DIVISION_COST * perf.n_div;
+    cost += TRANSCENDENTAL_COST * (perf.n_exp + perf.n_log + perf.n_pow);
+
+    for (const auto& call: AstLookupVisitor().lookup(node, ast::AstNodeType::FUNCTION_CALL)) {
+        auto name = std::dynamic_pointer_cast<ast::FunctionCall>(call)->get_node_name();
+        if (functions.find(name) != functions.end()) {
+            cost += function_cost(name);
+        }
+    }
+    return cost;
+}
+
+
+double AutoTableVisitor::function_cost(const std::string& name) {
+    auto it = function_costs.find(name);
+    if (it != function_costs.end()) {
+        return it->second;
+    }
+    // recursive functions are not evaluated anyway, so any cost will do
+    function_costs[name] = 0.;
+    auto cost = block_cost(functions[name]);
+    function_costs[name] = cost;
+    return cost;
+}
+
+
+bool AutoTableVisitor::tabulate(ast::ProcedureBlock* node) {
+    auto name = node->get_node_name();
+    auto parameters = node->get_parameters();
+    if (parameters.size() != 1 || parameters[0]->get_node_name() != "v") {
+        return false;
+    }
+
+    auto symbol = program_symtab->lookup(name);
+    if (symbol != nullptr && symbol->has_any_property(NmodlType::to_solve)) {
+        return false;
+    }
+
+    std::vector<ast::AstNodeType> excluded_types = {ast::AstNodeType::TABLE_STATEMENT,
+                                                          ast::AstNodeType::VERBATIM};
+    if (!AstLookupVisitor().lookup(node, excluded_types).empty()) {
+        return false;
+    }
+
+    if (!VarUsageVisitor().variable_used(node->get_statement_block().get(), "v")) {
+        return false;
+    }
+
+    auto cost = block_cost(node);
+    if (cost <= cost_threshold) {
+        logger->debug("AutoTableVisitor : cost {} of {} below threshold", cost, name);
+        return false;
+    }
+
+    // sample procedure on fine grid
+    TableEvaluator evaluator(functions);
+    std::vector<std::string> table_variables;
+    std::vector<std::vector<double>> samples;
+    const double step = (table_to - table_from) / NUM_SAMPLES;
+    try {
+        for (int i = 0; i <= NUM_SAMPLES; i++) {
+            evaluator.run(node, table_from + i * step);
+            if (i == 0) {
+                for (const auto& output: evaluator.outputs) {
+                    table_variables.push_back(output.first);
+                }
+                samples.resize(table_variables.size());
+            }
+            if (evaluator.outputs.size() != table_variables.size()) {
+                throw std::runtime_error("variables are defined conditionally");
+            }
+            for (size_t j = 0; j < table_variables.size(); j++) {
+                const auto& output = evaluator.outputs[j];
+                if (output.first != table_variables[j]) {
+                    throw std::runtime_error("variables are defined conditionally");
+                }
+                if (!std::isfinite(output.second)) {
+                    throw std::runtime_error("{} is not finite"_format(output.first));
+                }
+                samples[j].push_back(output.second);
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        logger->debug("AutoTableVisitor : {} can not be tabulated, {}", name, e.what());
+        return false;
+    }
+    if (table_variables.empty()) {
+        return false;
+    }
+
+    // all table variables must be defined before their use
+    auto chains = DefUseAnalyzeVisitor(program_symtab).analyze_all(node);
+    for (const auto& variable: table_variables) {
+        auto result = chains.eval(variable);
+        if (result != DUState::D) {
+            logger->debug("AutoTableVisitor : {} can not be tabulated, {} is used before "
+                          "definition",
+                          name,
+                          variable);
+            return false;
+        }
+    }
+
+    // linear interpolation error is bounded by h^2/8 max|f''| with interval width h
+    double intervals = MIN_TABLE_INTERVALS;
+    for (const auto& values: samples) {
+        double max_value = 0.;
+        double max_second_derivative = 0.;
+        for (size_t i = 0; i < values.size(); i++) {
+            max_value = std::max(max_value, std::fabs(values[i]));
+            if (i > 0 && i + 1 < values.size()) {
+                auto second_derivative = (values[i - 1] - 2. * values[i] + values[i + 1]) /
+                                         (step * step);
+                max_second_derivative = std::max(max_second_derivative,
+                                                 std::fabs(second_derivative));
+            }
+        }
+        if (max_value > 0.) {
+            auto width = std::sqrt(8. * error_bound * max_value / max_second_derivative);
+            intervals = std::max(intervals, std::ceil((table_to - table_from) / width));
+        }
+    }
+    if (intervals > MAX_TABLE_INTERVALS) {
+        logger->debug("AutoTableVisitor : {} needs more than {} table intervals",
+                      name,
+                      MAX_TABLE_INTERVALS);
+        return false;
+    }
+
+    auto statement = "TABLE {}"_format(fmt::join(table_variables, ", "));
+    if (!evaluator.depend_variables.empty()) {
+        statement += " DEPEND {}"_format(fmt::join(evaluator.depend_variables, ", "));
+    }
+    statement += " FROM {:g} TO {:g} WITH {}"_format(table_from,
+                                                      table_to,
+                                                      static_cast<int>(intervals));
+
+    // insert table statement after local variable declarations
+    auto statement_block = node->get_statement_block();
+    auto statements = statement_block->get_statements();
+    auto insertion_point = statements.begin();
+    while (insertion_point != statements.end() && (*insertion_point)->is_local_list_statement()) {
+        ++insertion_point;
+    }
+    statements.insert(insertion_point, create_statement(statement));
+    statement_block->set_statements(std::move(statements));
+
+    // update symbols as SymtabVisitor does for TABLE statements
+    auto num_values = static_cast<int>(intervals) + 1;
+    auto update_symbols = [&](const std::vector<std::string>& names, NmodlType property) {
+        for (const auto& variable: names) {
+            if (auto symbol = program_symtab->lookup(variable)) {
+                symbol->add_property(property);
+                symbol->set_num_values(num_values);
+            }
+        }
+    };
+    update_symbols(table_variables, NmodlType::table_statement_var);
+    update_symbols({evaluator.depend_variables.begin(), evaluator.depend_variables.end()},
+                   NmodlType::table_assigned_var);
+
+    logger->info("AutoTableVisitor : added {} to {} with estimated cost {}", statement, name, cost);
+    return true;
+}
+
+
+void AutoTableVisitor::visit_program(ast::Program* node) {
+    program_symtab = node->get_symbol_table();
+    if (program_symtab == nullptr) {
+        logger->warn("AutoTableVisitor :: symbol table is not setup, returning");
+        return;
+    }
+
+    functions.clear();
+    function_costs.clear();
+    for (const auto& block: node->get_blocks()) {
+        if (block->is_function_block()) {
+            functions[block->get_node_name()] = dynamic_cast<ast::FunctionBlock*>(block.get());
+        }
+    }
+
+    for (const auto& block: node->get_blocks()) {
+        if (block->is_procedure_block()) {
+            tabulate(dynamic_cast<ast::ProcedureBlock*>(block.get()));
+        }
+    }
+}
+
+}  // namespace visitor
+}  // namespace nmodl
@@ -0,0 +1,132 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::visitor::AutoTableVisitor
+ */
+
+#include <map>
+#include <string>
+
+#include "ast/ast.hpp"
+#include "symtab/symbol_table.hpp"
+#include "visitors/ast_visitor.hpp"
+
+namespace nmodl {
+namespace visitor {
+
+/**
+ * @addtogroup visitor_classes
+ * @{
+ */
+
+/**
+ * \class AutoTableVisitor
+ * \brief %Visitor to add TABLE statements to expensive rate procedures
+ *
+ * Rate procedures of voltage gated channels typically compute steady state
+ * values and time constants with several `exp` calls per instance and time step:
+ *
+ * \code{.mod}
+ *      PROCEDURE rates(v) {
+ *          LOCAL alpha, beta
+ *          alpha = 0.1*exp(-(v+40)/10)
+ *          beta = 4*exp(-(v+65)/18)
+ *          mtau = 1/(alpha+beta)
+ *          minf = alpha*mtau
+ *      }
+ * \endcode
+ *
+ * If the procedure only depends on voltage, this visitor adds a TABLE statement
+ * so that code generation replaces the computation by linear interpolation in
+ * a lookup table:
+ *
+ * \code{.mod}
+ *      PROCEDURE rates(v) {
+ *          LOCAL alpha, beta
+ *          TABLE mtau, minf FROM -100 TO 100 WITH 400
+ *          ...
+ *      }
+ * \endcode
+ *
+ * A procedure is tabulated if
+ *   - it has a single argument `v` (as expected by TABLE code generation),
+ *     which is used, and no TABLE or VERBATIM block,
+ *   - besides its argument and local variables, it only reads global PARAMETER
+ *     and CONSTANT variables (the former become DEPEND variables),
+ *   - it only calls math functions and FUNCTIONs satisfying the same conditions,
+ *   - it unconditionally defines ASSIGNED variables before using them (see
+ *     DefUseAnalyzeVisitor), these become table variables,
+ *   - its estimated cost from PerfVisitor counts exceeds the given threshold.
+ *
+ * The number of table intervals is chosen such that the error of linear
+ * interpolation, relative to the largest magnitude of each table variable in
+ * the table range, stays below the given error bound. For this the procedure is
+ * evaluated at translation time on a fine grid, with PARAMETERs at their
+ * declared values, and the second derivative is estimated by finite differences.
+ * Procedures that can not be evaluated or produce non-finite values are skipped.
+ *
+ * The table range defaults to -100 to 100 mV and can be changed with the
+ * `--auto-table-from` and `--auto-table-to` options. Note that generated TABLE
+ * code clamps arguments outside of the range to its bounds, so the range has to
+ * cover all voltages reached in simulation or results are silently inaccurate.
+ */
+class AutoTableVisitor: public AstVisitor {
+  private:
+    /// minimum estimated cost of procedure (in basic arithmetic operations) for tabulation
+    double cost_threshold = 50.;
+
+    /// maximum relative interpolation error
+    double error_bound = 1e-4;
+
+    /// lower bound of table range
+    double table_from = -100.;
+
+    /// upper bound of table range
+    double table_to = 100.;
+
+    /// global symbol table
+    symtab::SymbolTable* program_symtab = nullptr;
+
+    /// functions by name
+    std::map<std::string, ast::FunctionBlock*> functions;
+
+    /// estimated cost of functions by name
+    std::map<std::string, double> function_costs;
+
+    /// estimated cost of block including cost of called functions
+    double block_cost(ast::Block* node);
+
+    /// estimated cost of function including cost of called functions
+    double function_cost(const std::string& name);
+
+    /// add table statement to procedure if eligible, return true if added
+    bool tabulate(ast::ProcedureBlock* node);
+
+  public:
+    AutoTableVisitor() = default;
+
+    AutoTableVisitor(double cost_threshold, double error_bound)
+        : cost_threshold(cost_threshold)
+        , error_bound(error_bound) {}
+
+    AutoTableVisitor(double cost_threshold, double error_bound, double from, double to)
+        : cost_threshold(cost_threshold)
+        , error_bound(error_bound)
+        , table_from(from)
+        , table_to(to) {}
+
+    void visit_program(ast::Program* node) override;
+};
+
+/** @} */  // end of visitor_classes
+
+}  // namespace visitor
+}  // namespace nmodl
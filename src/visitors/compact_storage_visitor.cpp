@@ -0,0 +1,245 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <algorithm>
+#include <map>
+
+#include "parser/c11_driver.hpp"
+#include "utils/logger.hpp"
+#include "visitors/compact_storage_visitor.hpp"
+#include "visitors/defuse_analyze_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/perf_visitor.hpp"
+#include "visitors/var_usage_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+
+namespace nmodl {
+namespace visitor {
+
+using symtab::syminfo::NmodlType;
+
+/// prefix of range variables in verbatim blocks, see VerbatimVarRenameVisitor
+static const std::string RANGE_PREFIX = "_p_";
+
+bool CompactStorageVisitor::node_for_def_use_analysis(ast::Node* node) {
+    /// same global blocks as analysed by LocalizeVisitor
+    // clang-format off
+    const std::vector<ast::AstNodeType> blocks_to_analyze = {
+            ast::AstNodeType::INITIAL_BLOCK,
+            ast::AstNodeType::BREAKPOINT_BLOCK,
+            ast::AstNodeType::CONSTRUCTOR_BLOCK,
+            ast::AstNodeType::DESTRUCTOR_BLOCK,
+            ast::AstNodeType::DERIVATIVE_BLOCK,
+            ast::AstNodeType::LINEAR_BLOCK,
+            ast::AstNodeType::NON_LINEAR_BLOCK,
+            ast::AstNodeType::DISCRETE_BLOCK,
+            ast::AstNodeType::PARTIAL_BLOCK,
+            ast::AstNodeType::NET_RECEIVE_BLOCK,
+            ast::AstNodeType::TERMINAL_BLOCK,
+            ast::AstNodeType::BA_BLOCK,
+            ast::AstNodeType::FOR_NETCON,
+            ast::AstNodeType::BEFORE_BLOCK,
+            ast::AstNodeType::AFTER_BLOCK,
+    };
+    // clang-format on
+    auto type = node->get_node_type();
+    if (std::find(blocks_to_analyze.begin(), blocks_to_analyze.end(), type) !=
+        blocks_to_analyze.end()) {
+        return true;
+    }
+    if (node->is_procedure_block()) {
+        auto symbol = program_symtab->lookup(node->get_node_name());
+        return symbol && symbol->has_any_property(NmodlType::to_solve);
+    }
+    return false;
+}
+
+
+std::vector<std::string> CompactStorageVisitor::variables_to_compact(ast::Program* node) {
+    // clang-format off
+    const NmodlType excluded_var_properties = NmodlType::extern_var
+                                     | NmodlType::extern_neuron_variable
+                                     | NmodlType::read_ion_var
+                                     | NmodlType::write_ion_var
+                                     | NmodlType::prime_name
+                                     | NmodlType::nonspecific_cur_var
+                                     | NmodlType::pointer_var
+                                     | NmodlType::bbcore_pointer_var
+                                     | NmodlType::electrode_cur_var
+                                     | NmodlType::section_var
+                                     | NmodlType::global_var
+                                     | NmodlType::param_assign
+                                     | NmodlType::state_var
+                                     | NmodlType::table_statement_var
+                                     | NmodlType::table_assigned_var;
+    // clang-format on
+
+    /// names used in conductance hints are read by code generation
+    std::set<std::string> excluded_names;
+    for (const auto& hint: AstLookupVisitor().lookup(node, ast::AstNodeType::CONDUCTANCE_HINT)) {
+        auto conductance = std::static_pointer_cast<ast::ConductanceHint>(hint)->get_conductance();
+        excluded_names.insert(conductance->get_node_name());
+    }
+
+    /// identifiers in verbatim blocks, with or without range prefix
+    for (const auto& verbatim: AstLookupVisitor().lookup(node, ast::AstNodeType::VERBATIM)) {
+        auto text = std::static_pointer_cast<ast::Verbatim>(verbatim)->get_statement()->eval();
+        parser::CDriver driver;
+        driver.scan_string(text);
+        for (auto& token: driver.all_tokens()) {
+            if (token.find(RANGE_PREFIX) == 0) {
+                token.erase(0, RANGE_PREFIX.size());
+            }
+            excluded_names.insert(token);
+        }
+    }
+
+    std::vector<std::string> result;
+    for (auto& variable:
+         program_symtab->get_variables_with_properties(NmodlType::assigned_definition)) {
+        auto name = variable->get_name();
+        if (!variable->has_any_property(excluded_var_properties) &&
+            excluded_names.find(name) == excluded_names.end()) {
+            result.push_back(name);
+        }
+    }
+    return result;
+}
+
+
+void CompactStorageVisitor::add_local(ast::Block* block, const std::string& name) {
+    auto statement_block = block->get_statement_block();
+    auto symbol = program_symtab->lookup(name);
+
+    /// also inserts new symbol in the symbol table of the block
+    if (symbol->is_array()) {
+        add_local_variable(statement_block.get(), name, symbol->get_length());
+    } else {
+        add_local_variable(statement_block.get(), name);
+    }
+}
+
+
+void CompactStorageVisitor::remove_declarations(ast::Program* node) {
+    auto compacted = [this](const std::shared_ptr<ast::Ast>& variable) {
+        return compacted_variables.find(variable->get_node_name()) != compacted_variables.end();
+    };
+
+    for (const auto& block: node->get_blocks()) {
+        if (block->is_neuron_block()) {
+            auto statement_block = std::static_pointer_cast<ast::NeuronBlock>(block)
+                                       ->get_statement_block();
+            std::set<ast::Node*> empty_statements;
+            for (const auto& statement: statement_block->get_statements()) {
+                if (statement->is_range()) {
+                    auto range = std::static_pointer_cast<ast::Range>(statement);
+                    auto variables = range->get_variables();
+                    variables.erase(std::remove_if(variables.begin(), variables.end(), compacted),
+                                    variables.end());
+                    if (variables.empty()) {
+                        empty_statements.insert(statement.get());
+                    }
+                    range->set_variables(std::move(variables));
+                }
+            }
+            remove_statements_from_block(statement_block.get(), empty_statements);
+        } else if (block->is_assigned_block()) {
+            auto assigned = std::static_pointer_cast<ast::AssignedBlock>(block);
+            auto definitions = assigned->get_definitions();
+            definitions.erase(std::remove_if(definitions.begin(), definitions.end(), compacted),
+                              definitions.end());
+            assigned->set_definitions(std::move(definitions));
+        }
+    }
+
+    for (const auto& name: compacted_variables) {
+        program_symtab->remove(name);
+    }
+}
+
+
+void CompactStorageVisitor::visit_program(ast::Program* node) {
+    /// symtab visitor pass need to be run before
+    program_symtab = node->get_symbol_table();
+    if (program_symtab == nullptr) {
+        logger->warn("CompactStorageVisitor :: symbol table is not setup, returning");
+        return;
+    }
+    compacted_variables.clear();
+
+    /// update read counts of symbols and count instance variables
+    PerfVisitor perf;
+    perf.visit_program(node);
+    auto num_instance_variables = perf.get_instance_variable_count();
+
+    /// compute def use chains of all variables, once per global block
+    /// (verbatim blocks are already checked for variable names)
+    std::map<ast::Node*, DUChains> block_chains;
+    for (const auto& block: node->get_blocks()) {
+        if (node_for_def_use_analysis(block.get())) {
+            DefUseAnalyzeVisitor v(program_symtab, true);
+            block_chains[block.get()] = v.analyze_all(block.get());
+        }
+    }
+
+    for (const auto& varname: variables_to_compact(node)) {
+        auto symbol = program_symtab->lookup(varname);
+        bool read = symbol->get_read_count() > 0;
+        bool used = false;
+        std::vector<ast::Block*> defining_blocks;
+
+        for (const auto& block: node->get_blocks()) {
+            auto block_ptr = dynamic_cast<ast::Block*>(block.get());
+            if (block_ptr == nullptr) {
+                continue;
+            }
+            auto chains = block_chains.find(block.get());
+            if (chains != block_chains.end()) {
+                auto result = chains->second.eval(varname);
+                if (result == DUState::D || result == DUState::CD) {
+                    defining_blocks.push_back(block_ptr);
+                } else if (result != DUState::NONE) {
+                    used = true;
+                }
+            } else if (block->is_procedure_block() || block->is_function_block()) {
+                /// value written in procedures can only be dropped if never read
+                if (VarUsageVisitor().variable_used(block.get(), varname)) {
+                    if (read) {
+                        used = true;
+                    } else {
+                        defining_blocks.push_back(block_ptr);
+                    }
+                }
+            }
+            if (used) {
+                break;
+            }
+        }
+
+        if (used) {
+            continue;
+        }
+
+        logger->debug("CompactStorageVisitor : demoted variable {} to LOCAL", varname);
+        for (auto block: defining_blocks) {
+            add_local(block, varname);
+        }
+        symbol->mark_localized();
+        compacted_variables.insert(varname);
+    }
+
+    if (!compacted_variables.empty()) {
+        remove_declarations(node);
+        logger->info("CompactStorageVisitor : removed storage of {} out of {} instance variables",
+                     compacted_variables.size(),
+                     num_instance_variables);
+    }
+}
+
+}  // namespace visitor
+}  // namespace nmodl
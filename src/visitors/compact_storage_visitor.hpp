@@ -0,0 +1,118 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::visitor::CompactStorageVisitor
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast/ast.hpp"
+#include "symtab/symbol_table.hpp"
+#include "visitors/ast_visitor.hpp"
+
+namespace nmodl {
+namespace visitor {
+
+/**
+ * @addtogroup visitor_classes
+ * @{
+ */
+
+/**
+ * \class CompactStorageVisitor
+ * \brief %Visitor to demote ASSIGNED variables without carried values to LOCAL
+ *
+ * Code generation allocates a column in the instance data for every RANGE and
+ * ASSIGNED variable. Many of these only hold temporaries within a single block
+ * or are never read after being written:
+ *
+ * \code{.mod}
+ *      NEURON {
+ *          RANGE gbar, g, unused
+ *      }
+ *
+ *      ASSIGNED {
+ *          g (S/cm2)
+ *          unused
+ *      }
+ *
+ *      BREAKPOINT {
+ *          SOLVE states METHOD cnexp
+ *          g = gbar*m*m*m*h
+ *          ina = g*(v-ena)
+ *      }
+ * \endcode
+ *
+ * This visitor turns such variables into LOCAL variables of the blocks that
+ * define them and removes their declarations from the ASSIGNED block, the RANGE
+ * statement and the global symbol table, so that no storage is allocated:
+ *
+ * \code{.mod}
+ *      BREAKPOINT {
+ *          LOCAL g
+ *          SOLVE states METHOD cnexp
+ *          g = gbar*m*m*m*h
+ *          ina = g*(v-ena)
+ *      }
+ * \endcode
+ *
+ * An ASSIGNED variable is compacted if
+ *   - it is not GLOBAL, STATE, PARAMETER, ion, current, POINTER, TABLE or
+ *     external variable and it's not used as CONDUCTANCE hint,
+ *   - it is not mentioned in any VERBATIM block,
+ *   - no global block uses its value before defining it (see DefUseAnalyzeVisitor),
+ *     i.e. its value is never carried from one block or time step to the next,
+ *   - it does not appear in PROCEDUREs or FUNCTIONs (other than the ones used
+ *     in SOLVE statements), unless it is never read at all according to the
+ *     read counts of PerfVisitor.
+ *
+ * As procedures are not analysed, the pass is most effective after inlining.
+ *
+ * \note Compacted RANGE variables can not be accessed (e.g. recorded) from the
+ * simulator anymore.
+ */
+class CompactStorageVisitor: public AstVisitor {
+  private:
+    /// global symbol table
+    symtab::SymbolTable* program_symtab = nullptr;
+
+    /// names of variables compacted in the last visit
+    std::set<std::string> compacted_variables;
+
+    /// ASSIGNED variables that are candidates for compaction
+    std::vector<std::string> variables_to_compact(ast::Program* node);
+
+    /// check if global block is analysed with DefUseAnalyzeVisitor
+    bool node_for_def_use_analysis(ast::Node* node);
+
+    /// add local variable to given block and its symbol table
+    void add_local(ast::Block* block, const std::string& name);
+
+    /// remove declarations of compacted variables from NEURON and ASSIGNED blocks
+    void remove_declarations(ast::Program* node);
+
+  public:
+    CompactStorageVisitor() = default;
+
+    /// names of the variables demoted to LOCAL
+    const std::set<std::string>& get_compacted_variables() const {
+        return compacted_variables;
+    }
+
+    void visit_program(ast::Program* node) override;
+};
+
+/** @} */  // end of visitor_classes
+
+}  // namespace visitor
+}  // namespace nmodl
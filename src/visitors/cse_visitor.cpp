@@ -0,0 +1,276 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "utils/logger.hpp"
+#include "visitors/cse_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+
+namespace nmodl {
+namespace visitor {
+
+using namespace fmt::literals;
+using symtab::syminfo::NmodlType;
+
+/// math functions without side effects
+static const std::set<std::string> PURE_FUNCTIONS = {
+    "exp",  "expm1", "log",  "log10", "pow",  "sqrt", "fabs", "sin",  "cos",  "tan", "asin",
+    "acos", "atan",  "atan2", "sinh", "cosh", "tanh", "floor", "ceil", "fmod", "fmin", "fmax"};
+
+namespace {
+
+/// occurrences of a subexpression without assignment to its variables in between
+struct Occurrences {
+    /// nmodl text of the subexpression
+    std::string text;
+
+    /// first occurrence of the subexpression
+    std::shared_ptr<ast::Expression> expression;
+
+    /// variables read by the subexpression
+    std::set<std::string> variables;
+
+    /// index of first and last statement with the subexpression
+    std::size_t first = 0;
+    std::size_t last = 0;
+
+    /// number of occurrences
+    int count = 0;
+};
+
+/// rhs of assignment statement
+std::shared_ptr<ast::BinaryExpression> get_assignment(const std::shared_ptr<ast::Statement>& node) {
+    auto expression = std::static_pointer_cast<ast::ExpressionStatement>(node)->get_expression();
+    return std::static_pointer_cast<ast::BinaryExpression>(expression);
+}
+
+/// add binary expressions and function calls in the given expression
+void find_subexpressions(const std::shared_ptr<ast::Expression>& node,
+                         std::vector<std::shared_ptr<ast::Expression>>& subexpressions) {
+    if (node->is_binary_expression() || node->is_function_call()) {
+        subexpressions.push_back(node);
+    }
+    std::vector<ast::AstNodeType> types = {ast::AstNodeType::BINARY_EXPRESSION,
+                                           ast::AstNodeType::FUNCTION_CALL};
+    for (const auto& child: AstLookupVisitor().lookup(node.get(), types)) {
+        subexpressions.push_back(std::static_pointer_cast<ast::Expression>(child));
+    }
+}
+
+/// variables read by the given expression
+std::set<std::string> get_variables(const std::shared_ptr<ast::Expression>& node) {
+    std::set<std::string> variables;
+    if (node->is_name() || node->is_var_name()) {
+        variables.insert(node->get_node_name());
+    }
+    std::vector<ast::AstNodeType> types = {ast::AstNodeType::NAME, ast::AstNodeType::VAR_NAME};
+    for (const auto& name: AstLookupVisitor().lookup(node.get(), types)) {
+        variables.insert(name->get_node_name());
+    }
+    return variables;
+}
+
+/// replace subexpressions with given nmodl text by variable
+std::shared_ptr<ast::Expression> replace(const std::shared_ptr<ast::Expression>& node,
+                                         const std::string& text,
+                                         const std::string& name) {
+    bool is_candidate = node->is_binary_expression() || node->is_function_call();
+    if (is_candidate && to_nmodl(node.get()) == text) {
+        return create_var_name(name);
+    }
+    if (node->is_binary_expression()) {
+        auto expression = std::static_pointer_cast<ast::BinaryExpression>(node);
+        expression->set_lhs(replace(expression->get_lhs(), text, name));
+        expression->set_rhs(replace(expression->get_rhs(), text, name));
+    } else if (node->is_wrapped_expression()) {
+        auto expression = std::static_pointer_cast<ast::WrappedExpression>(node);
+        expression->set_expression(replace(expression->get_expression(), text, name));
+    } else if (node->is_paren_expression()) {
+        auto expression = std::static_pointer_cast<ast::ParenExpression>(node);
+        expression->set_expression(replace(expression->get_expression(), text, name));
+    } else if (node->is_unary_expression()) {
+        auto expression = std::static_pointer_cast<ast::UnaryExpression>(node);
+        expression->set_expression(replace(expression->get_expression(), text, name));
+    } else if (node->is_function_call()) {
+        auto call = std::static_pointer_cast<ast::FunctionCall>(node);
+        auto arguments = call->get_arguments();
+        for (auto& argument: arguments) {
+            argument = replace(argument, text, name);
+        }
+        call->set_arguments(std::move(arguments));
+    }
+    return node;
+}
+
+}  // namespace
+
+
+bool CseVisitor::is_pure(const std::shared_ptr<ast::Expression>& node) const {
+    std::vector<ast::AstNodeType> impure_types = {ast::AstNodeType::INDEXED_NAME,
+                                                  ast::AstNodeType::PRIME_NAME};
+    if (!AstLookupVisitor().lookup(node.get(), impure_types).empty()) {
+        return false;
+    }
+    std::vector<std::shared_ptr<ast::Ast>> calls;
+    if (node->is_function_call()) {
+        calls.push_back(node);
+    }
+    auto nested_calls = AstLookupVisitor().lookup(node.get(), ast::AstNodeType::FUNCTION_CALL);
+    calls.insert(calls.end(), nested_calls.begin(), nested_calls.end());
+    for (const auto& call: calls) {
+        auto name = call->get_node_name();
+        auto symbol = program_symtab->lookup(name);
+        if (PURE_FUNCTIONS.find(name) == PURE_FUNCTIONS.end() ||
+            (symbol != nullptr && !symbol->has_any_property(NmodlType::extern_method))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool CseVisitor::is_candidate_statement(const std::shared_ptr<ast::Statement>& node) const {
+    if (!node->is_expression_statement()) {
+        return false;
+    }
+    auto expression = std::static_pointer_cast<ast::ExpressionStatement>(node)->get_expression();
+    if (!expression->is_binary_expression()) {
+        return false;
+    }
+    auto assignment = std::static_pointer_cast<ast::BinaryExpression>(expression);
+    if (assignment->get_op().get_value() != ast::BOP_ASSIGN) {
+        return false;
+    }
+    auto lhs = assignment->get_lhs();
+    return (lhs->is_name() || lhs->is_var_name()) && is_pure(assignment->get_rhs());
+}
+
+
+std::string CseVisitor::new_temporary_name() {
+    std::string name;
+    do {
+        name = "cse_{}"_format(counter++);
+    } while (used_names.find(name) != used_names.end());
+    used_names.insert(name);
+    return name;
+}
+
+
+bool CseVisitor::eliminate_one(ast::StatementBlock* node) {
+    const auto& statements = node->get_statements();
+    std::map<std::string, Occurrences> open;
+    std::vector<Occurrences> closed;
+
+    auto close_if = [&](const std::function<bool(const Occurrences&)>& predicate) {
+        for (auto it = open.begin(); it != open.end();) {
+            if (predicate(it->second)) {
+                closed.push_back(it->second);
+                it = open.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < statements.size(); i++) {
+        const auto& statement = statements[i];
+        if (statement->is_local_list_statement()) {
+            continue;
+        }
+        if (!is_candidate_statement(statement)) {
+            close_if([](const Occurrences&) { return true; });
+            continue;
+        }
+        auto assignment = get_assignment(statement);
+
+        /// rhs is evaluated before the assignment
+        std::vector<std::shared_ptr<ast::Expression>> subexpressions;
+        find_subexpressions(assignment->get_rhs(), subexpressions);
+        for (const auto& subexpression: subexpressions) {
+            auto text = to_nmodl(subexpression.get());
+            auto& occurrences = open[text];
+            if (occurrences.count == 0) {
+                occurrences.text = text;
+                occurrences.expression = subexpression;
+                occurrences.variables = get_variables(subexpression);
+                occurrences.first = i;
+            }
+            occurrences.last = i;
+            occurrences.count++;
+        }
+
+        auto variable = assignment->get_lhs()->get_node_name();
+        close_if([&variable](const Occurrences& occurrences) {
+            return occurrences.variables.find(variable) != occurrences.variables.end();
+        });
+    }
+    close_if([](const Occurrences&) { return true; });
+
+    /// largest subexpression used more than once
+    const Occurrences* best = nullptr;
+    for (const auto& occurrences: closed) {
+        if (occurrences.count < 2) {
+            continue;
+        }
+        if (best == nullptr || occurrences.text.size() > best->text.size()) {
+            best = &occurrences;
+        }
+    }
+    if (best == nullptr) {
+        return false;
+    }
+
+    auto name = new_temporary_name();
+    auto definition = create_assignment(name,
+                                        std::shared_ptr<ast::Expression>(best->expression->clone()));
+    for (auto i = best->first; i <= best->last; i++) {
+        if (is_candidate_statement(statements[i])) {
+            auto assignment = get_assignment(statements[i]);
+            assignment->set_rhs(replace(assignment->get_rhs(), best->text, name));
+        }
+    }
+    auto new_statements = node->get_statements();
+    new_statements.insert(new_statements.begin() + best->first, definition);
+    node->set_statements(std::move(new_statements));
+    add_local_variable(node, name);
+    logger->debug("CseVisitor : replaced {} occurrences of {} by {}",
+                  best->count,
+                  best->text,
+                  name);
+    return true;
+}
+
+
+void CseVisitor::visit_statement_block(ast::StatementBlock* node) {
+    node->visit_children(*this);
+    while (eliminate_one(node)) {
+    }
+}
+
+
+void CseVisitor::visit_program(ast::Program* node) {
+    program_symtab = node->get_symbol_table();
+    if (program_symtab == nullptr) {
+        logger->warn("CseVisitor :: symbol table is not setup, returning");
+        return;
+    }
+    used_names.clear();
+    for (const auto& name: AstLookupVisitor().lookup(node, ast::AstNodeType::NAME)) {
+        used_names.insert(name->get_node_name());
+    }
+    node->visit_children(*this);
+}
+
+}  // namespace visitor
+}  // namespace nmodl
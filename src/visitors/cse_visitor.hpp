@@ -0,0 +1,105 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::visitor::CseVisitor
+ */
+
+#include <set>
+#include <string>
+
+#include "ast/ast.hpp"
+#include "symtab/symbol_table.hpp"
+#include "visitors/ast_visitor.hpp"
+
+namespace nmodl {
+namespace visitor {
+
+/**
+ * @addtogroup visitor_classes
+ * @{
+ */
+
+/**
+ * \class CseVisitor
+ * \brief %Visitor for common subexpression elimination
+ *
+ * After inlining, blocks often evaluate the same subexpression several times:
+ *
+ * \code{.mod}
+ *      BREAKPOINT {
+ *          minf = 1/(1+exp(-(v-vhalf)/k))
+ *          mtau = tau0*exp(-(v-vhalf)/k)
+ *      }
+ * \endcode
+ *
+ * This visitor evaluates such subexpressions once into LOCAL temporaries:
+ *
+ * \code{.mod}
+ *      BREAKPOINT {
+ *          LOCAL cse_0
+ *          cse_0 = exp(-(v-vhalf)/k)
+ *          minf = 1/(1+cse_0)
+ *          mtau = tau0*cse_0
+ *      }
+ * \endcode
+ *
+ * Implementation Notes:
+ *   - Every statement block is handled separately and only assignments are
+ *     analysed. Any other statement (procedure call, SOLVE, VERBATIM, IF,
+ *     differential equation, ...) is a barrier, as are assignments calling
+ *     anything other than side effect free math functions.
+ *   - Binary expressions and math function calls appearing at least twice
+ *     without an assignment to one of their variables in between are
+ *     replaced. Larger subexpressions are replaced first, one at a time, until
+ *     no common subexpression is left.
+ *   - Subexpressions with array elements or prime variables are not replaced.
+ *   - Newton and linear solver blocks created by SympySolverVisitor are not
+ *     modified, SymPy already eliminates common subexpressions there.
+ */
+class CseVisitor: public AstVisitor {
+  private:
+    /// global symbol table
+    symtab::SymbolTable* program_symtab = nullptr;
+
+    /// names used in the program, to create unique names of temporaries
+    std::set<std::string> used_names;
+
+    /// counter for names of temporaries
+    int counter = 0;
+
+    /// check if statement is an assignment that can be analysed
+    bool is_candidate_statement(const std::shared_ptr<ast::Statement>& node) const;
+
+    /// check if expression has no side effects and no array elements or prime variables
+    bool is_pure(const std::shared_ptr<ast::Expression>& node) const;
+
+    /// eliminate one common subexpression in given block, return false if none left
+    bool eliminate_one(ast::StatementBlock* node);
+
+    /// unique name for new temporary
+    std::string new_temporary_name();
+
+  public:
+    CseVisitor() = default;
+
+    void visit_statement_block(ast::StatementBlock* node) override;
+
+    void visit_eigen_newton_solver_block(ast::EigenNewtonSolverBlock* /*node*/) override {}
+
+    void visit_eigen_linear_solver_block(ast::EigenLinearSolverBlock* /*node*/) override {}
+
+    void visit_program(ast::Program* node) override;
+};
+
+/** @} */  // end of visitor_classes
+
+}  // namespace visitor
+}  // namespace nmodl
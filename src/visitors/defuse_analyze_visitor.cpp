@@ -6,6 +6,8 @@
  *************************************************************************/
 
 #include <algorithm>
+#include <map>
+#include <set>
 #include <utility>
 
 #include "visitors/defuse_analyze_visitor.hpp"
@@ -181,6 +183,235 @@ DUState DUChain::eval() {
     return result;
 }
 
+bool DUInstance::matches(const std::string& name) const {
+    if (variable.empty()) {
+        return true;
+    }
+    if (any_index) {
+        return name == variable || name.compare(0, variable.size() + 1, variable + "[") == 0;
+    }
+    return name == variable;
+}
+
+namespace {
+
+/// check if state represents if-else like sub-block instead of usage
+bool is_block_state(DUState state) {
+    return state == DUState::CONDITIONAL_BLOCK || state == DUState::IF ||
+           state == DUState::ELSEIF || state == DUState::ELSE;
+}
+
+/// effective usages of all variables, used for bottom up evaluation of DUChains
+struct DUStates {
+    /// state of variables without entry
+    DUState default_state = DUState::NONE;
+
+    /// state of variables with usage
+    std::map<std::string, DUState> states;
+
+    /// state of given variable, empty name returns state of variables without entry
+    DUState get(const std::string& name) const {
+        auto it = states.find(name);
+        return it == states.end() ? default_state : it->second;
+    }
+};
+
+/// state of sequence of usages evaluated so far, same rules as DUChain::eval()
+struct SequenceState {
+    DUState result = DUState::NONE;
+    bool done = false;
+
+    void update(DUState state) {
+        if (done) {
+            return;
+        }
+        if (state == DUState::U || state == DUState::D) {
+            result = state;
+            done = true;
+        } else if (state == DUState::CD) {
+            result = state;
+        }
+    }
+};
+
+DUStates evaluate(const DUInstance& instance, const std::set<std::string>& variables);
+
+/** Evaluate sequence of usages for all variables
+ *
+ * Note that NONE doesn't change the state of a sequence and hence only variables
+ * used by a child need to be updated, except for children used by all variables
+ * (e.g. verbatim block).
+ */
+DUStates evaluate_sequence(const std::vector<DUInstance>& chain,
+                           const std::set<std::string>& variables) {
+    SequenceState default_state;
+    std::map<std::string, SequenceState> states;
+    for (const auto& instance: chain) {
+        auto child = evaluate(instance, variables);
+        for (const auto& item: child.states) {
+            /// until first usage, variable has same state as variables without usage
+            auto it = states.emplace(item.first, default_state).first;
+            it->second.update(item.second);
+        }
+        if (child.default_state != DUState::NONE) {
+            for (auto& item: states) {
+                if (child.states.find(item.first) == child.states.end()) {
+                    item.second.update(child.default_state);
+                }
+            }
+        }
+        default_state.update(child.default_state);
+    }
+
+    DUStates result;
+    result.default_state = default_state.result;
+    for (const auto& item: states) {
+        result.states[item.first] = item.second.result;
+    }
+    return result;
+}
+
+/// evaluate conditional block for given variable, same rules as conditional_block_eval()
+DUState evaluate_conditional(const DUInstance& instance,
+                             const std::vector<DUStates>& children,
+                             const std::string& name) {
+    DUState result = DUState::NONE;
+    bool block_with_none = false;
+
+    for (size_t i = 0; i < children.size(); i++) {
+        auto child_state = children[i].get(name);
+        if (child_state == DUState::U) {
+            result = child_state;
+            break;
+        }
+        if (child_state == DUState::NONE) {
+            block_with_none = true;
+        }
+        if (child_state == DUState::D || child_state == DUState::CD) {
+            result = DUState::CD;
+            if (instance.children[i].state == DUState::ELSE && !block_with_none) {
+                result = DUState::D;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+/// evaluate conditional block for all variables
+DUStates evaluate_conditional(const DUInstance& instance, const std::set<std::string>& variables) {
+    std::vector<DUStates> children;
+    std::set<std::string> names;
+    for (const auto& block: instance.children) {
+        children.push_back(evaluate(block, variables));
+        for (const auto& item: children.back().states) {
+            names.insert(item.first);
+        }
+    }
+
+    DUStates result;
+    result.default_state = evaluate_conditional(instance, children, "");
+    for (const auto& name: names) {
+        result.states[name] = evaluate_conditional(instance, children, name);
+    }
+    return result;
+}
+
+/// evaluate single usage for all variables
+DUStates evaluate_usage(const DUInstance& instance, const std::set<std::string>& variables) {
+    DUStates result;
+    if (instance.variable.empty()) {
+        result.default_state = instance.state;
+        return result;
+    }
+    result.states[instance.variable] = instance.state;
+    if (instance.any_index) {
+        auto prefix = instance.variable + "[";
+        for (auto it = variables.lower_bound(prefix);
+             it != variables.end() && it->compare(0, prefix.size(), prefix) == 0;
+             ++it) {
+            result.states[*it] = instance.state;
+        }
+    }
+    return result;
+}
+
+DUStates evaluate(const DUInstance& instance, const std::set<std::string>& variables) {
+    switch (instance.state) {
+    case DUState::CONDITIONAL_BLOCK:
+        return evaluate_conditional(instance, variables);
+    case DUState::IF:
+    case DUState::ELSEIF:
+    case DUState::ELSE:
+        return evaluate_sequence(instance.children, variables);
+    default:
+        return evaluate_usage(instance, variables);
+    }
+}
+
+/// find names of all variables with usages in the chain
+void collect_variables(const std::vector<DUInstance>& chain,
+                       std::set<std::string>& variables,
+                       std::set<std::string>& any_index_variables) {
+    for (const auto& instance: chain) {
+        if (is_block_state(instance.state)) {
+            collect_variables(instance.children, variables, any_index_variables);
+        } else if (!instance.variable.empty()) {
+            variables.insert(instance.variable);
+            if (instance.any_index) {
+                any_index_variables.insert(instance.variable);
+            }
+        }
+    }
+}
+
+/// keep only usages of given variable in the chain
+std::vector<DUInstance> project(const std::vector<DUInstance>& chain, const std::string& name) {
+    std::vector<DUInstance> result;
+    for (const auto& instance: chain) {
+        if (is_block_state(instance.state)) {
+            DUInstance block(instance.state);
+            block.children = project(instance.children, name);
+            result.push_back(std::move(block));
+        } else if (instance.matches(name)) {
+            result.push_back(DUInstance(instance.state));
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+DUChains::DUChains(std::string name, std::vector<DUInstance> chain)
+    : name(std::move(name))
+    , chain(std::move(chain)) {
+    std::set<std::string> variables;
+    collect_variables(this->chain, variables, any_index_variables);
+    auto result = evaluate_sequence(this->chain, variables);
+    states = std::move(result.states);
+    default_state = result.default_state;
+}
+
+DUChain DUChains::get_chain(const std::string& variable) const {
+    DUChain result(name);
+    result.chain = project(chain, variable);
+    return result;
+}
+
+DUState DUChains::eval(const std::string& variable) const {
+    auto it = states.find(variable);
+    if (it != states.end()) {
+        return it->second;
+    }
+    /// element of array accessed with unknown index but without own usage
+    auto array_name = variable.substr(0, variable.find('['));
+    if (array_name != variable &&
+        any_index_variables.find(array_name) != any_index_variables.end()) {
+        return get_chain(variable).eval();
+    }
+    return default_state;
+}
+
 void DefUseAnalyzeVisitor::visit_unsupported_node(ast::Node* node) {
     unsupported_node = true;
     node->visit_children(*this);
@@ -271,52 +502,41 @@ void DefUseAnalyzeVisitor::visit_verbatim(ast::Verbatim* node) {
 }
 
 /**
- * Update the Def-Use chain for given variable
+ * Update the Def-Use chain with usage of given variable
  *
- * @param name Name of the variable excluding index or dimension
+ * @param name Name of the variable including index (e.g. `tau[0]`)
+ * @param any_index Usage of any element of the array variable
  *
- * Update def-use chain if we encounter a variable that we are looking for.
+ * Usages of all variables are recorded with their name.
  * If we encounter non-supported construct then we mark that variable as "use"
  * because we haven't completely analyzed the usage. Marking that variable "U"
  * make sures that won't get optimized. Then we distinguish between local and
  * non-local variables. All variables that appear on lhs are marked as "definitions"
  * whereas the one on rhs are marked as "usages".
  */
-void DefUseAnalyzeVisitor::update_defuse_chain(const std::string& name) {
-    auto symbol = current_symtab->lookup_in_scope(name);
-    assert(symbol != nullptr);
+void DefUseAnalyzeVisitor::update_defuse_chain(const std::string& name, bool any_index) {
+    auto symbol = current_symtab->lookup_in_scope(name.substr(0, name.find('[')));
     // variable properties that make variable local
     auto properties = NmodlType::local_var | NmodlType::argument;
-    auto is_local = symbol->has_any_property(properties);
+    auto is_local = symbol != nullptr && symbol->has_any_property(properties);
 
+    DUState state;
     if (unsupported_node) {
-        current_chain->push_back(DUInstance(DUState::U));
+        state = DUState::U;
     } else if (visiting_lhs) {
-        if (is_local) {
-            current_chain->push_back(DUInstance(DUState::LD));
-        } else {
-            current_chain->push_back(DUInstance(DUState::D));
-        }
+        state = is_local ? DUState::LD : DUState::D;
     } else {
-        if (is_local) {
-            current_chain->push_back(DUInstance(DUState::LU));
-        } else {
-            current_chain->push_back(DUInstance(DUState::U));
-        }
+        state = is_local ? DUState::LU : DUState::U;
     }
+    current_chain->push_back(DUInstance(state, name, any_index));
 }
 
 void DefUseAnalyzeVisitor::process_variable(const std::string& name) {
-    if (name == variable_name) {
-        update_defuse_chain(name);
-    }
+    update_defuse_chain(name);
 }
 
 void DefUseAnalyzeVisitor::process_variable(const std::string& name, int index) {
-    std::string fullname = name + "[" + std::to_string(index) + "]";
-    if (fullname == variable_name) {
-        update_defuse_chain(name);
-    }
+    update_defuse_chain(name + "[" + std::to_string(index) + "]");
 }
 
 void DefUseAnalyzeVisitor::visit_with_new_chain(ast::Node* node, DUState state) {
@@ -332,22 +552,25 @@ void DefUseAnalyzeVisitor::start_new_chain(DUState state) {
 }
 
 DUChain DefUseAnalyzeVisitor::analyze(ast::Ast* node, const std::string& name) {
+    return analyze_all(node).get_chain(name);
+}
+
+DUChains DefUseAnalyzeVisitor::analyze_all(ast::Ast* node) {
     /// re-initialize state
-    variable_name = name;
     visiting_lhs = false;
     current_symtab = global_symtab;
     unsupported_node = false;
 
     /// new chain
-    DUChain usage(node->get_node_type_name());
-    current_chain = &usage.chain;
+    std::vector<DUInstance> chain;
+    current_chain = &chain;
 
     /// analyze given node
     symtab_stack.push(current_symtab);
     node->visit_children(*this);
     symtab_stack.pop();
 
-    return usage;
+    return DUChains(node->get_node_type_name(), std::move(chain));
 }
 
 }  // namespace visitor
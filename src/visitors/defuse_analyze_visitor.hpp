@@ -13,6 +13,7 @@
  */
 
 #include <map>
+#include <set>
 #include <stack>
 
 #include "ast/ast.hpp"
@@ -75,6 +76,9 @@ std::ostream& operator<<(std::ostream& os, DUState state);
  * blocks i.e. if variable is used in any of the if-elseif-else block then it needs
  * to mark as `DUState::U`. Hence we keep the track of all children in case of
  * statements like if-else.
+ *
+ * When usages of all variables are recorded together (see DUChains), the usage
+ * also stores the name of the variable it belongs to.
  */
 class DUInstance {
   public:
@@ -84,9 +88,23 @@ class DUInstance {
     /// usage of variable in case of if like statements
     std::vector<DUInstance> children;
 
+    /// variable of the usage, empty if usage applies to all variables (e.g. verbatim block)
+    std::string variable;
+
+    /// usage of any element of array variable (index is not known)
+    bool any_index = false;
+
     DUInstance(DUState state)
         : state(state) {}
 
+    DUInstance(DUState state, std::string variable, bool any_index)
+        : state(state)
+        , variable(std::move(variable))
+        , any_index(any_index) {}
+
+    /// check if usage (not if-else like sub-block) belongs to given variable
+    bool matches(const std::string& name) const;
+
     /// analyze all children and return "effective" usage
     DUState eval();
 
@@ -124,6 +142,44 @@ class DUChain {
 };
 
 
+/**
+ * \class DUChains
+ * \brief Def-Use chains of all variables for an AST node
+ *
+ * Usages of all variables are recorded in a single traversal of the node. The
+ * chain of an individual variable is obtained by keeping only its own usages
+ * (if-else like sub-blocks are kept as they are). Effective usages of all
+ * variables are evaluated once, bottom up, and can then be queried by name.
+ */
+class DUChains {
+  private:
+    /// name of the node
+    std::string name;
+
+    /// usages of all variables
+    std::vector<DUInstance> chain;
+
+    /// effective usage of variables with any usage in the chain
+    std::map<std::string, DUState> states;
+
+    /// effective usage of all other variables (e.g. due to verbatim block)
+    DUState default_state = DUState::NONE;
+
+    /// array variables accessed with unknown index
+    std::set<std::string> any_index_variables;
+
+  public:
+    DUChains() = default;
+    DUChains(std::string name, std::vector<DUInstance> chain);
+
+    /// return def-use chain of given variable
+    DUChain get_chain(const std::string& variable) const;
+
+    /// return "effective" usage of given variable
+    DUState eval(const std::string& variable) const;
+};
+
+
 /**
  * @addtogroup visitor_classes
  * @{
@@ -182,6 +238,10 @@ class DUChain {
  * For if-else statements, in the above example, if the variable is used
  * in any of the if-elseif-else part then it is considered as "used". And
  * this is done recursively from innermost level to the top.
+ *
+ * Clients analysing many variables (like the localizer pass) should use
+ * analyze_all() which records usages of all variables in a single traversal
+ * instead of traversing the node once per variable.
  */
 class DefUseAnalyzeVisitor: public AstVisitor {
   private:
@@ -198,9 +258,6 @@ class DefUseAnalyzeVisitor: public AstVisitor {
     /// symbol tables in call hierarchy
     std::stack<symtab::SymbolTable*> symtab_stack;
 
-    /// variable for which to construct def-use chain
-    std::string variable_name;
-
     /// indicate that there is unsupported construct encountered
     bool unsupported_node = false;
 
@@ -213,7 +270,7 @@ class DefUseAnalyzeVisitor: public AstVisitor {
     void process_variable(const std::string& name);
     void process_variable(const std::string& name, int index);
 
-    void update_defuse_chain(const std::string& name);
+    void update_defuse_chain(const std::string& name, bool any_index = false);
     void visit_unsupported_node(ast::Node* node);
     void visit_with_new_chain(ast::Node* node, DUState state);
     void start_new_chain(DUState state);
@@ -277,15 +334,11 @@ class DefUseAnalyzeVisitor: public AstVisitor {
 
         /// index should be an integer (e.g. after constant folding)
         /// if this is not the case and then we can't determine exact
-        /// def-use chain
+        /// def-use chain, usage applies to all elements of the array
         if (!length->is_integer()) {
-            /// check if variable name without index part is same
-            auto variable_name_prefix = variable_name.substr(0, variable_name.find("["));
-            if (name == variable_name_prefix) {
-                update_defuse_chain(variable_name_prefix);
-                std::string text = to_nmodl(node);
-                nmodl::logger->info("index used to access variable is not known : {} ", text);
-            }
+            update_defuse_chain(name, true);
+            std::string text = to_nmodl(node);
+            nmodl::logger->debug("index used to access variable is not known : {} ", text);
             return;
         }
         auto index = std::dynamic_pointer_cast<ast::Integer>(length);
@@ -302,6 +355,9 @@ class DefUseAnalyzeVisitor: public AstVisitor {
 
     /// compute def-use chain for a variable within the node
     DUChain analyze(ast::Ast* node, const std::string& name);
+
+    /// compute def-use chains for all variables within the node in a single traversal
+    DUChains analyze_all(ast::Ast* node);
 };
 
 /** @} */  // end of visitor_classes
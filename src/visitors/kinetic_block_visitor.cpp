@@ -95,6 +95,15 @@ void KineticBlockVisitor::process_conserve_reac_var(const std::string& varname,
     }
 }
 
+/// create variable node for state variable like `x` or `x[1]`
+std::shared_ptr<ast::VarName> create_state_var_name(const std::string& varname) {
+    auto varname_split = stringutils::split_string(varname, '[');
+    if (varname_split.size() > 1) {
+        return create_var_name(varname_split[0], std::stoi(varname_split[1]));
+    }
+    return create_var_name(varname);
+}
+
 std::shared_ptr<ast::Expression> create_expr(const std::string& str_expr) {
     auto statement = create_statement("dummy = " + str_expr);
     auto expr = std::dynamic_pointer_cast<ast::ExpressionStatement>(statement)->get_expression();
@@ -125,7 +134,7 @@ void KineticBlockVisitor::visit_conserve(ast::Conserve* node) {
                                 ")";
     }
 
-    auto lhs = create_expr(conserve_equation_statevar);
+    auto lhs = create_state_var_name(conserve_equation_statevar);
     // set react (lhs) of CONSERVE to the state variable whose ODE should be replaced
     node->set_react(std::move(lhs));
     // set expr (rhs) of CONSERVE to the equation that should replace the ODE
@@ -414,10 +423,12 @@ void KineticBlockVisitor::visit_kinetic_block(ast::KineticBlock* node) {
     auto kinetic_statement_block = node->get_statement_block();
     // remove any remaining kinetic statements
     remove_statements_from_block(kinetic_statement_block.get(), statements_to_remove);
-    // add new statements
+    // add new statements, all parsed at once
     for (const auto& ode: odes) {
         logger->debug("KineticBlockVisitor :: -> adding statement: {}", ode);
-        kinetic_statement_block->addStatement(create_statement(ode));
+    }
+    for (const auto& statement: create_statements(odes)) {
+        kinetic_statement_block->addStatement(statement);
     }
 
     // store pointer to kinetic block
@@ -0,0 +1,384 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include <cctype>
+#include <set>
+
+#include "codegen/codegen_naming.hpp"
+#include "utils/logger.hpp"
+#include "visitors/linear_cnexp_solve_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+
+namespace nmodl {
+namespace visitor {
+
+/**
+ * \brief Expression linear in the state variable
+ *
+ * Represents `(coeff*x + constant)/denominator` where every member is an
+ * NMODL expression string not containing the state variable `x`. Empty
+ * coefficient or constant stands for zero and empty denominator for one.
+ */
+struct LinearForm {
+    std::string coeff;
+    std::string constant;
+    std::string denominator;
+};
+
+
+/// math functions without side effects, other function calls are not considered constant
+static const std::set<std::string> MATH_FUNCTIONS = {
+    "exp", "expm1", "log", "log10", "pow", "sqrt", "fabs", "sin", "cos", "tan", "asin",
+    "acos", "atan", "atan2", "sinh", "cosh", "tanh", "floor", "ceil", "fmod", "fmin", "fmax"};
+
+
+/// return NMODL string version of node, excluding any units
+static std::string to_nmodl_without_units(ast::Ast* node) {
+    return to_nmodl(node, {ast::AstNodeType::UNIT, ast::AstNodeType::UNIT_DEF});
+}
+
+/// check if given expression can be used as an operand without parenthesis
+static bool is_atom(const std::string& expr) {
+    if (expr.empty()) {
+        return false;
+    }
+    if (expr[0] == '-') {
+        return is_atom(expr.substr(1));
+    }
+    auto identifier = [](char ch) {
+        return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '.';
+    };
+    // name, number or function call / parenthesis expression spanning the whole string
+    size_t pos = 0;
+    while (pos < expr.size() && identifier(expr[pos])) {
+        ++pos;
+    }
+    if (pos == expr.size()) {
+        return true;
+    }
+    if (expr[pos] != '(' && expr[pos] != '[') {
+        return false;
+    }
+    int depth = 0;
+    for (size_t i = pos; i < expr.size(); ++i) {
+        if (expr[i] == '(' || expr[i] == '[') {
+            ++depth;
+        } else if (expr[i] == ')' || expr[i] == ']') {
+            --depth;
+            if (depth == 0 && i != expr.size() - 1) {
+                return false;
+            }
+        }
+    }
+    return depth == 0;
+}
+
+/// wrap expression in parenthesis if it can't be used as right operand of * or /
+static std::string paren(const std::string& expr) {
+    if (is_atom(expr) && expr[0] != '-') {
+        return expr;
+    }
+    return "(" + expr + ")";
+}
+
+static std::string negate(const std::string& expr) {
+    if (expr.empty()) {
+        return expr;
+    }
+    if (expr[0] == '-' && is_atom(expr.substr(1))) {
+        return expr.substr(1);
+    }
+    return "-" + paren(expr);
+}
+
+static std::string add(const std::string& lhs, const std::string& rhs) {
+    if (lhs.empty()) {
+        return rhs;
+    }
+    if (rhs.empty()) {
+        return lhs;
+    }
+    if (rhs[0] == '-') {
+        return lhs + rhs;
+    }
+    return lhs + "+" + rhs;
+}
+
+static std::string subtract(const std::string& lhs, const std::string& rhs) {
+    return add(lhs, negate(rhs));
+}
+
+static std::string multiply(const std::string& lhs, const std::string& rhs) {
+    if (lhs.empty() || rhs.empty()) {
+        return "";
+    }
+    if (lhs == "1") {
+        return rhs;
+    }
+    if (rhs == "1") {
+        return lhs;
+    }
+    if (lhs == "-1") {
+        return negate(rhs);
+    }
+    if (rhs == "-1") {
+        return negate(lhs);
+    }
+    return (is_atom(lhs) ? lhs : "(" + lhs + ")") + "*" + paren(rhs);
+}
+
+static std::string divide(const std::string& lhs, const std::string& rhs) {
+    if (lhs.empty() || rhs.empty() || rhs == "1") {
+        return lhs;
+    }
+    if (rhs == "-1") {
+        return negate(lhs);
+    }
+    return (is_atom(lhs) ? lhs : "(" + lhs + ")") + "/" + paren(rhs);
+}
+
+/// product of two denominators where empty string stands for one
+static std::string multiply_denominator(const std::string& lhs, const std::string& rhs) {
+    if (lhs.empty()) {
+        return rhs;
+    }
+    if (rhs.empty()) {
+        return lhs;
+    }
+    return multiply(lhs, rhs);
+}
+
+/// bring linear form to denominator one
+static LinearForm normalize(const LinearForm& form) {
+    return {divide(form.coeff, form.denominator), divide(form.constant, form.denominator), ""};
+}
+
+
+/**
+ * Match expression as linear function of the state variable
+ * @param node expression to match
+ * @param state_var name of the state variable (including index, e.g. `X[0]`)
+ * @param state_var_base name of the state variable without index
+ * @param form resulting linear form
+ * @return true if expression is linear in the state variable
+ */
+static bool match_linear(ast::Expression* node,
+                         const std::string& state_var,
+                         const std::string& state_var_base,
+                         LinearForm& form) {
+    if (node->is_var_name()) {
+        if (to_nmodl(node) == state_var) {
+            form = {"1", "", ""};
+            return true;
+        }
+        if (node->get_node_name() == state_var_base) {
+            // other element (or non-constant index) of an array state variable
+            return false;
+        }
+    }
+
+    // expressions not depending on the state variable are constants
+    bool uses_state_var = false;
+    for (const auto& var: AstLookupVisitor().lookup(node, ast::AstNodeType::VAR_NAME)) {
+        if (var->get_node_name() == state_var_base) {
+            uses_state_var = true;
+            break;
+        }
+    }
+    if (!uses_state_var) {
+        // FUNCTIONs (unless inlined) may read the state variable through globals
+        for (const auto& call: AstLookupVisitor().lookup(node, ast::AstNodeType::FUNCTION_CALL)) {
+            if (MATH_FUNCTIONS.find(call->get_node_name()) == MATH_FUNCTIONS.end()) {
+                return false;
+            }
+        }
+        auto binary_expr = dynamic_cast<ast::BinaryExpression*>(node);
+        if (binary_expr != nullptr && binary_expr->get_op().get_value() == ast::BOP_DIVISION) {
+            form = {"",
+                    to_nmodl_without_units(binary_expr->get_lhs().get()),
+                    to_nmodl_without_units(binary_expr->get_rhs().get())};
+        } else {
+            form = {"", to_nmodl_without_units(node), ""};
+        }
+        return true;
+    }
+
+    if (node->is_paren_expression()) {
+        auto expr = dynamic_cast<ast::ParenExpression*>(node)->get_expression();
+        return match_linear(expr.get(), state_var, state_var_base, form);
+    }
+    if (node->is_wrapped_expression()) {
+        auto expr = dynamic_cast<ast::WrappedExpression*>(node)->get_expression();
+        return match_linear(expr.get(), state_var, state_var_base, form);
+    }
+    if (node->is_unary_expression()) {
+        auto unary_expr = dynamic_cast<ast::UnaryExpression*>(node);
+        if (unary_expr->get_op().get_value() != ast::UOP_NEGATION ||
+            !match_linear(unary_expr->get_expression().get(), state_var, state_var_base, form)) {
+            return false;
+        }
+        form.coeff = negate(form.coeff);
+        form.constant = negate(form.constant);
+        return true;
+    }
+    if (!node->is_binary_expression()) {
+        return false;
+    }
+
+    auto binary_expr = dynamic_cast<ast::BinaryExpression*>(node);
+    LinearForm lhs, rhs;
+    if (!match_linear(binary_expr->get_lhs().get(), state_var, state_var_base, lhs) ||
+        !match_linear(binary_expr->get_rhs().get(), state_var, state_var_base, rhs)) {
+        return false;
+    }
+
+    switch (binary_expr->get_op().get_value()) {
+    case ast::BOP_ADDITION:
+    case ast::BOP_SUBTRACTION: {
+        if (lhs.denominator != rhs.denominator) {
+            lhs = normalize(lhs);
+            rhs = normalize(rhs);
+        }
+        bool addition = binary_expr->get_op().get_value() == ast::BOP_ADDITION;
+        auto combine = addition ? add : subtract;
+        form = {combine(lhs.coeff, rhs.coeff),
+                combine(lhs.constant, rhs.constant),
+                lhs.denominator};
+        return true;
+    }
+
+    case ast::BOP_MULTIPLICATION:
+        // (k/d1) * (a*x+b)/d2 = (k*a*x+k*b)/(d1*d2)
+        if (lhs.coeff.empty()) {
+            std::swap(lhs, rhs);
+        }
+        if (!rhs.coeff.empty()) {
+            return false;
+        }
+        form = {multiply(rhs.constant, lhs.coeff),
+                multiply(rhs.constant, lhs.constant),
+                multiply_denominator(lhs.denominator, rhs.denominator)};
+        return true;
+
+    case ast::BOP_DIVISION:
+        // (a*x+b)/d1 / (k/d2) = (a*x+b)*d2/(d1*k)
+        if (!rhs.coeff.empty() || rhs.constant.empty()) {
+            return false;
+        }
+        form = {lhs.coeff, lhs.constant, multiply_denominator(lhs.denominator, rhs.constant)};
+        if (!rhs.denominator.empty()) {
+            form.coeff = multiply(form.coeff, rhs.denominator);
+            form.constant = multiply(form.constant, rhs.denominator);
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+void LinearCnexpSolveVisitor::visit_derivative_block(ast::DerivativeBlock* node) {
+    solve_method = solve_blocks[node->get_node_name()];
+    node->visit_children(*this);
+}
+
+
+/**
+ * \details For `x' = (a*x+b)/d` the exact solution over one timestep is
+ * `x = -b/a+(x+b/a)*exp(dt*a/d)`. If there is no constant term, this reduces
+ * to `x = x*exp(dt*a/d)` and if the equation doesn't depend on `x` to the
+ * (exact) forward Euler step `x = x+dt*b/d`.
+ */
+void LinearCnexpSolveVisitor::visit_diff_eq_expression(ast::DiffEqExpression* node) {
+    if (solve_method != codegen::naming::CNEXP_METHOD) {
+        return;
+    }
+
+    auto expr = node->get_expression();
+    if (!expr->get_lhs()->is_var_name()) {
+        return;
+    }
+    auto name = std::dynamic_pointer_cast<ast::VarName>(expr->get_lhs())->get_name();
+    std::string state_var = name->get_node_name();
+    if (name->is_indexed_name()) {
+        auto indexed_name = std::dynamic_pointer_cast<ast::IndexedName>(name);
+        if (!indexed_name->get_name()->is_prime_name() ||
+            !indexed_name->get_length()->is_integer()) {
+            return;
+        }
+        state_var += "[" + to_nmodl(indexed_name->get_length().get()) + "]";
+    } else if (!name->is_prime_name()) {
+        return;
+    }
+
+    LinearForm form;
+    if (!match_linear(expr->get_rhs().get(), state_var, name->get_node_name(), form)) {
+        logger->debug("LinearCnexpSolveVisitor :: {} is not linear", to_nmodl(node));
+        return;
+    }
+
+    const auto& dt = codegen::naming::NTHREAD_DT_VARIABLE;
+    std::string solution;
+    if (form.coeff.empty()) {
+        solution = add(state_var, multiply(dt, divide(form.constant, form.denominator)));
+    } else {
+        auto exponential = "exp(" + divide(multiply(dt, form.coeff), form.denominator) + ")";
+        auto ratio = divide(form.constant, form.coeff);
+        solution = add(negate(ratio), multiply(add(state_var, ratio), exponential));
+    }
+    solution = state_var + " = " + solution;
+    logger->debug("LinearCnexpSolveVisitor :: {} solved as {}", to_nmodl(node), solution);
+
+    auto statement = create_statement(solution);
+    auto expr_statement = std::dynamic_pointer_cast<ast::ExpressionStatement>(statement);
+    auto bin_expr = std::dynamic_pointer_cast<ast::BinaryExpression>(
+        expr_statement->get_expression());
+    node->set_expression(std::move(bin_expr));
+}
+
+
+void LinearCnexpSolveVisitor::visit_program(ast::Program* node) {
+    solve_blocks.clear();
+    for (const auto& block: AstLookupVisitor().lookup(node, ast::AstNodeType::SOLVE_BLOCK)) {
+        auto solve_block = std::dynamic_pointer_cast<ast::SolveBlock>(block);
+        if (solve_block->get_method()) {
+            solve_blocks[solve_block->get_block_name()->get_node_name()] =
+                solve_block->get_method()->get_node_name();
+        }
+    }
+    node->visit_children(*this);
+}
+
+bool LinearCnexpSolveVisitor::has_unsolved_equations(ast::Program* node) {
+    AstLookupVisitor lookup;
+    std::vector<ast::AstNodeType> equations = {ast::AstNodeType::LIN_EQUATION,
+                                               ast::AstNodeType::NON_LIN_EQUATION};
+    if (!lookup.lookup(node, equations).empty()) {
+        return true;
+    }
+    for (const auto& eq: lookup.lookup(node, ast::AstNodeType::DIFF_EQ_EXPRESSION)) {
+        auto lhs = std::dynamic_pointer_cast<ast::DiffEqExpression>(eq)->get_expression()->get_lhs();
+        if (!lhs->is_var_name()) {
+            continue;
+        }
+        auto name = std::dynamic_pointer_cast<ast::VarName>(lhs)->get_name();
+        if (name->is_indexed_name()) {
+            name = std::dynamic_pointer_cast<ast::IndexedName>(name)->get_name();
+        }
+        // solved equations have been replaced by an assignment to the state variable
+        if (name->is_prime_name()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace visitor
+}  // namespace nmodl
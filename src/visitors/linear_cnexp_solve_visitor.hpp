@@ -0,0 +1,76 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#pragma once
+
+/**
+ * \file
+ * \brief \copybrief nmodl::visitor::LinearCnexpSolveVisitor
+ */
+
+#include <map>
+#include <string>
+
+#include "ast/ast.hpp"
+#include "visitors/ast_visitor.hpp"
+
+
+namespace nmodl {
+namespace visitor {
+
+/**
+ * @addtogroup solver
+ * @addtogroup visitor_classes
+ * @{
+ */
+
+/**
+ * \class LinearCnexpSolveVisitor
+ * \brief %Visitor that analytically solves linear ODEs of `cnexp` blocks
+ *
+ * Most ODEs solved with `cnexp` method are linear in the state variable,
+ * typically of the form `x' = (xInf-x)/xTau` or `x' = a*x+b`. This pass
+ * matches such equations on the AST and replaces them with the exact
+ * solution
+ *
+ * \code{.mod}
+ *     x = -b/a+(x+b/a)*exp(dt*a)
+ * \endcode
+ *
+ * without going through the Python interpreter. Equations which are not
+ * linear in the state variable (or use constructs not understood by the
+ * matcher) are left untouched so that they are solved by a following
+ * SympySolverVisitor or NeuronSolveVisitor. This includes calls to FUNCTIONs
+ * other than math functions, which may read the state variable through
+ * global variables.
+ *
+ * \sa nmodl::visitor::SympySolverVisitor
+ * \sa nmodl::visitor::NeuronSolveVisitor
+ */
+class LinearCnexpSolveVisitor: public AstVisitor {
+  private:
+    /// a map holding solve block names and methods
+    std::map<std::string, std::string> solve_blocks;
+
+    /// method specified in solve block of derivative block being visited
+    std::string solve_method;
+
+  public:
+    LinearCnexpSolveVisitor() = default;
+
+    void visit_diff_eq_expression(ast::DiffEqExpression* node) override;
+    void visit_derivative_block(ast::DerivativeBlock* node) override;
+    void visit_program(ast::Program* node) override;
+
+    /// check if program has differential, linear or non-linear equations left to solve
+    static bool has_unsolved_equations(ast::Program* node);
+};
+
+/** @} */  // end of visitor_classes
+
+}  // namespace visitor
+}  // namespace nmodl
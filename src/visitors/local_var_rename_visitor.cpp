@@ -64,9 +64,12 @@ void LocalVarRenameVisitor::visit_statement_block(ast::StatementBlock* node) {
             std::string new_name = get_new_name(name, "r", renamed_variables);
             rename_visitor.set(name, new_name);
             rename_visitor.visit_statement_block(node);
-            auto symbol = symtab->lookup_in_scope(name);
-            symbol->set_name(new_name);
-            symbol->mark_renamed();
+            /// symbol is only renamed if the block has own symbol table declaring it
+            auto symbol = (node->get_symbol_table() == symtab) ? symtab->rename(name, new_name)
+                                                                : nullptr;
+            if (symbol != nullptr) {
+                symbol->mark_renamed();
+            }
         }
     }
 }
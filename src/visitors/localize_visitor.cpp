@@ -6,6 +6,7 @@
  *************************************************************************/
 
 #include <algorithm>
+#include <utility>
 
 #include "visitors/defuse_analyze_visitor.hpp"
 #include "visitors/localize_visitor.hpp"
@@ -107,19 +108,21 @@ void LocalizeVisitor::visit_program(ast::Program* node) {
         return;
     }
 
+    /// compute def use chains of all variables, once per block
+    std::vector<std::pair<std::shared_ptr<ast::Node>, DUChains>> block_chains;
+    for (const auto& block: node->get_blocks()) {
+        if (node_for_def_use_analysis(block.get())) {
+            DefUseAnalyzeVisitor v(program_symtab, ignore_verbatim);
+            block_chains.emplace_back(block, v.analyze_all(block.get()));
+        }
+    }
+
     auto variables = variables_to_optimize();
     for (const auto& varname: variables) {
-        const auto& blocks = node->get_blocks();
         std::map<DUState, std::vector<std::shared_ptr<ast::Node>>> block_usage;
-
-        /// compute def use chains
-        for (auto block: blocks) {
-            if (node_for_def_use_analysis(block.get())) {
-                DefUseAnalyzeVisitor v(program_symtab, ignore_verbatim);
-                auto usages = v.analyze(block.get(), varname);
-                auto result = usages.eval();
-                block_usage[result].push_back(block);
-            }
+        for (const auto& item: block_chains) {
+            auto result = item.second.eval(varname);
+            block_usage[result].push_back(item.first);
         }
 
         /// as we are doing global analysis, if any global block is "using"
@@ -134,26 +137,17 @@ void LocalizeVisitor::visit_program(ast::Program* node) {
                 for (auto& block: block_usage[state]) {
                     auto block_ptr = dynamic_cast<ast::Block*>(block.get());
                     auto statement_block = block_ptr->get_statement_block();
-                    ast::LocalVar* variable;
                     auto symbol = program_symtab->lookup(varname);
 
+                    /// also inserts new symbol in the symbol table of current block
                     if (symbol->is_array()) {
-                        variable = add_local_variable(statement_block.get(),
-                                                      varname,
-                                                      symbol->get_length());
+                        add_local_variable(statement_block.get(), varname, symbol->get_length());
                     } else {
-                        variable = add_local_variable(statement_block.get(), varname);
+                        add_local_variable(statement_block.get(), varname);
                     }
 
                     /// mark variable as localized in global symbol table
                     symbol->mark_localized();
-
-                    /// insert new symbol in the symbol table of current block
-                    auto symtab = statement_block->get_symbol_table();
-                    auto new_symbol = std::make_shared<Symbol>(varname, variable);
-                    new_symbol->add_property(NmodlType::local_var);
-                    new_symbol->mark_created();
-                    symtab->insert(new_symbol);
                 }
             }
         }
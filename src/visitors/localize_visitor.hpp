@@ -79,7 +79,8 @@ namespace visitor {
  * Implementation Notes:
  *   - For every global variable in the mod file we have to compute
  *     def-use chains in global blocks (except procedure and functions, which should be
- *     already inlined).
+ *     already inlined). Chains of all variables are computed with a single traversal
+ *     of every block.
  *   - If every block has "definition" first then that variable is safe to "localize"
  *
  * \todo
@@ -7,8 +7,6 @@
 
 #include <iostream>
 
-#include "fmt/format.h"
-
 #include "codegen/codegen_naming.hpp"
 #include "symtab/symbol.hpp"
 #include "utils/logger.hpp"
@@ -21,7 +19,6 @@
 namespace nmodl {
 namespace visitor {
 
-using namespace fmt::literals;
 using symtab::syminfo::NmodlType;
 
 std::shared_ptr<ast::DerivativeBlock> SteadystateVisitor::create_steadystate_block(
@@ -61,14 +58,16 @@ std::shared_ptr<ast::DerivativeBlock> SteadystateVisitor::create_steadystate_blo
 
         // create statements to alter value of dt within DERIVATIVE block
         // TODO: make sure dt_tmp_var_name variable name does not clash
-        std::string dt_tmp_var_name = codegen::naming::NTHREAD_DT_VARIABLE + "_saved_value";
-        std::string dt_save = dt_tmp_var_name + " = " + codegen::naming::NTHREAD_DT_VARIABLE;
-        std::string dt_assign = codegen::naming::NTHREAD_DT_VARIABLE + " = ";
-        std::string dt_restore = dt_assign + dt_tmp_var_name;
+        const auto& dt_var_name = codegen::naming::NTHREAD_DT_VARIABLE;
+        std::string dt_tmp_var_name = dt_var_name + "_saved_value";
+        auto dt_save = create_assignment(dt_tmp_var_name, create_var_name(dt_var_name));
+        auto dt_restore = create_assignment(dt_var_name, create_var_name(dt_tmp_var_name));
+        std::shared_ptr<ast::Statement> dt_assign;
         if (steadystate_method == codegen::naming::SPARSE_METHOD) {
-            dt_assign += "{:.16g}"_format(STEADYSTATE_SPARSE_DT);
+            dt_assign = create_assignment(dt_var_name, create_double(STEADYSTATE_SPARSE_DT));
         } else if (steadystate_method == codegen::naming::DERIVIMPLICIT_METHOD) {
-            dt_assign += "{:.16g}"_format(STEADYSTATE_DERIVIMPLICIT_DT);
+            dt_assign = create_assignment(dt_var_name,
+                                          create_double(STEADYSTATE_DERIVIMPLICIT_DT));
         } else {
             logger->warn("SteadystateVisitor :: solve method {} not supported for STEADYSTATE",
                          steadystate_method);
@@ -85,11 +84,11 @@ std::shared_ptr<ast::DerivativeBlock> SteadystateVisitor::create_steadystate_blo
         while ((*insertion_point)->is_local_list_statement()) {
             ++insertion_point;
         }
-        insertion_point = statements.insert(insertion_point, create_statement(dt_save));
+        insertion_point = statements.insert(insertion_point, dt_save);
         ++insertion_point;
-        statements.insert(insertion_point, create_statement(dt_assign));
+        statements.insert(insertion_point, dt_assign);
         // insert dt_restore statement at the end
-        statements.push_back(create_statement(dt_restore));
+        statements.push_back(dt_restore);
         // replace old set of statements in AST with new one
         statement_block->set_statements(std::move(statements));
 
@@ -234,10 +234,9 @@ void SympyConductanceVisitor::visit_breakpoint_block(ast::BreakpointBlock* node)
         while ((*insertion_point)->is_local_list_statement()) {
             ++insertion_point;
         }
-        for (const auto& statement_str: new_statements) {
-            insertion_point = brkpnt_statements.insert(insertion_point,
-                                                       create_statement(statement_str));
-        }
+        // (each statement is inserted above the previous one, all parsed at once)
+        auto statements = create_statements(new_statements);
+        brkpnt_statements.insert(insertion_point, statements.rbegin(), statements.rend());
         // replace old set of BREAKPOINT statements in AST with new one
         node->get_statement_block()->set_statements(std::move(brkpnt_statements));
     }
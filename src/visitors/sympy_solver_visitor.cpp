@@ -27,6 +27,8 @@ void SympySolverVisitor::init_block_data(ast::Node* node) {
     // clear any previous data
     expression_statements.clear();
     eq_system.clear();
+    ode_batch.clear();
+    ode_batch_nodes.clear();
     state_vars_in_block.clear();
     last_expression_statement = nullptr;
     block_with_expression_statements = nullptr;
@@ -192,9 +194,10 @@ void SympySolverVisitor::construct_eigen_solver_block(
     // insert pre-solve statements below last linear eq in block
     for (const auto& statement: pre_solve_statements) {
         logger->debug("SympySolverVisitor :: -> adding statement: {}", statement);
-        it = statements.insert(it, create_statement(statement));
-        ++it;
     }
+    auto new_statements = create_statements(pre_solve_statements);
+    it = statements.insert(it, new_statements.begin(), new_statements.end());
+    it += new_statements.size();
     // make Eigen vector <-> state var assignments
     std::vector<std::string> setup_x_eqs;
     std::vector<std::string> update_state_eqs;
@@ -271,11 +274,14 @@ void SympySolverVisitor::solve_linear_system(const std::vector<std::string>& pre
     init_state_vars_vector();
     // call sympy linear solver
     bool small_system = (eq_system.size() <= SMALL_LINEAR_SYSTEM_MAX_STATES);
+    bool unrolled_system = !small_system &&
+                           (eq_system.size() <= UNROLLED_LINEAR_SYSTEM_MAX_STATES);
     auto locals = py::dict("eq_strings"_a = eq_system,
                            "state_vars"_a = state_vars,
                            "vars"_a = vars,
                            "small_system"_a = small_system,
                            "do_cse"_a = elimination,
+                           "unrolled_elimination"_a = unrolled_system,
                            "function_calls"_a = function_calls);
     py::exec(R"(
                 from nmodl.ode import solve_lin_system
@@ -286,7 +292,8 @@ void SympySolverVisitor::solve_linear_system(const std::vector<std::string>& pre
                                                                  vars,
                                                                  function_calls,
                                                                  small_system,
-                                                                 do_cse)
+                                                                 do_cse,
+                                                                 unrolled_elimination)
                 except Exception as e:
                     # if we fail, fail silently and return empty string
                     solutions = [""]
@@ -309,10 +316,12 @@ void SympySolverVisitor::solve_linear_system(const std::vector<std::string>& pre
     // find out where to insert solutions in statement block
     auto& statements = block_with_expression_statements->statements;
     auto it = get_solution_location_iterator(statements);
-    if (small_system) {
+    if (small_system || unrolled_system) {
         // for small number of state vars, linear solver
-        // directly returns solution by solving symbolically at compile time
-        logger->debug("SympySolverVisitor :: Solving *small* linear system of eqs");
+        // directly returns solution by solving symbolically at compile time,
+        // for mid-sized systems it returns unrolled gaussian elimination code
+        logger->debug("SympySolverVisitor :: Solving *{}* linear system of eqs",
+                      small_system ? "small" : "unrolled");
         // declare new local vars
         if (!new_local_vars.empty()) {
             for (const auto& new_local_var: new_local_vars) {
@@ -322,17 +331,14 @@ void SympySolverVisitor::solve_linear_system(const std::vector<std::string>& pre
             }
         }
         // insert pre-solve statements below last linear eq in block
-        for (const auto& statement: pre_solve_statements) {
+        // and then new solution statements, all parsed at once
+        std::vector<std::string> new_statements_str(pre_solve_statements);
+        new_statements_str.insert(new_statements_str.end(), solutions.begin(), solutions.end());
+        for (const auto& statement: new_statements_str) {
             logger->debug("SympySolverVisitor :: -> adding statement: {}", statement);
-            it = statements.insert(it, create_statement(statement));
-            ++it;
-        }
-        // then insert new solution statements
-        for (const auto& sol: solutions) {
-            logger->debug("SympySolverVisitor :: -> adding statement: {}", sol);
-            it = statements.insert(it, create_statement(sol));
-            ++it;
         }
+        auto new_statements = create_statements(new_statements_str);
+        statements.insert(it, new_statements.begin(), new_statements.end());
         /// remove original lineq statements from the block
         remove_statements_from_block(block_with_expression_statements, expression_statements);
     } else {
@@ -380,6 +386,41 @@ void SympySolverVisitor::solve_non_linear_system(
     construct_eigen_solver_block(pre_solve_statements, solutions, false);
 }
 
+void SympySolverVisitor::solve_ode_batch() {
+    logger->debug("SympySolverVisitor :: {} - solving {} ODEs", solve_method, ode_batch.size());
+    auto locals = py::dict("equation_strings"_a = ode_batch,
+                           "method"_a = solve_method,
+                           "dt_var"_a = codegen::naming::NTHREAD_DT_VARIABLE,
+                           "vars"_a = vars,
+                           "use_pade_approx"_a = use_pade_approx,
+                           "function_calls"_a = function_calls);
+    py::exec(R"(
+                from nmodl.ode import solve_ode_batch
+                solutions, exception_messages = solve_ode_batch(equation_strings,
+                                                                method,
+                                                                dt_var,
+                                                                vars,
+                                                                use_pade_approx,
+                                                                function_calls)
+            )",
+             py::globals(),
+             locals);
+    auto solutions = locals["solutions"].cast<std::vector<std::string>>();
+    auto exception_messages = locals["exception_messages"].cast<std::vector<std::string>>();
+
+    // replace each ODE with its solution in AST
+    for (std::size_t i = 0; i < ode_batch_nodes.size(); i++) {
+        logger->debug("SympySolverVisitor :: -> solution: {}", solutions[i]);
+        if (!exception_messages[i].empty()) {
+            logger->warn("SympySolverVisitor :: python exception: " + exception_messages[i]);
+        } else if (!solutions[i].empty()) {
+            replace_diffeq_expression(ode_batch_nodes[i], solutions[i]);
+        } else {
+            logger->warn("SympySolverVisitor :: solution to differential equation not possible");
+        }
+    }
+}
+
 void SympySolverVisitor::visit_var_name(ast::VarName* node) {
     if (collect_state_vars) {
         std::string var_name = node->get_node_name();
@@ -412,90 +453,43 @@ void SympySolverVisitor::visit_diff_eq_expression(ast::DiffEqExpression* node) {
     if ((lhs_name->is_indexed_name() &&
          !std::dynamic_pointer_cast<ast::IndexedName>(lhs_name)->get_name()->is_prime_name()) ||
         (!lhs_name->is_indexed_name() && !lhs_name->is_prime_name())) {
-        logger->warn("SympySolverVisitor :: LHS of differential equation is not a PrimeName");
+        // e.g. already replaced by its solution in LinearCnexpSolveVisitor
+        logger->debug("SympySolverVisitor :: LHS of differential equation is not a PrimeName");
         return;
     }
 
     check_expr_statements_in_same_block();
 
-    const auto node_as_nmodl = to_nmodl_for_sympy(node);
-    const auto locals = py::dict("equation_string"_a = node_as_nmodl,
-                                 "dt_var"_a = codegen::naming::NTHREAD_DT_VARIABLE,
-                                 "vars"_a = vars,
-                                 "use_pade_approx"_a = use_pade_approx,
-                                 "function_calls"_a = function_calls);
-
-    if (solve_method == codegen::naming::EULER_METHOD) {
-        logger->debug("SympySolverVisitor :: EULER - solving: {}", node_as_nmodl);
-        // replace x' = f(x) differential equation
-        // with forwards Euler timestep:
-        // x = x + f(x) * dt
-        py::exec(R"(
-                from nmodl.ode import forwards_euler2c
-                exception_message = ""
-                try:
-                    solution = forwards_euler2c(equation_string, dt_var, vars, function_calls)
-                except Exception as e:
-                    # if we fail, fail silently and return empty string
-                    solution = ""
-                    exception_message = str(e)
-            )",
-                 py::globals(),
-                 locals);
-    } else if (solve_method == codegen::naming::CNEXP_METHOD) {
-        // replace x' = f(x) differential equation
-        // with analytic solution for x(t+dt) in terms of x(t)
-        // x = ...
-        logger->debug("SympySolverVisitor :: CNEXP - solving: {}", node_as_nmodl);
-        py::exec(R"(
-                from nmodl.ode import integrate2c
-                exception_message = ""
-                try:
-                    solution = integrate2c(equation_string, dt_var, vars,
-                                           use_pade_approx)
-                except Exception as e:
-                    # if we fail, fail silently and return empty string
-                    solution = ""
-                    exception_message = str(e)
-            )",
-                 py::globals(),
-                 locals);
-    } else {
-        // for other solver methods: just collect the ODEs & return
-        std::string eq_str = to_nmodl_for_sympy(node);
-        std::string var_name = lhs_name->get_node_name();
-        if (lhs_name->is_indexed_name()) {
-            auto index_name = std::dynamic_pointer_cast<ast::IndexedName>(lhs_name);
-            var_name +=
-                "[" +
-                std::to_string(
-                    std::dynamic_pointer_cast<ast::Integer>(index_name->get_length())->eval()) +
-                "]";
-        }
-        logger->debug("SympySolverVisitor :: adding ODE system: {}", eq_str);
-        eq_system.push_back(eq_str);
-        logger->debug("SympySolverVisitor :: adding state var: {}", var_name);
-        state_vars_in_block.insert(var_name);
-        expression_statements.insert(current_expression_statement);
-        last_expression_statement = current_expression_statement;
+    if (solve_method == codegen::naming::EULER_METHOD ||
+        solve_method == codegen::naming::CNEXP_METHOD) {
+        // each equation is independent and replaced with its solution:
+        //  - EULER: x' = f(x) with forwards Euler timestep x = x + f(x) * dt
+        //  - CNEXP: x' = f(x) with analytic solution for x(t+dt) in terms of x(t)
+        // collect them here and solve all equations of the block in one call
+        const auto node_as_nmodl = to_nmodl_for_sympy(node);
+        logger->debug("SympySolverVisitor :: {} - adding ODE: {}", solve_method, node_as_nmodl);
+        ode_batch.push_back(node_as_nmodl);
+        ode_batch_nodes.push_back(node);
         return;
     }
 
-    // replace ODE with solution in AST
-    auto solution = locals["solution"].cast<std::string>();
-    logger->debug("SympySolverVisitor :: -> solution: {}", solution);
-
-    auto exception_message = locals["exception_message"].cast<std::string>();
-    if (!exception_message.empty()) {
-        logger->warn("SympySolverVisitor :: python exception: " + exception_message);
-        return;
-    }
-
-    if (!solution.empty()) {
-        replace_diffeq_expression(node, solution);
-    } else {
-        logger->warn("SympySolverVisitor :: solution to differential equation not possible");
+    // for other solver methods: just collect the ODEs & return
+    std::string eq_str = to_nmodl_for_sympy(node);
+    std::string var_name = lhs_name->get_node_name();
+    if (lhs_name->is_indexed_name()) {
+        auto index_name = std::dynamic_pointer_cast<ast::IndexedName>(lhs_name);
+        var_name +=
+            "[" +
+            std::to_string(
+                std::dynamic_pointer_cast<ast::Integer>(index_name->get_length())->eval()) +
+            "]";
     }
+    logger->debug("SympySolverVisitor :: adding ODE system: {}", eq_str);
+    eq_system.push_back(eq_str);
+    logger->debug("SympySolverVisitor :: adding state var: {}", var_name);
+    state_vars_in_block.insert(var_name);
+    expression_statements.insert(current_expression_statement);
+    last_expression_statement = current_expression_statement;
 }
 
 void SympySolverVisitor::visit_conserve(ast::Conserve* node) {
@@ -530,10 +524,15 @@ void SympySolverVisitor::visit_derivative_block(ast::DerivativeBlock* node) {
     solve_method = derivative_block_solve_method[node->get_node_name()];
 
     // visit each differential equation:
-    //  - for CNEXP or EULER, each equation is independent & is replaced with its solution
+    //  - for CNEXP or EULER, each equation is independent & is added to ode_batch
     //  - otherwise, each equation is added to eq_system
     node->visit_children(*this);
 
+    if (!ode_batch.empty()) {
+        // replace each independent ODE with its solution
+        solve_ode_batch();
+    }
+
     if (eq_system_is_valid && !eq_system.empty()) {
         // solve system of ODEs in eq_system
         logger->debug("SympySolverVisitor :: Solving {} system of ODEs", solve_method);
@@ -47,6 +47,9 @@ namespace visitor {
  *  - for small systems: solves resulting linear algebraic equation by
  *    Gaussian elimination, replaces differential equations
  *    with explicit solution of backwards Euler equations
+ *  - for mid-sized systems (optional): replaces differential equations
+ *    with straight-line Gaussian elimination code, using a pivot order
+ *    chosen at compile time from the sparsity of the system
  *  - for large systems, returns matrix and vector of linear system
  *    to be solved by e.g. LU factorization
  *
@@ -57,6 +60,8 @@ namespace visitor {
  * For `LINEAR` blocks:
  *  - for small systems: solve linear system of algebraic equations by
  *    Gaussian elimination, replace equations with solutions
+ *  - for mid-sized systems (optional): replace equations with
+ *    straight-line Gaussian elimination code
  *  - for large systems: return matrix and vector of linear system
  *    to be solved by e.g. LU factorization
  *
@@ -91,6 +96,9 @@ class SympySolverVisitor: public AstVisitor {
     /// solve non-linear system (for "derivimplicit" and "NONLINEAR")
     void solve_non_linear_system(const std::vector<std::string>& pre_solve_statements = {});
 
+    /// solve all independent ODEs of a block in one call (for "cnexp" and "euler")
+    void solve_ode_batch();
+
     /// return NMODL string version of node, excluding any units
     static std::string to_nmodl_for_sympy(ast::Ast* node) {
         return nmodl::to_nmodl(node, {ast::AstNodeType::UNIT, ast::AstNodeType::UNIT_DEF});
@@ -147,6 +155,12 @@ class SympySolverVisitor: public AstVisitor {
     /// vector of {ODE, linear eq, non-linear eq} system to solve
     std::vector<std::string> eq_system;
 
+    /// independent ODEs (cnexp / euler) in current block to be solved as a batch
+    std::vector<std::string> ode_batch;
+
+    /// differential equation nodes corresponding to each ODE in ode_batch
+    std::vector<ast::DiffEqExpression*> ode_batch_nodes;
+
     /// only solve eq_system system of equations if this is true:
     bool eq_system_is_valid = true;
 
@@ -175,13 +189,18 @@ class SympySolverVisitor: public AstVisitor {
     /// max number of state vars allowed for small system linear solver
     int SMALL_LINEAR_SYSTEM_MAX_STATES;
 
+    /// max number of state vars allowed for unrolled gaussian elimination (0 to disable)
+    int UNROLLED_LINEAR_SYSTEM_MAX_STATES;
+
   public:
     SympySolverVisitor(bool use_pade_approx = false,
                        bool elimination = true,
-                       int SMALL_LINEAR_SYSTEM_MAX_STATES = 3)
+                       int SMALL_LINEAR_SYSTEM_MAX_STATES = 3,
+                       int UNROLLED_LINEAR_SYSTEM_MAX_STATES = 0)
         : use_pade_approx(use_pade_approx)
         , elimination(elimination)
-        , SMALL_LINEAR_SYSTEM_MAX_STATES(SMALL_LINEAR_SYSTEM_MAX_STATES){};
+        , SMALL_LINEAR_SYSTEM_MAX_STATES(SMALL_LINEAR_SYSTEM_MAX_STATES)
+        , UNROLLED_LINEAR_SYSTEM_MAX_STATES(UNROLLED_LINEAR_SYSTEM_MAX_STATES){};
 
     void visit_var_name(ast::VarName* node) override;
     void visit_diff_eq_expression(ast::DiffEqExpression* node) override;
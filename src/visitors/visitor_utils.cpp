@@ -5,6 +5,8 @@
  * Lesser General Public License. See top-level LICENSE file for details.
  *************************************************************************/
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
@@ -15,6 +17,7 @@
 #include "visitors/json_visitor.hpp"
 #include "visitors/lookup_visitor.hpp"
 #include "visitors/nmodl_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
 
 
 namespace nmodl {
@@ -57,6 +60,20 @@ LocalVar* add_local_variable(StatementBlock* node, Identifier* varname) {
     auto local_variables = get_local_variables(node);
     auto var = std::make_shared<LocalVar>(varname);
     local_variables->push_back(var);
+
+    /// update symbol table instead of requiring symtab visitor to run again
+    auto symtab = node->get_symbol_table();
+    auto name = var->get_node_name();
+    if (symtab != nullptr && symtab->lookup(name) == nullptr) {
+        auto symbol = std::make_shared<symtab::Symbol>(name, var.get());
+        symbol->add_property(NmodlType::local_var);
+        if (varname->is_indexed_name()) {
+            auto length = static_cast<IndexedName*>(varname)->get_length();
+            symbol->set_as_array(std::static_pointer_cast<Integer>(length)->eval());
+        }
+        symbol->mark_created();
+        symtab->insert(symbol);
+    }
     return var.get();
 }
 
@@ -90,6 +107,22 @@ std::shared_ptr<Statement> create_statement(const std::string& code_statement) {
     return statement;
 }
 
+/**
+ * Convert given code statements (in string format) to corresponding ast nodes
+ *
+ * All statements are put into a single dummy nmodl procedure so that the
+ * NMODL parser is only run once, instead of once per statement as with
+ * create_statement().
+ */
+std::vector<std::shared_ptr<Statement>> create_statements(
+    const std::vector<std::string>& code_statements) {
+    if (code_statements.empty()) {
+        return {};
+    }
+    auto statement_block = create_statement_block(code_statements);
+    return statement_block->get_statements();
+}
+
 /**
  * Convert given code statement (in string format) to corresponding ast node
  *
@@ -113,6 +146,49 @@ std::shared_ptr<StatementBlock> create_statement_block(
 }
 
 
+std::shared_ptr<VarName> create_var_name(const std::string& name) {
+    return std::make_shared<VarName>(new Name(new String(name)), nullptr, nullptr);
+}
+
+std::shared_ptr<VarName> create_var_name(const std::string& name, int index) {
+    auto indexed_name = new IndexedName(new Name(new String(name)), new Integer(index, nullptr));
+    return std::make_shared<VarName>(indexed_name, nullptr, nullptr);
+}
+
+std::shared_ptr<Double> create_double(double value) {
+    return std::make_shared<Double>(value);
+}
+
+std::shared_ptr<ParenExpression> create_paren_expression(std::shared_ptr<Expression> expression) {
+    return std::make_shared<ParenExpression>(std::move(expression));
+}
+
+std::shared_ptr<BinaryExpression> create_binary_expression(std::shared_ptr<Expression> lhs,
+                                                           BinaryOp op,
+                                                           std::shared_ptr<Expression> rhs) {
+    return std::make_shared<BinaryExpression>(std::move(lhs),
+                                              BinaryOperator(op),
+                                              std::move(rhs));
+}
+
+std::shared_ptr<FunctionCall> create_function_call(const std::string& name,
+                                                   ExpressionVector arguments) {
+    return std::make_shared<FunctionCall>(std::make_shared<Name>(new String(name)),
+                                          std::move(arguments));
+}
+
+std::shared_ptr<ExpressionStatement> create_assignment(std::shared_ptr<Expression> lhs,
+                                                       std::shared_ptr<Expression> rhs) {
+    auto expression = create_binary_expression(std::move(lhs), BOP_ASSIGN, std::move(rhs));
+    return std::make_shared<ExpressionStatement>(std::move(expression));
+}
+
+std::shared_ptr<ExpressionStatement> create_assignment(const std::string& name,
+                                                       std::shared_ptr<Expression> rhs) {
+    return create_assignment(create_var_name(name), std::move(rhs));
+}
+
+
 void remove_statements_from_block(ast::StatementBlock* block,
                                   const std::set<ast::Node*> statements) {
     auto& statement_vec = block->statements;
@@ -159,6 +235,25 @@ bool calls_function(ast::Ast* node, const std::string& name) {
     return false;
 }
 
+
+std::vector<std::string> verify_symbol_table(Program* node) {
+    std::set<std::string> before;
+    if (auto* symtab = node->get_symbol_table()) {
+        symtab->get_qualified_names(before);
+    }
+    SymtabVisitor(true).visit_program(node);
+    std::set<std::string> after;
+    node->get_symbol_table()->get_qualified_names(after);
+
+    std::vector<std::string> missing;
+    std::set_difference(after.begin(),
+                        after.end(),
+                        before.begin(),
+                        before.end(),
+                        std::back_inserter(missing));
+    return missing;
+}
+
 }  // namespace visitor
 
 
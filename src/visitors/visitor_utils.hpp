@@ -15,6 +15,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "ast/ast.hpp"
 
@@ -36,7 +37,7 @@ ast::LocalVarVector* get_local_variables(const ast::StatementBlock* node);
 void add_local_statement(ast::StatementBlock* node);
 
 
-/// Add new local variable to the block
+/// Add new local variable to the block (and to its symbol table if already setup)
 ast::LocalVar* add_local_variable(ast::StatementBlock* node, const std::string& varname);
 ast::LocalVar* add_local_variable(ast::StatementBlock* node, ast::Identifier* varname);
 ast::LocalVar* add_local_variable(ast::StatementBlock* node, const std::string& varname, int dim);
@@ -46,11 +47,62 @@ ast::LocalVar* add_local_variable(ast::StatementBlock* node, const std::string&
 std::shared_ptr<ast::Statement> create_statement(const std::string& code_statement);
 
 
+/// Create ast statement nodes from given code in string format, parsed at once
+std::vector<std::shared_ptr<ast::Statement>> create_statements(
+    const std::vector<std::string>& code_statements);
+
+
 /// Create ast statement block node from given code in string format
 std::shared_ptr<ast::StatementBlock> create_statement_block(
     const std::vector<std::string>& code_statements);
 
 
+/**
+ * \name Typed construction of ast nodes
+ *
+ * Build nodes directly instead of parsing NMODL code. Unlike the parser, no
+ * WrappedExpression nodes are created and no parentheses are added : operands
+ * of binary expressions must be wrapped with create_paren_expression() if the
+ * operator precedence requires it.
+ * \{
+ */
+
+/// Create variable node for given name, e.g. `tau`
+std::shared_ptr<ast::VarName> create_var_name(const std::string& name);
+
+/// Create variable node for given array element, e.g. `tau[2]`
+std::shared_ptr<ast::VarName> create_var_name(const std::string& name, int index);
+
+/// Create floating point literal
+std::shared_ptr<ast::Double> create_double(double value);
+
+/// Create expression `(expression)`
+std::shared_ptr<ast::ParenExpression> create_paren_expression(
+    std::shared_ptr<ast::Expression> expression);
+
+/// Create expression `lhs op rhs`
+std::shared_ptr<ast::BinaryExpression> create_binary_expression(
+    std::shared_ptr<ast::Expression> lhs,
+    ast::BinaryOp op,
+    std::shared_ptr<ast::Expression> rhs);
+
+/// Create call of given function
+std::shared_ptr<ast::FunctionCall> create_function_call(const std::string& name,
+                                                        ast::ExpressionVector arguments);
+
+/// Create statement `lhs = rhs`
+std::shared_ptr<ast::ExpressionStatement> create_assignment(
+    std::shared_ptr<ast::Expression> lhs,
+    std::shared_ptr<ast::Expression> rhs);
+
+/// Create statement `name = rhs`
+std::shared_ptr<ast::ExpressionStatement> create_assignment(
+    const std::string& name,
+    std::shared_ptr<ast::Expression> rhs);
+
+/** \} */
+
+
 ///  Remove statements from given statement block if they exist
 void remove_statements_from_block(ast::StatementBlock* block,
                                   const std::set<ast::Node*> statements);
@@ -63,6 +115,15 @@ std::set<std::string> get_global_vars(ast::Program* node);
 /// Checks whether block contains a call to a perticular function
 bool calls_function(ast::Ast* node, const std::string& name);
 
+
+/**
+ * Rebuild symbol table of the program in update mode and return symbols added
+ * by the rebuild, as "table::symbol". Passes update symbol tables themselves
+ * when they add, rename or remove variables : non-empty result means a pass
+ * has missed an update.
+ */
+std::vector<std::string> verify_symbol_table(ast::Program* node);
+
 }  // namespace visitor
 
 
@@ -0,0 +1,135 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#define CATCH_CONFIG_MAIN
+
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <Eigen/LU>
+
+#include "catch/catch.hpp"
+#include "codegen/codegen_sparse_lu.hpp"
+
+using namespace nmodl;
+using codegen::SparseLU;
+
+//=============================================================================
+// Interpreter for the statements generated by SparseLU
+//=============================================================================
+
+using Arrays = std::map<std::string, std::vector<double>>;
+
+/// execute statements of the form `a[i] = b[j]-c[k]*d[l];` and `a[i] = b[j]/c[k];`
+static void execute(const std::vector<std::string>& statements, Arrays& arrays) {
+    static const std::regex statement(
+        R"((\w+)\[(\d+)\] = (\w+)\[(\d+)\]([-/])(\w+)\[(\d+)\](?:\*(\w+)\[(\d+)\])?;)");
+    for (const auto& text: statements) {
+        std::smatch match;
+        REQUIRE(std::regex_match(text, match, statement));
+        auto element = [&](int i) -> double& {
+            return arrays.at(match[i].str()).at(std::stoi(match[i + 1].str()));
+        };
+        double result = element(3);
+        if (match[5] == "/") {
+            result /= element(6);
+        } else {
+            result -= element(6) * element(8);
+        }
+        element(1) = result;
+    }
+}
+
+/// evaluate condition of the form `a[i] != 0 && b[j] != 0`
+static bool evaluate(const std::string& condition, Arrays& arrays) {
+    static const std::regex term(R"((\w+)\[(\d+)\] != 0)");
+    bool result = true;
+    for (std::sregex_iterator it(condition.begin(), condition.end(), term), end; it != end; ++it) {
+        result = result && arrays.at((*it)[1].str()).at(std::stoi((*it)[2].str())) != 0;
+    }
+    return result;
+}
+
+/// solve with generated statements, returns false if a pivot was zero
+template <int N>
+static bool sparse_solve(const Eigen::Matrix<double, N, N>& A,
+                         const Eigen::Matrix<double, N, 1>& b,
+                         Eigen::Matrix<double, N, 1>& x) {
+    std::vector<bool> non_zero(N * N);
+    for (int i = 0; i < N * N; i++) {
+        non_zero[i] = A.data()[i] != 0;
+    }
+    SparseLU lu(N, non_zero);
+    Arrays arrays;
+    arrays["J"] = std::vector<double>(A.data(), A.data() + N * N);
+    arrays["F"] = std::vector<double>(b.data(), b.data() + N);
+    execute(lu.factorize_statements("J"), arrays);
+    if (!evaluate(lu.non_zero_pivots("J"), arrays)) {
+        return false;
+    }
+    execute(lu.solve_statements("J", "F"), arrays);
+    x = Eigen::Map<Eigen::Matrix<double, N, 1>>(arrays["F"].data());
+    return true;
+}
+
+
+SCENARIO("Generated sparse LU factorization", "[codegen][sparse_lu]") {
+    GIVEN("Tridiagonal matrix") {
+        Eigen::Matrix<double, 5, 5> A = Eigen::Matrix<double, 5, 5>::Zero();
+        for (int i = 0; i < 5; i++) {
+            A(i, i) = 4.0 + i;
+            if (i > 0) {
+                A(i, i - 1) = -1.0 - 0.1 * i;
+                A(i - 1, i) = -2.0;
+            }
+        }
+        Eigen::Matrix<double, 5, 1> b{1.0, 2.0, 3.0, 4.0, 5.0};
+        THEN("no fill-in and same solution as dense LU") {
+            std::vector<bool> non_zero(A.data(), A.data() + 25);
+            REQUIRE(SparseLU(5, non_zero).fill_in() == 0);
+            Eigen::Matrix<double, 5, 1> x;
+            REQUIRE(sparse_solve<5>(A, b, x));
+            Eigen::Matrix<double, 5, 1> expected = A.partialPivLu().solve(b);
+            REQUIRE((x - expected).norm() < 1e-12);
+        }
+    }
+
+    GIVEN("Arrow matrix with full first row and column") {
+        Eigen::Matrix<double, 4, 4> A = 5.0 * Eigen::Matrix<double, 4, 4>::Identity();
+        for (int i = 1; i < 4; i++) {
+            A(0, i) = 1.0 * i;
+            A(i, 0) = -0.5 * i;
+        }
+        Eigen::Matrix<double, 4, 1> b{1.0, -1.0, 2.0, 0.5};
+        THEN("fill-in of trailing block and same solution as dense LU") {
+            std::vector<bool> non_zero(16);
+            for (int i = 0; i < 16; i++) {
+                non_zero[i] = A.data()[i] != 0;
+            }
+            REQUIRE(SparseLU(4, non_zero).fill_in() == 6);
+            Eigen::Matrix<double, 4, 1> x;
+            REQUIRE(sparse_solve<4>(A, b, x));
+            Eigen::Matrix<double, 4, 1> expected = A.partialPivLu().solve(b);
+            REQUIRE((x - expected).norm() < 1e-12);
+        }
+    }
+
+    GIVEN("Matrix with zero pivot in natural order") {
+        // pattern is known at translation time, values only at runtime
+        Eigen::Matrix<double, 3, 3> A;
+        A << 1.0, 2.0, 1.0, 2.0, 4.0, 1.0, 1.0, 1.0, 3.0;
+        Eigen::Matrix<double, 3, 1> b{1.0, 2.0, 3.0};
+        THEN("pivot check fails so that generated code falls back to dense LU") {
+            Eigen::Matrix<double, 3, 1> x;
+            REQUIRE_FALSE(sparse_solve<3>(A, b, x));
+            Eigen::Matrix<double, 3, 1> expected = A.partialPivLu().solve(b);
+            REQUIRE((A * expected - b).norm() < 1e-12);
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#define CATCH_CONFIG_MAIN
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "catch/catch.hpp"
+#include "codegen/fast_math.hpp"
+
+using namespace nmodl;
+
+/// maximum error of f with respect to reference (relative for results larger than one)
+template <typename T, typename F, typename R, typename D>
+T max_relative_error(F f, R reference, D distribution) {
+    std::mt19937 generator(42);
+    T max_error = 0;
+    for (int i = 0; i < 100000; i++) {
+        T x = static_cast<T>(distribution(generator));
+        T expected = reference(x);
+        T error = std::abs(f(x) - expected) / std::max(T(1), std::abs(expected));
+        max_error = std::max(max_error, error);
+    }
+    return max_error;
+}
+
+SCENARIO("Vectorizable math functions", "[fast_math]") {
+    using fast_math::vexp;
+    using fast_math::vexpm1;
+    using fast_math::vlog;
+    using fast_math::vpow;
+    std::uniform_real_distribution<double> exp_range(-700.0, 700.0);
+    std::uniform_real_distribution<double> log_range(1e-10, 1e10);
+    std::uniform_real_distribution<double> expm1_range(-1e-3, 1e-3);
+
+    GIVEN("double precision functions") {
+        THEN("results are accurate to a few ulp") {
+            auto e = [](double x) { return vexp(x); };
+            auto l = [](double x) { return vlog(x); };
+            auto m = [](double x) { return vexpm1(x); };
+            auto p = [](double x) { return vpow(x, 2.5); };
+            auto pe = [](double x) { return std::pow(x, 2.5); };
+            std::uniform_real_distribution<double> pow_range(1e-3, 1e3);
+            REQUIRE(max_relative_error<double>(e, [](double x) { return std::exp(x); }, exp_range) <
+                    1e-15);
+            REQUIRE(max_relative_error<double>(l, [](double x) { return std::log(x); }, log_range) <
+                    1e-15);
+            REQUIRE(max_relative_error<double>(
+                        m, [](double x) { return std::expm1(x); }, expm1_range) < 1e-15);
+            REQUIRE(max_relative_error<double>(p, pe, pow_range) < 1e-13);
+        }
+        THEN("approximate versions have relative error below 1e-7") {
+            auto e = [](double x) { return fast_math::approx::vexp(x); };
+            auto l = [](double x) { return fast_math::approx::vlog(x); };
+            auto m = [](double x) { return fast_math::approx::vexpm1(x); };
+            auto p = [](double x) { return fast_math::approx::vpow(x, 2.5); };
+            auto pe = [](double x) { return std::pow(x, 2.5); };
+            std::uniform_real_distribution<double> pow_range(1e-3, 1e3);
+            REQUIRE(max_relative_error<double>(e, [](double x) { return std::exp(x); }, exp_range) <
+                    1e-7);
+            REQUIRE(max_relative_error<double>(l, [](double x) { return std::log(x); }, log_range) <
+                    1e-7);
+            REQUIRE(max_relative_error<double>(
+                        m, [](double x) { return std::expm1(x); }, expm1_range) < 1e-7);
+            REQUIRE(max_relative_error<double>(p, pe, pow_range) < 1e-7);
+        }
+        THEN("special values are handled") {
+            REQUIRE(vexp(0.0) == 1.0);
+            REQUIRE(vexp(800.0) == std::numeric_limits<double>::infinity());
+            REQUIRE(vexp(-800.0) == 0.0);
+            REQUIRE(vlog(1.0) == 0.0);
+            REQUIRE(vlog(0.0) == -std::numeric_limits<double>::infinity());
+            REQUIRE(std::isnan(vlog(-1.0)));
+            REQUIRE(vexpm1(0.0) == 0.0);
+            REQUIRE(vpow(-2.0, 3.0) == Approx(-8.0));
+            REQUIRE(vpow(-2.0, 2.0) == Approx(4.0));
+            REQUIRE(std::isnan(vpow(-2.0, 0.5)));
+            REQUIRE(vpow(0.0, 0.0) == 1.0);
+            REQUIRE(vpow(0.0, 2.0) == 0.0);
+        }
+        THEN("NaN arguments propagate") {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            REQUIRE(std::isnan(vexp(nan)));
+            REQUIRE(std::isnan(vlog(nan)));
+            REQUIRE(std::isnan(vexpm1(nan)));
+            REQUIRE(std::isnan(vpow(nan, 2.0)));
+            REQUIRE(std::isnan(vpow(2.0, nan)));
+            REQUIRE(std::isnan(fast_math::approx::vlog(nan)));
+            REQUIRE(std::isnan(fast_math::approx::vpow(nan, 2.0)));
+        }
+    }
+
+    GIVEN("single precision functions") {
+        THEN("results are accurate to a few ulp") {
+            std::uniform_real_distribution<double> expf_range(-80.0, 80.0);
+            auto e = [](float x) { return vexp(x); };
+            auto l = [](float x) { return vlog(x); };
+            REQUIRE(max_relative_error<float>(e, [](float x) { return std::exp(x); }, expf_range) <
+                    5e-7f);
+            REQUIRE(max_relative_error<float>(l, [](float x) { return std::log(x); }, log_range) <
+                    5e-7f);
+            REQUIRE(vexp(100.0f) == std::numeric_limits<float>::infinity());
+        }
+        THEN("NaN arguments propagate") {
+            const float nan = std::numeric_limits<float>::quiet_NaN();
+            REQUIRE(std::isnan(vexp(nan)));
+            REQUIRE(std::isnan(vlog(nan)));
+            REQUIRE(std::isnan(vpow(nan, 2.0f)));
+        }
+    }
+
+    GIVEN("integer and mixed precision arguments as printed by code generation") {
+        THEN("they are computed in double precision like std functions") {
+            float f = 2.0f;
+            REQUIRE(vexp(2) == Approx(std::exp(2)));
+            REQUIRE(vlog(10) == Approx(std::log(10)));
+            REQUIRE(vexpm1(1) == Approx(std::expm1(1)));
+            REQUIRE(vpow(10, 3) == Approx(1000.0));
+            REQUIRE(vpow(2, 0.5) == Approx(std::sqrt(2.0)));
+            REQUIRE(vpow(2.0, 3) == Approx(8.0));
+            REQUIRE(vpow(f, 1.5) == Approx(std::pow(f, 1.5)));
+            REQUIRE(vpow(1.5, f) == Approx(2.25));
+            REQUIRE(fast_math::approx::vexp(2) == Approx(std::exp(2)));
+            REQUIRE(fast_math::approx::vlog(10) == Approx(std::log(10)));
+            REQUIRE(fast_math::approx::vexpm1(1) == Approx(std::expm1(1)));
+            REQUIRE(fast_math::approx::vpow(10, 3) == Approx(1000.0));
+            REQUIRE(fast_math::approx::vpow(f, 1.5) == Approx(std::pow(f, 1.5)));
+        }
+    }
+}
@@ -8,8 +8,11 @@
 #define CATCH_CONFIG_MAIN
 
 #include <cmath>
+#include <sstream>
+#include <thread>
 
 #include "catch/catch.hpp"
+#include "newton/newton_stats.hpp"
 #include "nmodl/nmodl.hpp"
 
 using namespace nmodl;
@@ -558,3 +561,309 @@ SCENARIO("Non-linear system to solve with Newton Solver", "[analytic][solver]")
         }
     }
 }
+
+SCENARIO("Non-linear systems to solve with batched Newton Solver", "[analytic][solver]") {
+    GIVEN("3 instances of system of 2 non-linear eqs with different parameters") {
+        struct functor {
+            double a = 0.0;
+            void operator()(const Eigen::Matrix<double, 2, 1>& X,
+                            Eigen::Matrix<double, 2, 1>& F,
+                            Eigen::Matrix<double, 2, 2>& J) const {
+                F[0] = -3.0 * X[0] * X[1] + X[0] + 2.0 * X[1] - 1.0;
+                F[1] = 4.0 * X[0] - a * std::pow(X[1], 2) + X[1] + 0.4;
+                J(0, 0) = -3.0 * X[1] + 1.0;
+                J(0, 1) = -3.0 * X[0] + 2.0;
+                J(1, 0) = 4.0;
+                J(1, 1) = -2.0 * a * X[1] + 1.0;
+            }
+        };
+        constexpr int width = 4;
+        int lanes = 3;
+        functor fn[width];
+        int iterations[width];
+        Eigen::Matrix<double, 2, width, Eigen::RowMajor> X;
+        for (int l = 0; l < lanes; ++l) {
+            fn[l].a = 0.3 + 0.1 * l;
+            X.col(l) << 0.2 + 0.1 * l, 0.4;
+        }
+        X.col(3) << 7.0, 7.0;
+        int iter_newton = newton::newton_solver_batch(X, fn, lanes, iterations);
+        THEN("find a solution for every lane, same as Newton Solver") {
+            CAPTURE(iter_newton);
+            CAPTURE(X);
+            REQUIRE(iter_newton > 0);
+            for (int l = 0; l < lanes; ++l) {
+                Eigen::Matrix<double, 2, 1> X_lane = X.col(l);
+                Eigen::Matrix<double, 2, 1> F;
+                Eigen::Matrix<double, 2, 2> J;
+                fn[l](X_lane, F, J);
+                REQUIRE(F.norm() < max_error_norm);
+                Eigen::Matrix<double, 2, 1> X_single{0.2 + 0.1 * l, 0.4};
+                int iter_single = newton::newton_solver(X_single, fn[l]);
+                REQUIRE(iterations[l] == iter_single);
+                REQUIRE(X_lane[0] == Approx(X_single[0]));
+                REQUIRE(X_lane[1] == Approx(X_single[1]));
+            }
+            REQUIRE(X(0, 3) == 7.0);
+            REQUIRE(X(1, 3) == 7.0);
+        }
+    }
+}
+
+SCENARIO("Non-linear system to solve with Newton Sparse Solver", "[analytic][solver]") {
+    GIVEN("system of 3 non-linear eqs with tridiagonal Jacobian") {
+        struct functor {
+            void operator()(const Eigen::Matrix<double, 3, 1>& X,
+                            Eigen::Matrix<double, 3, 1>& F,
+                            Eigen::Matrix<double, 3, 3>& Jm) const {
+                double* J = Jm.data();
+                F[0] = 4.0 * X[0] - X[1] + 0.1 * X[0] * X[0] - 1.0;
+                F[1] = -X[0] + 4.0 * X[1] - X[2] - 2.0;
+                F[2] = -X[1] + 4.0 * X[2] + 0.2 * X[2] * X[2] * X[2] - 3.0;
+                J[0] = 4.0 + 0.2 * X[0];
+                J[1] = -1.0;
+                J[2] = 0;
+                J[3] = -1.0;
+                J[4] = 4.0;
+                J[5] = -1.0;
+                J[6] = 0;
+                J[7] = -1.0;
+                J[8] = 4.0 + 0.6 * X[2] * X[2];
+            }
+            // straight-line LU of tridiagonal matrix as generated with sparse LU
+            void solve(Eigen::Matrix<double, 3, 3>& Jm, Eigen::Matrix<double, 3, 1>& F) const {
+                double* J = Jm.data();
+                J[1] = J[1] / J[0];
+                J[4] = J[4] - J[1] * J[3];
+                J[5] = J[5] / J[4];
+                J[8] = J[8] - J[5] * J[7];
+                F[1] = F[1] - J[1] * F[0];
+                F[2] = F[2] - J[5] * F[1];
+                F[2] = F[2] / J[8];
+                F[1] = F[1] - J[7] * F[2];
+                F[1] = F[1] / J[4];
+                F[0] = F[0] - J[3] * F[1];
+                F[0] = F[0] / J[0];
+            }
+        };
+        Eigen::Matrix<double, 3, 1> X{0.1, 0.2, 0.3};
+        Eigen::Matrix<double, 3, 1> F;
+        Eigen::Matrix<double, 3, 3> J;
+        functor fn;
+        int iter_newton = newton::newton_sparse_solver(X, fn);
+        fn(X, F, J);
+        THEN("find a solution") {
+            CAPTURE(iter_newton);
+            CAPTURE(X);
+            REQUIRE(iter_newton > 0);
+            REQUIRE(F.norm() < max_error_norm);
+        }
+    }
+}
+
+SCENARIO("Convergence statistics of Newton Solver", "[analytic][solver]") {
+    GIVEN("solver calls of two mechanisms recorded from two threads") {
+        struct functor {
+            double a;
+            void operator()(const Eigen::Matrix<double, 1, 1>& X,
+                            Eigen::Matrix<double, 1, 1>& F,
+                            Eigen::Matrix<double, 1, 1>& J) const {
+                F[0] = X[0] * X[0] - a;
+                J[0] = 2.0 * X[0];
+            }
+        };
+        newton::clear_newton_stats();
+        auto solve = [](double a) {
+            auto& stats = newton::thread_newton_stats("sqrt");
+            Eigen::Matrix<double, 1, 1> X{1.0};
+            functor fn{a};
+            int iter_newton = newton::newton_solver(X, fn);
+            stats.record(iter_newton, X, fn);
+            return iter_newton;
+        };
+        int iter_4 = solve(4.0);
+        std::thread([&]() { solve(9.0); }).join();
+        newton::thread_newton_stats("other").record(-1, 1.5);
+        newton::thread_newton_stats("other").record(100, 0.5);
+
+        auto stats = newton::NewtonStatsRegistry::instance().merged();
+        THEN("statistics of all threads are merged per mechanism") {
+            REQUIRE(stats.size() == 2);
+            REQUIRE(stats["sqrt"].calls == 2);
+            REQUIRE(stats["sqrt"].failures == 0);
+            REQUIRE(stats["sqrt"].iterations[iter_4] >= 1);
+            REQUIRE(stats["sqrt"].max_residual < max_error_norm);
+            REQUIRE(stats["other"].calls == 2);
+            REQUIRE(stats["other"].failures == 1);
+            REQUIRE(stats["other"].iterations[newton::NewtonStats::NUM_BINS - 1] == 1);
+            REQUIRE(stats["other"].max_residual == 1.5);
+        }
+        THEN("statistics are written as JSON") {
+            std::ostringstream json;
+            newton::write_newton_stats_json(json);
+            std::ostringstream other;
+            stats["other"].to_json(other);
+            REQUIRE(json.str().find("\"sqrt\": {\"calls\": 2, \"failures\": 0") !=
+                    std::string::npos);
+            REQUIRE(json.str().find("\"other\": " + other.str()) != std::string::npos);
+        }
+    }
+}
+
+SCENARIO("Non-linear system to solve with chord and damped Newton Solvers", "[analytic][solver]") {
+    GIVEN("system of 3 non-linear eqs with tridiagonal Jacobian") {
+        struct functor {
+            void operator()(const Eigen::Matrix<double, 3, 1>& X,
+                            Eigen::Matrix<double, 3, 1>& F,
+                            Eigen::Matrix<double, 3, 3>& Jm) const {
+                double* J = Jm.data();
+                F[0] = 4.0 * X[0] - X[1] + 0.1 * X[0] * X[0] - 1.0;
+                F[1] = -X[0] + 4.0 * X[1] - X[2] - 2.0;
+                F[2] = -X[1] + 4.0 * X[2] + 0.2 * X[2] * X[2] * X[2] - 3.0;
+                J[0] = 4.0 + 0.2 * X[0];
+                J[1] = -1.0;
+                J[2] = 0;
+                J[3] = -1.0;
+                J[4] = 4.0;
+                J[5] = -1.0;
+                J[6] = 0;
+                J[7] = -1.0;
+                J[8] = 4.0 + 0.6 * X[2] * X[2];
+            }
+            // straight-line LU of tridiagonal matrix as generated with sparse LU
+            bool factorize(Eigen::Matrix<double, 3, 3>& Jm) const {
+                double* J = Jm.data();
+                J[1] = J[1] / J[0];
+                J[4] = J[4] - J[1] * J[3];
+                J[5] = J[5] / J[4];
+                J[8] = J[8] - J[5] * J[7];
+                return J[0] != 0 && J[4] != 0 && J[8] != 0;
+            }
+            void substitute(Eigen::Matrix<double, 3, 3>& Jm, Eigen::Matrix<double, 3, 1>& F) const {
+                double* J = Jm.data();
+                F[1] = F[1] - J[1] * F[0];
+                F[2] = F[2] - J[5] * F[1];
+                F[2] = F[2] / J[8];
+                F[1] = F[1] - J[7] * F[2];
+                F[1] = F[1] / J[4];
+                F[0] = F[0] - J[3] * F[1];
+                F[0] = F[0] / J[0];
+            }
+        };
+        Eigen::Matrix<double, 3, 1> F;
+        Eigen::Matrix<double, 3, 3> J;
+        functor fn;
+        Eigen::Matrix<double, 3, 1> X_newton{0.1, 0.2, 0.3};
+        int iter_newton = newton::newton_solver(X_newton, fn);
+        WHEN("using chord method") {
+            Eigen::Matrix<double, 3, 1> X{0.1, 0.2, 0.3};
+            int iter_dense = newton::newton_chord_solver(X, fn);
+            fn(X, F, J);
+            Eigen::Matrix<double, 3, 1> X_sparse{0.1, 0.2, 0.3};
+            int iter_sparse =
+                newton::newton_chord_solver<3, functor, newton::FunctorLU<3>>(X_sparse, fn);
+            THEN("find the same solution as Newton method") {
+                CAPTURE(iter_dense);
+                CAPTURE(X);
+                REQUIRE(iter_dense >= iter_newton);
+                REQUIRE(F.norm() < max_error_norm);
+                REQUIRE(X[0] == Approx(X_newton[0]));
+                REQUIRE(X[2] == Approx(X_newton[2]));
+                REQUIRE(iter_sparse == iter_dense);
+                REQUIRE(X_sparse[1] == Approx(X[1]));
+            }
+        }
+        WHEN("using damped method") {
+            Eigen::Matrix<double, 3, 1> X{0.1, 0.2, 0.3};
+            int iter_dense = newton::newton_damped_solver(X, fn);
+            fn(X, F, J);
+            Eigen::Matrix<double, 3, 1> X_sparse{0.1, 0.2, 0.3};
+            int iter_sparse =
+                newton::newton_damped_solver<3, functor, newton::FunctorLU<3>>(X_sparse, fn);
+            THEN("find the same solution as Newton method") {
+                CAPTURE(iter_dense);
+                CAPTURE(X);
+                REQUIRE(iter_dense == iter_newton);
+                REQUIRE(F.norm() < max_error_norm);
+                REQUIRE(X[1] == Approx(X_newton[1]));
+                REQUIRE(iter_sparse == iter_dense);
+                REQUIRE(X_sparse[2] == Approx(X[2]));
+            }
+        }
+        WHEN("using relative tolerance") {
+            Eigen::Matrix<double, 3, 1> X{0.1, 0.2, 0.3};
+            int iter_rtol = newton::newton_solver(X, fn, 0.0, newton::MAX_ITER, 1e-3);
+            fn(X, F, J);
+            THEN("converge with residual relative to solution") {
+                REQUIRE(iter_rtol > 0);
+                REQUIRE(iter_rtol <= iter_newton);
+                REQUIRE(F.norm() < 1e-3 * X.norm());
+            }
+        }
+    }
+
+    GIVEN("scalar eq where full Newton steps overshoot") {
+        struct functor {
+            void operator()(const Eigen::Matrix<double, 1, 1>& X,
+                            Eigen::Matrix<double, 1, 1>& F,
+                            Eigen::Matrix<double, 1, 1>& J) const {
+                F[0] = std::atan(X[0]);
+                J[0] = 1.0 / (1.0 + X[0] * X[0]);
+            }
+        };
+        functor fn;
+        Eigen::Matrix<double, 1, 1> X{2.0};
+        int iter_damped = newton::newton_damped_solver(X, fn);
+        Eigen::Matrix<double, 1, 1> X_newton{2.0};
+        int iter_newton = newton::newton_solver(X_newton, fn, newton::EPS, 50);
+        THEN("damped method converges where Newton method diverges") {
+            CAPTURE(iter_damped);
+            REQUIRE(iter_damped > 0);
+            REQUIRE(std::abs(X[0]) < max_error_norm);
+            REQUIRE(iter_newton == -1);
+        }
+    }
+
+    GIVEN("system with zero pivot for factorization without pivoting") {
+        struct functor {
+            void operator()(const Eigen::Matrix<double, 2, 1>& X,
+                            Eigen::Matrix<double, 2, 1>& F,
+                            Eigen::Matrix<double, 2, 2>& Jm) const {
+                double* J = Jm.data();
+                F[0] = X[1] - 1.0;
+                F[1] = X[0] + X[1] * X[1] - 3.0;
+                J[0] = 0.0;
+                J[1] = 1.0;
+                J[2] = 1.0;
+                J[3] = 2.0 * X[1];
+            }
+            // straight-line LU as generated with sparse LU, J[0] is zero
+            bool factorize(Eigen::Matrix<double, 2, 2>& Jm) const {
+                double* J = Jm.data();
+                J[1] = J[1] / J[0];
+                J[3] = J[3] - J[1] * J[2];
+                return J[0] != 0 && J[3] != 0;
+            }
+            void substitute(Eigen::Matrix<double, 2, 2>& Jm, Eigen::Matrix<double, 2, 1>& F) const {
+                double* J = Jm.data();
+                F[1] = F[1] - J[1] * F[0];
+                F[1] = F[1] / J[3];
+                F[0] = F[0] - J[2] * F[1];
+                F[0] = F[0] / J[0];
+            }
+        };
+        functor fn;
+        Eigen::Matrix<double, 2, 1> X{0.5, 0.5};
+        int iter_dense = newton::newton_chord_solver(X, fn);
+        Eigen::Matrix<double, 2, 1> X_sparse{0.5, 0.5};
+        int iter_sparse =
+            newton::newton_chord_solver<2, functor, newton::FunctorLU<2>>(X_sparse, fn);
+        THEN("functor factorization falls back to dense LU") {
+            CAPTURE(iter_sparse);
+            REQUIRE(iter_sparse > 0);
+            REQUIRE(iter_sparse == iter_dense);
+            REQUIRE(X_sparse[0] == Approx(2.0));
+            REQUIRE(X_sparse[1] == Approx(1.0));
+        }
+    }
+}
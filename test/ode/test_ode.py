@@ -5,7 +5,17 @@
 # Lesser General Public License. See top-level LICENSE file for details.
 # ***********************************************************************
 
-from nmodl.ode import _make_unique_prefix, differentiate2c, integrate2c
+from nmodl.ode import (
+    _make_unique_prefix,
+    _memo_cache,
+    clear_memo_cache,
+    differentiate2c,
+    integrate2c,
+    load_memo_cache,
+    save_memo_cache,
+    solve_lin_system,
+    solve_ode_batch,
+)
 
 import sympy as sp
 
@@ -144,3 +154,102 @@ def test_integrate2c():
         assert _equivalent(
             integrate2c(f"x'={eq}", "dt", var_list, use_pade_approx=True), f"x = {sol}"
         )
+
+
+def test_solve_ode_batch():
+
+    var_list = ["x", "y", "a", "b"]
+    equations = ["x'=a*x", "y'=a*y+b", "x'=a*/"]
+
+    # cnexp: same solutions as integrate2c, failure of one ODE does not affect others
+    solutions, exception_messages = solve_ode_batch(equations, "cnexp", "dt", var_list)
+    assert _equivalent(solutions[0], "x = x*exp(a*dt)")
+    assert _equivalent(solutions[1], "y = (-b + (a*y + b)*exp(a*dt))/a")
+    assert exception_messages[:2] == ["", ""]
+    assert solutions[2] == ""
+    assert exception_messages[2] != ""
+
+    # euler: forwards Euler timestep for each ODE
+    solutions, exception_messages = solve_ode_batch(equations[:2], "euler", "dt", var_list)
+    assert _equivalent(solutions[0], "x = x + a*x*dt")
+    assert _equivalent(solutions[1], "y = y + (a*y+b)*dt")
+    assert exception_messages == ["", ""]
+
+
+def test_solve_lin_system_unrolled():
+
+    state_vars = ["x0", "x1", "x2", "x3", "x4"]
+    constants = ["a", "b", "c", "d", "x0_old", "x3_old", "x4_old"]
+    equations = [
+        "x0 = a*x1 + x0_old",
+        "x1 = b*(x0 - x1) + 1",
+        "x2 = c*x1 - x3",
+        "x3 = a*x2 + d*x4 + x3_old",
+        "x4 = x0 + x4_old",
+    ]
+    values = {"a": 0.3, "b": 1.7, "c": 0.9, "d": 1.1, "x0_old": 0.5, "x3_old": 2.0, "x4_old": 1.5}
+
+    # reference solution from symbolic gaussian elimination
+    reference = dict(values)
+    code, _ = solve_lin_system(equations, state_vars, constants, set(), small_system=True)
+    for statement in code:
+        exec(statement, reference)
+
+    for do_cse in [False, True]:
+        code, new_local_vars = solve_lin_system(
+            equations, state_vars, constants, set(), do_cse=do_cse, unrolled_elimination=True
+        )
+        # straight-line code that only assigns new local vars and state vars
+        assert all(statement.split(" = ")[0] in new_local_vars + state_vars for statement in code)
+        solution = dict(values)
+        for statement in code:
+            exec(statement, solution)
+        for var in state_vars:
+            assert abs(solution[var] - reference[var]) < 1e-12
+
+    # temporaries avoid names in scope even if solution is memoized
+    _, new_local_vars = solve_lin_system(
+        equations, state_vars, constants + ["elim0"], set(), unrolled_elimination=True
+    )
+    assert "elim0" not in new_local_vars
+
+
+def test_memo_cache(tmp_path):
+
+    clear_memo_cache()
+    # same equation with different whitespace and unused variables in scope
+    sol = integrate2c("m' = (minf-m)/mtau", "dt", ["m", "minf", "mtau"])
+    assert len(_memo_cache) == 1
+    assert integrate2c("m'=(minf - m)/mtau", "dt", ["m", "minf", "mtau", "h", "hinf"]) == sol
+    assert len(_memo_cache) == 1
+    # different options give a different cache entry
+    integrate2c("m' = (minf-m)/mtau", "dt", ["m", "minf", "mtau"], use_pade_approx=True)
+    assert len(_memo_cache) == 2
+
+    # solutions survive save / load round trip
+    filename = str(tmp_path / "memo.pickle")
+    save_memo_cache(filename)
+    clear_memo_cache()
+    assert len(_memo_cache) == 0
+    load_memo_cache(filename)
+    assert len(_memo_cache) == 2
+    assert integrate2c("m' = (minf-m)/mtau", "dt", ["m", "minf", "mtau"]) == sol
+
+    # failures are not written to the file
+    try:
+        integrate2c("x' = ", "dt", ["x"])
+    except Exception:
+        pass
+    assert len(_memo_cache) == 3
+    save_memo_cache(filename)
+    clear_memo_cache()
+    load_memo_cache(filename)
+    assert len(_memo_cache) == 2
+
+    # corrupted file is ignored
+    with open(filename, "wb") as f:
+        f.write(b"corrupted")
+    clear_memo_cache()
+    load_memo_cache(filename)
+    assert len(_memo_cache) == 0
+    clear_memo_cache()
@@ -217,3 +217,51 @@ SCENARIO("Check if a NEURON block is parsed with correct location info in its to
         REQUIRE(ss.str() == "         NEURON at [1.1-5.1] type 303");
     }
 }
+
+//=============================================================================
+// Parsing with nodes allocated from an arena
+//=============================================================================
+
+std::vector<std::string> get_names(nmodl::ast::Ast* node) {
+    std::vector<std::string> names;
+    for (const auto& name: AstLookupVisitor().lookup(node, nmodl::ast::AstNodeType::NAME)) {
+        names.push_back(name->get_node_name());
+    }
+    return names;
+}
+
+SCENARIO("Parse NMODL with nodes allocated from an arena", "[parser][arena]") {
+    GIVEN("A mod file") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX pas
+                RANGE g, e
+            }
+
+            BREAKPOINT {
+                i = g*(v-e)
+            }
+        )";
+
+        THEN("AST is same as with heap allocation and outlives the driver") {
+            std::shared_ptr<nmodl::ast::Program> ast;
+            {
+                nmodl::parser::NmodlDriver driver;
+                driver.set_arena_allocation(true);
+                ast = driver.parse_string(nmodl_text);
+                REQUIRE(driver.get_arena() != nullptr);
+            }
+            nmodl::parser::NmodlDriver driver;
+            auto heap_ast = driver.parse_string(nmodl_text);
+            REQUIRE(driver.get_arena() == nullptr);
+            REQUIRE(get_names(ast.get()) == get_names(heap_ast.get()));
+
+            {
+                nmodl::utils::ArenaScope scope(nullptr);
+                std::shared_ptr<nmodl::ast::Ast> clone(ast->clone());
+                ast.reset();
+                REQUIRE(get_names(clone.get()) == get_names(heap_ast.get()));
+            }
+        }
+    }
+}
@@ -180,6 +180,29 @@ SCENARIO("Symbol table allows operations like insert, lookup") {
                     REQUIRE(table->lookup("beta") != nullptr);
                 }
             }
+            WHEN("renaming the symbol") {
+                table->rename("alpha", "beta");
+                THEN("lookup returns symbol with new name only") {
+                    REQUIRE(table->lookup("alpha") == nullptr);
+                    REQUIRE(table->lookup("beta") == symbol);
+                    REQUIRE(symbol->get_name() == "beta");
+                    REQUIRE(table->symbol_count() == 1);
+                }
+            }
+            WHEN("removing the symbol") {
+                auto next_symbol = std::make_shared<Symbol>("beta", ModToken());
+                table->insert(next_symbol);
+                table->remove("alpha");
+                THEN("lookup does not find removed symbol") {
+                    REQUIRE(table->lookup("alpha") == nullptr);
+                    REQUIRE(table->lookup("beta") == next_symbol);
+                    REQUIRE(table->symbol_count() == 1);
+                }
+                THEN("removed symbol can be inserted again") {
+                    REQUIRE_NOTHROW(table->insert(symbol));
+                    REQUIRE(table->symbol_count() == 2);
+                }
+            }
         }
         WHEN("checked for global variables") {
             table->insert(symbol);
@@ -0,0 +1,157 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#define CATCH_CONFIG_MAIN
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "catch/catch.hpp"
+#include "utils/common_utils.hpp"
+#include "utils/file_cache.hpp"
+
+using namespace nmodl;
+using utils::FileCache;
+
+//=============================================================================
+// Helpers for files in scratch directories
+//=============================================================================
+
+static void write_file(const std::string& filename, const std::string& content) {
+    std::ofstream out(filename);
+    out << content;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in(filename);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+/// new empty directory in the working directory
+static std::string make_scratch_dir(const std::string& prefix) {
+    auto dir = prefix + "_" + utils::generate_random_string(8);
+    REQUIRE(utils::make_path(dir));
+    return dir;
+}
+
+
+SCENARIO("Computing cache keys", "[utils][file_cache]") {
+    const std::string mod_text = "NEURON {\n    SUFFIX hh\n}\n";
+    const std::string options = "codegen datatype=double";
+    const auto key = FileCache::make_key("hh", mod_text, options);
+
+    GIVEN("same inputs") {
+        THEN("key is the same") {
+            REQUIRE(FileCache::make_key("hh", mod_text, options) == key);
+        }
+    }
+
+    GIVEN("mod file text with insignificant changes") {
+        THEN("key is the same") {
+            auto crlf_text = "NEURON {\r\n    SUFFIX hh  \r\n}\r\n";
+            REQUIRE(FileCache::make_key("hh", crlf_text, options) == key);
+        }
+    }
+
+    GIVEN("different mod file text, name or options") {
+        THEN("key changes") {
+            REQUIRE(FileCache::make_key("hh", "NEURON {\n    SUFFIX na\n}\n", options) != key);
+            REQUIRE(FileCache::make_key("na", mod_text, options) != key);
+            REQUIRE(FileCache::make_key("hh", mod_text, "codegen datatype=float") != key);
+        }
+    }
+
+    GIVEN("units file passed as part of options") {
+        auto dir = make_scratch_dir("file_cache_units");
+        auto units_file = dir + "/nrnunits.lib";
+        write_file(units_file, "m\n");
+        auto units_options = options + " units=" + FileCache::hash_file(units_file);
+        auto units_key = FileCache::make_key("hh", mod_text, units_options);
+
+        THEN("key changes with the content of the units file") {
+            write_file(units_file, "m\nkm 1000 m\n");
+            auto changed_options = options + " units=" + FileCache::hash_file(units_file);
+            REQUIRE(FileCache::make_key("hh", mod_text, changed_options) != units_key);
+        }
+
+        std::remove(units_file.c_str());
+        std::remove(dir.c_str());
+    }
+}
+
+
+SCENARIO("Storing and restoring generated files", "[utils][file_cache]") {
+    auto cache_dir = make_scratch_dir("file_cache_entries");
+    auto source_dir = make_scratch_dir("file_cache_source");
+    auto output_dir = make_scratch_dir("file_cache_output");
+    FileCache cache(cache_dir);
+
+    write_file(source_dir + "/hh.cpp", "void nrn_state_hh() {}\n");
+    write_file(source_dir + "/hh.ispc", "export void nrn_state_hh() {}\n");
+    const std::vector<std::string> files = {source_dir + "/hh.cpp", source_dir + "/hh.ispc"};
+    const auto key = FileCache::make_key("hh", "NEURON { SUFFIX hh }", "");
+
+    GIVEN("entry stored for the key") {
+        REQUIRE(cache.store(key, files));
+
+        THEN("files are restored with the same content") {
+            REQUIRE(cache.restore(key, output_dir));
+            REQUIRE(read_file(output_dir + "/hh.cpp") == "void nrn_state_hh() {}\n");
+            REQUIRE(read_file(output_dir + "/hh.ispc") == "export void nrn_state_hh() {}\n");
+        }
+
+        THEN("storing the same key again keeps the existing entry") {
+            REQUIRE_FALSE(cache.store(key, files));
+            REQUIRE(cache.restore(key, output_dir));
+        }
+
+        THEN("other keys are not restored") {
+            auto other_key = FileCache::make_key("hh", "NEURON { SUFFIX hh }", "datatype=float");
+            REQUIRE_FALSE(cache.restore(other_key, output_dir));
+        }
+
+        THEN("entry with missing file is not restored") {
+            std::remove((cache_dir + "/" + key + "/hh.ispc").c_str());
+            REQUIRE_FALSE(cache.restore(key, output_dir));
+        }
+
+        std::remove((cache_dir + "/" + key + "/hh.cpp").c_str());
+        std::remove((cache_dir + "/" + key + "/hh.ispc").c_str());
+        std::remove((cache_dir + "/" + key + "/MANIFEST").c_str());
+        std::remove((cache_dir + "/" + key).c_str());
+    }
+
+    GIVEN("entry directory without manifest, e.g. from an interrupted run") {
+        REQUIRE(utils::make_path(cache_dir + "/" + key));
+        write_file(cache_dir + "/" + key + "/hh.cpp", "void nrn_state_hh() {}\n");
+
+        THEN("entry is not restored") {
+            REQUIRE_FALSE(cache.restore(key, output_dir));
+        }
+
+        std::remove((cache_dir + "/" + key + "/hh.cpp").c_str());
+        std::remove((cache_dir + "/" + key).c_str());
+    }
+
+    GIVEN("file to store that doesn't exist") {
+        THEN("no entry is stored") {
+            REQUIRE_FALSE(cache.store(key, {source_dir + "/missing.cpp"}));
+            REQUIRE_FALSE(cache.restore(key, output_dir));
+        }
+    }
+
+    for (const auto& file: {output_dir + "/hh.cpp", output_dir + "/hh.ispc", files[0], files[1]}) {
+        std::remove(file.c_str());
+    }
+    for (const auto& dir: {cache_dir, source_dir, output_dir}) {
+        std::remove(dir.c_str());
+    }
+}
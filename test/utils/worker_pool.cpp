@@ -0,0 +1,107 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#define CATCH_CONFIG_MAIN
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "utils/worker_pool.hpp"
+
+using namespace nmodl;
+
+static std::vector<std::string> make_items(int count) {
+    std::vector<std::string> items;
+    for (int i = 0; i < count; i++) {
+        items.push_back("mod" + std::to_string(i));
+    }
+    return items;
+}
+
+
+SCENARIO("Processing items with worker threads", "[utils][worker_pool]") {
+    const auto main_thread = std::this_thread::get_id();
+
+    GIVEN("multiple items and jobs") {
+        const auto items = make_items(16);
+        std::mutex mutex;
+        std::map<std::string, int> processed;
+        std::set<std::thread::id> threads;
+        auto process = [&](const std::string& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            processed[item]++;
+            threads.insert(std::this_thread::get_id());
+            return true;
+        };
+
+        THEN("every item is processed exactly once by worker threads") {
+            REQUIRE(utils::use_worker_threads(4, items.size()));
+            REQUIRE(utils::process_in_parallel(items, 4, process));
+            REQUIRE(processed.size() == items.size());
+            for (const auto& entry: processed) {
+                REQUIRE(entry.second == 1);
+            }
+            REQUIRE(threads.count(main_thread) == 0);
+        }
+    }
+
+    GIVEN("single item or single job") {
+        std::set<std::thread::id> threads;
+        auto process = [&](const std::string&) {
+            threads.insert(std::this_thread::get_id());
+            return true;
+        };
+
+        THEN("items are processed in the calling thread") {
+            REQUIRE_FALSE(utils::use_worker_threads(4, 1));
+            REQUIRE_FALSE(utils::use_worker_threads(1, 8));
+            REQUIRE(utils::process_in_parallel(make_items(1), 4, process));
+            REQUIRE(utils::process_in_parallel(make_items(8), 1, process));
+            REQUIRE(threads == std::set<std::thread::id>{main_thread});
+        }
+    }
+
+    GIVEN("processing of one item fails") {
+        const auto items = make_items(16);
+        std::atomic<int> count(0);
+        auto process = [&](const std::string& item) {
+            count++;
+            return item != "mod3";
+        };
+
+        THEN("failure is reported with worker threads") {
+            REQUIRE_FALSE(utils::process_in_parallel(items, 4, process));
+        }
+
+        THEN("no new item is started after the failure") {
+            REQUIRE_FALSE(utils::process_in_parallel(items, 1, process));
+            REQUIRE(count == 4);
+        }
+    }
+
+    GIVEN("processing of items throws exceptions") {
+        const auto items = make_items(16);
+        auto process = [&](const std::string& item) -> bool {
+            if (item == "mod5" || item == "mod9") {
+                throw std::runtime_error("error in " + item);
+            }
+            return true;
+        };
+
+        THEN("exception is re-thrown in the calling thread") {
+            REQUIRE_THROWS_AS(utils::process_in_parallel(items, 4, process), std::runtime_error);
+            REQUIRE_THROWS_WITH(utils::process_in_parallel(items, 1, process), "error in mod5");
+        }
+    }
+}
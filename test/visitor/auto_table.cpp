@@ -0,0 +1,178 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include "catch/catch.hpp"
+
+#include "parser/nmodl_driver.hpp"
+#include "test/utils/test_utils.hpp"
+#include "visitors/auto_table_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+using namespace nmodl;
+using namespace visitor;
+using namespace test_utils;
+
+using ast::AstNodeType;
+using nmodl::parser::NmodlDriver;
+
+//=============================================================================
+// AutoTable visitor tests
+//=============================================================================
+
+std::vector<std::shared_ptr<ast::TableStatement>> run_auto_table_visitor(const std::string& text,
+                                                                         double cost_threshold,
+                                                                         double error_bound) {
+    NmodlDriver driver;
+    auto ast = driver.parse_string(text);
+    SymtabVisitor().visit_program(ast.get());
+    AutoTableVisitor(cost_threshold, error_bound).visit_program(ast.get());
+    SymtabVisitor(true).visit_program(ast.get());
+
+    std::vector<std::shared_ptr<ast::TableStatement>> tables;
+    for (const auto& node: AstLookupVisitor().lookup(ast.get(), AstNodeType::TABLE_STATEMENT)) {
+        tables.push_back(std::dynamic_pointer_cast<ast::TableStatement>(node));
+    }
+    return tables;
+}
+
+
+SCENARIO("Adding TABLE statements to rate procedures", "[visitor][auto_table]") {
+    GIVEN("Rate procedure of Hodgkin-Huxley sodium channel") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX na
+                RANGE minf, mtau
+            }
+
+            PARAMETER {
+                celsius = 6.3 (degC)
+                gnabar = 0.12 (S/cm2)
+            }
+
+            ASSIGNED {
+                minf
+                mtau (ms)
+            }
+
+            PROCEDURE rates(v(mV)) {
+                LOCAL alpha, beta, q10
+                q10 = 3^((celsius - 6.3)/10)
+                alpha = 0.1 * vtrap(-(v+40), 10)
+                beta = 4 * exp(-(v+65)/18)
+                mtau = 1/(q10*(alpha + beta))
+                minf = alpha/(alpha + beta)
+            }
+
+            FUNCTION vtrap(x, y) {
+                IF (fabs(x/y) < 1e-6) {
+                    vtrap = y*(1 - x/y/2)
+                } ELSE {
+                    vtrap = x/(exp(x/y) - 1)
+                }
+            }
+        )";
+
+        THEN("Table over table variables and DEPEND on celsius is added") {
+            auto tables = run_auto_table_visitor(nmodl_text, 50., 1e-4);
+            REQUIRE(tables.size() == 1);
+            REQUIRE(to_nmodl(tables[0].get()).find("TABLE mtau, minf DEPEND celsius FROM -100 "
+                                                   "TO 100 WITH") == 0);
+        }
+
+        THEN("Smaller error bound needs more table intervals") {
+            auto coarse = run_auto_table_visitor(nmodl_text, 50., 1e-3);
+            auto fine = run_auto_table_visitor(nmodl_text, 50., 1e-5);
+            REQUIRE(coarse.size() == 1);
+            REQUIRE(fine.size() == 1);
+            auto coarse_intervals = coarse[0]->get_with()->eval();
+            auto fine_intervals = fine[0]->get_with()->eval();
+            REQUIRE(coarse_intervals >= 20);
+            REQUIRE(fine_intervals > 3 * coarse_intervals);
+        }
+
+        THEN("Procedure below cost threshold is not tabulated") {
+            auto tables = run_auto_table_visitor(nmodl_text, 1000., 1e-4);
+            REQUIRE(tables.empty());
+        }
+    }
+
+    GIVEN("Rate procedure depending on RANGE parameter") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                RANGE vhalf, minf
+            }
+
+            PARAMETER {
+                vhalf = -40 (mV)
+            }
+
+            ASSIGNED {
+                minf
+            }
+
+            PROCEDURE rates(v(mV)) {
+                minf = 1/(1 + exp(-(v - vhalf)/5)) + exp(v/20) + exp(v/30) + exp(v/40)
+            }
+        )";
+
+        THEN("Table is not added") {
+            auto tables = run_auto_table_visitor(nmodl_text, 10., 1e-4);
+            REQUIRE(tables.empty());
+        }
+    }
+
+    GIVEN("Rate procedure defining variable conditionally") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                RANGE minf
+            }
+
+            ASSIGNED {
+                minf
+            }
+
+            PROCEDURE rates(v(mV)) {
+                IF (v > 0) {
+                    minf = exp(v/10) + exp(v/20) + exp(v/30)
+                }
+            }
+        )";
+
+        THEN("Table is not added") {
+            auto tables = run_auto_table_visitor(nmodl_text, 10., 1e-4);
+            REQUIRE(tables.empty());
+        }
+    }
+
+    GIVEN("Procedure with existing TABLE statement") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                RANGE minf
+            }
+
+            ASSIGNED {
+                minf
+            }
+
+            PROCEDURE rates(v(mV)) {
+                TABLE minf FROM -50 TO 50 WITH 100
+                minf = exp(v/10) + exp(v/20) + exp(v/30)
+            }
+        )";
+
+        THEN("Existing table is kept") {
+            auto tables = run_auto_table_visitor(nmodl_text, 10., 1e-4);
+            REQUIRE(tables.size() == 1);
+            REQUIRE(tables[0]->get_with()->eval() == 100);
+        }
+    }
+}
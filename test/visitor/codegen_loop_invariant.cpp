@@ -0,0 +1,208 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include "catch/catch.hpp"
+
+#include "codegen/codegen_c_visitor.hpp"
+#include "codegen/codegen_loop_invariant_visitor.hpp"
+#include "parser/nmodl_driver.hpp"
+#include "test/utils/test_utils.hpp"
+#include "visitors/lookup_visitor.hpp"
+#include "visitors/perf_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+using namespace nmodl;
+using namespace visitor;
+using namespace test_utils;
+
+using ast::AstNodeType;
+using nmodl::parser::NmodlDriver;
+
+//=============================================================================
+// Loop invariant visitor tests
+//=============================================================================
+
+std::vector<std::string> run_loop_invariant_visitor(const std::string& text) {
+    NmodlDriver driver;
+    auto ast = driver.parse_string(text);
+    SymtabVisitor().visit_program(ast.get());
+    PerfVisitor().visit_program(ast.get());
+
+    std::vector<std::string> results;
+    auto blocks = AstLookupVisitor().lookup(ast.get(), AstNodeType::BREAKPOINT_BLOCK);
+    for (const auto& expression: codegen::CodegenLoopInvariantVisitor().find_invariants(
+             blocks.front().get(), ast->get_symbol_table())) {
+        results.push_back(to_nmodl(expression.get()));
+    }
+    return results;
+}
+
+
+SCENARIO("Finding loop invariant expressions", "[visitor][loop_invariant]") {
+    GIVEN("Expressions of celsius and voltage") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                NONSPECIFIC_CURRENT il
+                RANGE gl, el
+            }
+            PARAMETER {
+                celsius = 6.3 (degC)
+                gl = 0.001
+                el = -65
+            }
+            ASSIGNED {
+                v
+                il
+            }
+            BREAKPOINT {
+                il = gl*(v-el)*exp(celsius/10)+exp(v/10)
+            }
+        )";
+        THEN("only the expression of celsius is hoisted") {
+            auto invariants = run_loop_invariant_visitor(nmodl_text);
+            REQUIRE(invariants == std::vector<std::string>{"exp(celsius/10)"});
+        }
+    }
+
+    GIVEN("Global variables that are read or written") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                NONSPECIFIC_CURRENT il
+                GLOBAL q10, tadj
+            }
+            PARAMETER {
+                q10 = 3
+                tadj = 1
+            }
+            ASSIGNED {
+                v
+                il
+            }
+            INITIAL {
+                tadj = q10^((celsius-6.3)/10)
+            }
+            BREAKPOINT {
+                il = (v+65)*tadj*q10^(celsius/10)
+            }
+        )";
+        THEN("expressions of written globals are not hoisted") {
+            auto invariants = run_loop_invariant_visitor(nmodl_text);
+            REQUIRE(invariants == std::vector<std::string>{"q10^(celsius/10)"});
+        }
+    }
+
+    GIVEN("LOCAL variable shadowing a global variable") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                NONSPECIFIC_CURRENT il
+                GLOBAL q10
+            }
+            PARAMETER {
+                q10 = 3
+            }
+            ASSIGNED {
+                v
+                il
+            }
+            BREAKPOINT {
+                LOCAL q10
+                q10 = v/10
+                il = (v+65)*exp(q10*celsius)
+            }
+        )";
+        THEN("expressions of the LOCAL variable are not hoisted") {
+            auto invariants = run_loop_invariant_visitor(nmodl_text);
+            REQUIRE(invariants.empty());
+        }
+    }
+
+    GIVEN("Calls to math functions and user FUNCTIONs") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                NONSPECIFIC_CURRENT il
+            }
+            ASSIGNED {
+                v
+                il
+            }
+            BREAKPOINT {
+                il = (v+65)*exp(celsius/10)*rate(celsius)
+            }
+            FUNCTION rate(x) {
+                rate = x/10
+            }
+        )";
+        THEN("only math function calls are hoisted") {
+            auto invariants = run_loop_invariant_visitor(nmodl_text);
+            REQUIRE(invariants == std::vector<std::string>{"exp(celsius/10)"});
+        }
+    }
+
+    GIVEN("Block with VERBATIM code") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                NONSPECIFIC_CURRENT il
+            }
+            ASSIGNED {
+                v
+                il
+            }
+            BREAKPOINT {
+                il = (v+65)*exp(celsius/10)
+                VERBATIM
+                    celsius = 37;
+                ENDVERBATIM
+            }
+        )";
+        THEN("nothing is hoisted") {
+            auto invariants = run_loop_invariant_visitor(nmodl_text);
+            REQUIRE(invariants.empty());
+        }
+    }
+}
+
+
+SCENARIO("Naming hoisted loop invariants", "[codegen][loop_invariant]") {
+    GIVEN("BREAKPOINT block with LOCAL variable named like a hoisted invariant") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX leak
+                RANGE x
+            }
+            ASSIGNED {
+                v
+                x
+            }
+            BREAKPOINT {
+                LOCAL inv0
+                inv0 = v+65
+                x = inv0*exp(celsius/10)
+            }
+        )";
+        THEN("the invariant gets a name that is not used in the block") {
+            // without currents the BREAKPOINT block is printed in the loop of nrn_state
+            NmodlDriver driver;
+            auto ast = driver.parse_string(nmodl_text);
+            SymtabVisitor().visit_program(ast.get());
+            PerfVisitor().visit_program(ast.get());
+
+            std::stringstream stream;
+            codegen::CodegenCVisitor visitor("leak", stream, codegen::LayoutType::soa, "double");
+            visitor.set_hoist_invariants(true);
+            visitor.visit_program(ast.get());
+            auto code = stream.str();
+            REQUIRE(code.find("double inv1 = exp(") != std::string::npos);
+            REQUIRE(code.find("inv0 = exp(") == std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include "catch/catch.hpp"
+
+#include "parser/nmodl_driver.hpp"
+#include "test/utils/test_utils.hpp"
+#include "visitors/compact_storage_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
+
+using namespace nmodl;
+using namespace visitor;
+using namespace test_utils;
+
+using nmodl::parser::NmodlDriver;
+
+//=============================================================================
+// CompactStorage visitor tests
+//=============================================================================
+
+std::set<std::string> run_compact_storage_visitor(const std::string& text, std::string& nmodl) {
+    NmodlDriver driver;
+    auto ast = driver.parse_string(text);
+    SymtabVisitor().visit_program(ast.get());
+    CompactStorageVisitor v;
+    v.visit_program(ast.get());
+    SymtabVisitor(true).visit_program(ast.get());
+    nmodl = to_nmodl(ast.get());
+    return v.get_compacted_variables();
+}
+
+
+SCENARIO("Compacting storage of ASSIGNED variables", "[visitor][compact_storage]") {
+    GIVEN("Conductance computed and used in BREAKPOINT block") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                USEION na READ ena WRITE ina
+                RANGE gbar, g, unused
+            }
+
+            PARAMETER {
+                gbar = 0.12
+            }
+
+            STATE {
+                m
+            }
+
+            ASSIGNED {
+                v
+                ena
+                ina
+                g
+                unused
+                minf
+            }
+
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+                g = gbar*m*m*m
+                ina = g*(v-ena)
+            }
+
+            DERIVATIVE states {
+                minf = 1/(1+exp(-v/10))
+                m' = minf-m
+            }
+        )";
+
+        THEN("Temporaries and unused variables are demoted and declarations removed") {
+            std::string nmodl;
+            auto compacted = run_compact_storage_visitor(nmodl_text, nmodl);
+            REQUIRE(compacted == std::set<std::string>{"g", "minf", "unused"});
+            REQUIRE(nmodl.find("RANGE gbar\n") != std::string::npos);
+            REQUIRE(nmodl.find("unused") == std::string::npos);
+            REQUIRE(nmodl.find("LOCAL g\n") != std::string::npos);
+            REQUIRE(nmodl.find("LOCAL minf\n") != std::string::npos);
+        }
+    }
+
+    GIVEN("Variables carried between blocks or used outside of global blocks") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                RANGE a, b, c, d, e
+            }
+
+            ASSIGNED {
+                a
+                b
+                c
+                d
+                e
+            }
+
+            INITIAL {
+                a = 1
+                b = 2
+                d = 3
+                e = 4
+            }
+
+            BREAKPOINT {
+                b = b+a
+                c = f()
+                CONDUCTANCE d
+            }
+
+            FUNCTION f() {
+                f = c+1
+            }
+
+            VERBATIM
+            double get_e() { return _p_e; }
+            ENDVERBATIM
+        )";
+
+        THEN("No variable is compacted") {
+            std::string nmodl;
+            auto compacted = run_compact_storage_visitor(nmodl_text, nmodl);
+            REQUIRE(compacted.empty());
+            REQUIRE(nmodl.find("RANGE a, b, c, d, e") != std::string::npos);
+        }
+    }
+
+    GIVEN("Variable only written in a procedure") {
+        std::string nmodl_text = R"(
+            NEURON {
+                SUFFIX hh
+                RANGE tau
+            }
+
+            ASSIGNED {
+                tau
+            }
+
+            BREAKPOINT {
+                rates(1)
+            }
+
+            PROCEDURE rates(x) {
+                tau = 2*x
+            }
+        )";
+
+        THEN("Variable becomes local of the procedure and RANGE statement is removed") {
+            std::string nmodl;
+            auto compacted = run_compact_storage_visitor(nmodl_text, nmodl);
+            REQUIRE(compacted == std::set<std::string>{"tau"});
+            REQUIRE(nmodl.find("RANGE") == std::string::npos);
+            REQUIRE(nmodl.find("LOCAL tau\n") != std::string::npos);
+        }
+    }
+}
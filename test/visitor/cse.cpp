@@ -0,0 +1,118 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include "catch/catch.hpp"
+
+#include "parser/nmodl_driver.hpp"
+#include "test/utils/test_utils.hpp"
+#include "visitors/cse_visitor.hpp"
+#include "visitors/nmodl_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
+
+using namespace nmodl;
+using namespace visitor;
+using namespace test_utils;
+
+using nmodl::parser::NmodlDriver;
+
+//=============================================================================
+// Common subexpression elimination visitor tests
+//=============================================================================
+
+std::string run_cse_visitor(const std::string& text) {
+    NmodlDriver driver;
+    auto ast = driver.parse_string(text);
+    SymtabVisitor().visit_program(ast.get());
+    CseVisitor().visit_program(ast.get());
+
+    std::stringstream stream;
+    NmodlPrintVisitor(stream).visit_program(ast.get());
+    return stream.str();
+}
+
+
+SCENARIO("Common subexpression elimination", "[visitor][cse]") {
+    GIVEN("Rate expressions repeated in a block") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                minf = 1/(1+exp(-(v-vhalf)/k))
+                mtau = tau0*exp(-(v-vhalf)/k)
+            }
+        )";
+
+        std::string output_nmodl = R"(
+            BREAKPOINT {
+                LOCAL cse_0
+                cse_0 = exp(-(v-vhalf)/k)
+                minf = 1/(1+cse_0)
+                mtau = tau0*cse_0
+            }
+        )";
+
+        THEN("Largest common subexpression is evaluated once into LOCAL variable") {
+            std::string input = reindent_text(nmodl_text);
+            auto expected_result = reindent_text(output_nmodl);
+            auto result = run_cse_visitor(input);
+            REQUIRE(result == expected_result);
+        }
+    }
+
+    GIVEN("Assignment to variable of subexpression in between") {
+        std::string nmodl_text = R"(
+            PROCEDURE rates(x) {
+                a = exp(x/k)
+                x = 2
+                b = exp(x/k)+1
+                c = exp(x/k)*2
+            }
+        )";
+
+        std::string output_nmodl = R"(
+            PROCEDURE rates(x) {
+                LOCAL cse_0
+                a = exp(x/k)
+                x = 2
+                cse_0 = exp(x/k)
+                b = cse_0+1
+                c = cse_0*2
+            }
+        )";
+
+        THEN("Only occurrences after the assignment are replaced") {
+            std::string input = reindent_text(nmodl_text);
+            auto expected_result = reindent_text(output_nmodl);
+            auto result = run_cse_visitor(input);
+            REQUIRE(result == expected_result);
+        }
+    }
+
+    GIVEN("Calls with side effects and differential equations") {
+        std::string nmodl_text = R"(
+            INITIAL {
+                a = exp(v)
+                rates(v)
+                b = exp(v)
+            }
+
+            DERIVATIVE states {
+                a = f(v)*2
+                b = f(v)*3
+                m' = (exp(v)-m)/exp(v)
+            }
+
+            FUNCTION f(x) {
+                f = x
+            }
+        )";
+
+        THEN("Nothing is replaced") {
+            std::string input = reindent_text(nmodl_text);
+            auto result = run_cse_visitor(input);
+            REQUIRE(result == input);
+        }
+    }
+}
@@ -319,4 +319,40 @@ SCENARIO("Perform DefUse analysis on NMODL constructs") {
             REQUIRE(chains[0].eval() == DUState::U);
         }
     }
+
+    GIVEN("usage of several variables analysed in a single traversal") {
+        std::string nmodl_text = R"(
+            NEURON {
+                RANGE tau, beta, alpha
+            }
+
+            DERIVATIVE states {
+                tau = 1
+                IF (tau > 0) {
+                    alpha = beta
+                } ELSE {
+                    alpha = 2
+                }
+                beta = alpha
+            }
+        )";
+
+        THEN("Chains and effective usages are same as for individual variables") {
+            std::string input = reindent_text(nmodl_text);
+            NmodlDriver driver;
+            auto ast = driver.parse_string(input);
+            SymtabVisitor().visit_program(ast.get());
+            auto block = AstLookupVisitor().lookup(ast.get(), AstNodeType::DERIVATIVE_BLOCK)[0];
+            auto chains = DefUseAnalyzeVisitor(ast->get_symbol_table()).analyze_all(block.get());
+
+            REQUIRE(chains.eval("tau") == DUState::D);
+            REQUIRE(chains.eval("alpha") == DUState::D);
+            REQUIRE(chains.eval("beta") == DUState::U);
+            REQUIRE(chains.eval("gamma") == DUState::NONE);
+            for (const auto& variable: {"tau", "alpha", "beta"}) {
+                auto chain = run_defuse_visitor(input, variable)[0];
+                REQUIRE(chains.get_chain(variable).to_string() == chain.to_string());
+            }
+        }
+    }
 }
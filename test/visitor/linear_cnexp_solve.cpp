@@ -0,0 +1,231 @@
+/*************************************************************************
+ * Copyright (C) 2018-2019 Blue Brain Project
+ *
+ * This file is part of NMODL distributed under the terms of the GNU
+ * Lesser General Public License. See top-level LICENSE file for details.
+ *************************************************************************/
+
+#include "catch/catch.hpp"
+
+#include "parser/nmodl_driver.hpp"
+#include "test/utils/test_utils.hpp"
+#include "visitors/linear_cnexp_solve_visitor.hpp"
+#include "visitors/nmodl_visitor.hpp"
+#include "visitors/symtab_visitor.hpp"
+
+using namespace nmodl;
+using namespace visitor;
+using namespace test_utils;
+
+using nmodl::parser::NmodlDriver;
+
+
+//=============================================================================
+// LinearCnexpSolve visitor tests
+//=============================================================================
+
+std::string run_linear_cnexp_solve_visitor(const std::string& text) {
+    NmodlDriver driver;
+    auto ast = driver.parse_string(text);
+
+    SymtabVisitor().visit_program(ast.get());
+    LinearCnexpSolveVisitor().visit_program(ast.get());
+    std::stringstream stream;
+    NmodlPrintVisitor(stream).visit_program(ast.get());
+    return stream.str();
+}
+
+
+SCENARIO("LinearCnexpSolveVisitor solves linear ODEs analytically") {
+    GIVEN("Derivative block with linear ODEs and cnexp method") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = (mInf-m)/mTau
+                h' = hInf/hTau-h/hTau
+                x' = a*x+b
+                y' = -y/tau
+                z' = k
+                X'[1] = (a-X[1])/b
+            }
+        )";
+
+        std::string output_nmodl = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m = mInf+(m-mInf)*exp(-dt/mTau)
+                h = hInf+(h-hInf)*exp(-dt/hTau)
+                x = -(b/a)+(x+b/a)*exp(dt*a)
+                y = y*exp(-dt/tau)
+                z = z+dt*k
+                X[1] = a+(X[1]-a)*exp(-dt/b)
+            }
+        )";
+
+        THEN("ODEs get replaced with exact solution") {
+            std::string input = reindent_text(nmodl_text);
+            auto expected_result = reindent_text(output_nmodl);
+            auto result = run_linear_cnexp_solve_visitor(input);
+            REQUIRE(result == expected_result);
+        }
+    }
+
+    GIVEN("Derivative block with non-linear ODEs and cnexp method") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = m*m
+                n' = exp(n)
+                X'[0] = X[1]-X[0]
+                h' = (hInf-h)/hTau
+            }
+        )";
+
+        std::string output_nmodl = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = m*m
+                n' = exp(n)
+                X'[0] = X[1]-X[0]
+                h = hInf+(h-hInf)*exp(-dt/hTau)
+            }
+        )";
+
+        THEN("Only linear ODEs get solved, others are left for other solvers") {
+            std::string input = reindent_text(nmodl_text);
+            auto expected_result = reindent_text(output_nmodl);
+            auto result = run_linear_cnexp_solve_visitor(input);
+            REQUIRE(result == expected_result);
+        }
+    }
+
+    GIVEN("Derivative block with non-cnexp method") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD derivimplicit
+            }
+
+            DERIVATIVE states {
+                m' = (mInf-m)/mTau
+            }
+        )";
+
+        THEN("ODEs don't get solved") {
+            std::string input = reindent_text(nmodl_text);
+            auto result = run_linear_cnexp_solve_visitor(input);
+            REQUIRE(result == input);
+        }
+    }
+
+    GIVEN("Derivative block with calls to math functions and FUNCTIONs") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = (exp(-v/10)-m)/mTau
+                h' = (hInf(v)-h)/hTau
+            }
+
+            FUNCTION hInf(v) {
+                hInf = 1-h
+            }
+        )";
+
+        std::string output_nmodl = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m = exp(-v/10)+(m-exp(-v/10))*exp(-dt/mTau)
+                h' = (hInf(v)-h)/hTau
+            }
+
+            FUNCTION hInf(v) {
+                hInf = 1-h
+            }
+        )";
+
+        THEN("ODEs calling FUNCTIONs that may read the state are left for other solvers") {
+            std::string input = reindent_text(nmodl_text);
+            auto expected_result = reindent_text(output_nmodl);
+            auto result = run_linear_cnexp_solve_visitor(input);
+            REQUIRE(result == expected_result);
+        }
+    }
+}
+
+
+SCENARIO("LinearCnexpSolveVisitor reports if equations are left for SymPy") {
+    auto has_unsolved_equations = [](const std::string& text) {
+        NmodlDriver driver;
+        auto ast = driver.parse_string(text);
+        SymtabVisitor().visit_program(ast.get());
+        LinearCnexpSolveVisitor().visit_program(ast.get());
+        return LinearCnexpSolveVisitor::has_unsolved_equations(ast.get());
+    };
+
+    GIVEN("Derivative block with only linear ODEs") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = (mInf-m)/mTau
+            }
+        )";
+
+        THEN("all equations are solved") {
+            REQUIRE_FALSE(has_unsolved_equations(nmodl_text));
+        }
+    }
+
+    GIVEN("Derivative block with non-linear ODE") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE states METHOD cnexp
+            }
+
+            DERIVATIVE states {
+                m' = (mInf-m)/mTau
+                n' = n*n
+            }
+        )";
+
+        THEN("equations are left") {
+            REQUIRE(has_unsolved_equations(nmodl_text));
+        }
+    }
+
+    GIVEN("LINEAR block") {
+        std::string nmodl_text = R"(
+            BREAKPOINT {
+                SOLVE lin
+            }
+
+            LINEAR lin {
+                ~ x + y = 1
+                ~ x - y = 0
+            }
+        )";
+
+        THEN("equations are left") {
+            REQUIRE(has_unsolved_equations(nmodl_text));
+        }
+    }
+}
@@ -9,9 +9,13 @@
 
 #include "parser/nmodl_driver.hpp"
 #include "test/utils/test_utils.hpp"
+#include "visitors/cse_visitor.hpp"
 #include "visitors/inline_visitor.hpp"
+#include "visitors/local_var_rename_visitor.hpp"
 #include "visitors/localize_visitor.hpp"
+#include "visitors/lookup_visitor.hpp"
 #include "visitors/symtab_visitor.hpp"
+#include "visitors/visitor_utils.hpp"
 
 using namespace nmodl;
 using namespace visitor;
@@ -94,3 +98,120 @@ SCENARIO("Sympy specific AST to NMODL conversion") {
         }
     }
 }
+
+//=============================================================================
+// Typed construction of AST nodes
+//=============================================================================
+
+SCENARIO("Creating AST nodes without parsing") {
+    GIVEN("Statements built with typed construction functions") {
+        auto exp_call = create_function_call("exp", {create_var_name("v")});
+        auto sum = create_binary_expression(create_double(1), ast::BOP_ADDITION, exp_call);
+        auto rhs = create_binary_expression(create_var_name("g"),
+                                            ast::BOP_MULTIPLICATION,
+                                            create_paren_expression(sum));
+        auto statement = create_assignment(create_var_name("m", 2), rhs);
+
+        THEN("Statement is same as parsed statement") {
+            auto parsed = create_statement("m[2] = g*(1+exp(v))");
+            REQUIRE(to_nmodl(statement.get()) == to_nmodl(parsed.get()));
+            REQUIRE(statement->get_expression()->is_binary_expression());
+        }
+    }
+
+    GIVEN("Several statements in string format") {
+        auto statements = create_statements({"a = 1", "b = a+2", "c = b*a"});
+
+        THEN("Statements are created with a single parse") {
+            REQUIRE(statements.size() == 3);
+            REQUIRE(to_nmodl(statements[2].get()) == "c = b*a");
+        }
+    }
+}
+
+//=============================================================================
+// Passes update symbol table incrementally
+//=============================================================================
+
+SCENARIO("Passes update symbol table without rebuild", "[visitor][symtab]") {
+    GIVEN("A mod file with range variable and common subexpressions") {
+        std::string nmodl_text = R"(
+            NEURON {
+                RANGE tau, x
+            }
+
+            ASSIGNED {
+                x
+            }
+
+            BREAKPOINT {
+                LOCAL tau
+                x = exp(v/tau)
+                tau = 2*exp(v/tau)
+            }
+        )";
+
+        NmodlDriver driver;
+        auto ast = driver.parse_string(nmodl_text);
+        SymtabVisitor().visit_program(ast.get());
+        LocalizeVisitor().visit_program(ast.get());
+        LocalVarRenameVisitor().visit_program(ast.get());
+        CseVisitor().visit_program(ast.get());
+
+        THEN("Rebuild does not find missing symbols") {
+            auto breakpoint = AstLookupVisitor().lookup(ast.get(), AstNodeType::BREAKPOINT_BLOCK);
+            auto block = std::static_pointer_cast<ast::BreakpointBlock>(breakpoint[0]);
+            auto symtab = block->get_statement_block()->get_symbol_table();
+            REQUIRE(symtab->lookup("cse_0") != nullptr);
+            REQUIRE(symtab->lookup("tau_r_0") != nullptr);
+            REQUIRE(symtab->lookup("tau") == nullptr);
+            REQUIRE(verify_symbol_table(ast.get()).empty());
+        }
+
+        THEN("Rebuild finds variable not added to symbol table") {
+            auto breakpoint = AstLookupVisitor().lookup(ast.get(), AstNodeType::BREAKPOINT_BLOCK);
+            auto block = std::static_pointer_cast<ast::BreakpointBlock>(breakpoint[0]);
+            auto variables = get_local_variables(block->get_statement_block().get());
+            auto name = std::make_shared<ast::Name>(new ast::String("y"));
+            variables->push_back(std::make_shared<ast::LocalVar>(name));
+            auto missing = verify_symbol_table(ast.get());
+            REQUIRE(missing.size() == 1);
+            REQUIRE(missing[0].find("::y") != std::string::npos);
+        }
+    }
+
+    GIVEN("A procedure with LOCAL shadowing a global variable inlined in BREAKPOINT") {
+        std::string nmodl_text = R"(
+            NEURON {
+                RANGE tau
+            }
+
+            PARAMETER {
+                tau = 1
+            }
+
+            PROCEDURE rates() {
+                LOCAL tau
+                tau = 2
+            }
+
+            BREAKPOINT {
+                rates()
+            }
+        )";
+
+        NmodlDriver driver;
+        auto ast = driver.parse_string(nmodl_text);
+        SymtabVisitor().visit_program(ast.get());
+        InlineVisitor().visit_program(ast.get());
+        SymtabVisitor(true).visit_program(ast.get());
+        LocalVarRenameVisitor().visit_program(ast.get());
+
+        THEN("Only LOCAL symbols are renamed") {
+            auto symbol = ast->get_symbol_table()->lookup("tau");
+            REQUIRE(symbol != nullptr);
+            REQUIRE(symbol->has_any_property(symtab::syminfo::NmodlType::range_var));
+            REQUIRE(verify_symbol_table(ast.get()).empty());
+        }
+    }
+}